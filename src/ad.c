@@ -28,6 +28,8 @@
 #include "ad.h"
 #include "color.h"
 #include "options.h"
+#include "output.h"
+#include "parallel.h"
 #include "util.h"
 
 /// @cond DOXYGEN_IGNORE
@@ -41,11 +43,27 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 // extern function declarations
+void aggregate_file( void );
+void bit_errors_file( void );
+void cache_run( void );
+void compress_cleanup( void );
+void compress_finish( void );
+void compress_init( void );
 void dump_file( void );
 void dump_file_c( void );
+void dump_file_sampled( void );
+void image_file( void );
+void index_files( void );
+void narrow_file( void );
+void profile_calibrate( void );
+void record_align( void );
+void record_report( void );
+void replace_file( void );
 void reverse_dump_file( void );
+void verify_dump_file( void );
 
 // extern variable definitions
+FILE       *fin;
 off_t       fin_offset;
 char const *fin_path = "-";
 char const *me;
@@ -55,10 +73,16 @@ unsigned    row_bytes = ROW_BYTES_DEFAULT;
 
 /**
  * Cleans up by doing:
+ *  + Finishing compressed output, if any, if exiting early.
+ *  + Releasing unused reserved output space, if any.
+ *  + Stopping parallel worker threads.
  *  + Freeing dynamicaly allocated memory.
  * This function is called via \c atexit().
  */
 static void ad_cleanup( void ) {
+  compress_cleanup();
+  output_cleanup();
+  par_cleanup();
   free_now();
 }
 
@@ -73,16 +97,48 @@ static void ad_cleanup( void ) {
  */
 int main( int argc, char const *argv[const] ) {
   me = base_name( argv[0] );
+  fin = stdin;
+  fout = stdout;
   ATEXIT( ad_cleanup );
   options_init( argc, argv );
   colors_init();
+  if ( opt_cache != CACHE_NONE )
+    cache_run();
+  if ( opt_output_compress > 0 )
+    compress_init();
+  output_init();
 
-  if ( opt_c_array != C_ARRAY_NONE )
+  if ( opt_calibrate_dir != NULL )
+    profile_calibrate();
+  else if ( opt_index_path != NULL )
+    index_files();
+  else if ( opt_aggregate != AGGREGATE_NONE )
+    aggregate_file();
+  else if ( opt_image != IMAGE_NONE )
+    image_file();
+  else if ( opt_narrow != NARROW_NONE )
+    narrow_file();
+  else if ( opt_c_array != C_ARRAY_NONE )
     dump_file_c();
+  else if ( opt_verify_path != NULL )
+    verify_dump_file();
+  else if ( opt_replace_buf != NULL )
+    replace_file();
   else if ( opt_reverse )
     reverse_dump_file();
-  else
+  else if ( opt_record == RECORD_REPORT )
+    record_report();
+  else if ( opt_sample > 0 )
+    dump_file_sampled();
+  else if ( opt_bit_errors )
+    bit_errors_file();
+  else {
+    if ( opt_record == RECORD_DUMP )
+      record_align();
     dump_file();
+  }
+
+  compress_finish();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -35,14 +35,23 @@
 
 ///////////////////////////////////////////////////////////////////////////////
 
+#define BIT_ERRORS_BLOCK_DEFAULT  4096u /**< Bytes per bit-error block. */
 #define ELIDED_SEP_CHAR           '-'   /**< Elided row separator character. */
 #define EX_NO_MATCHES             1     /**< Exit status for no matches. */
+#define EX_VERIFY_FAILED          1     /**< Exit status for mismatches. */
 #define GROUP_BY_DEFAULT          2     /**< Bytes to group together. */
+#define IMAGE_HEIGHT_MAX          4096u /**< Maximum image height. */
+#define IMAGE_WIDTH_DEFAULT       256u  /**< Default image width. */
+#define IMAGE_WIDTH_MAX           16384u/**< Maximum image width. */
+#define JOBS_MAX                  1024u /**< Maximum parallel jobs. */
+#define OUTPUT_COMPRESS_DEFAULT   6     /**< Default compression level. */
 #define OFFSET_WIDTH_MIN          12    /**< Minimum offset digits. */
 #define OFFSET_WIDTH_MAX          16    /**< Maximum offset digits. */
 #define ROW_BYTES_DEFAULT         16    /**< Default bytes dumped on a row. */
 #define ROW_BYTES_C               8     /**< Bytes dumped on a row in C. */
-#define ROW_BYTES_MAX             32    /**< Maximum bytes dumped on a row. */
+#define ROW_BYTES_MAX             64    /**< Maximum bytes dumped on a row. */
+#define ROW_BYTES_PLAIN           32    /**< Bytes dumped on a row if plain. */
+#define SAMPLE_BLOCK_ROWS         256   /**< Rows per sampled block. */
 #define STRINGS_LEN_DEFAULT       4     /**< Default **strings**(1) length. */
 
 /**
@@ -56,8 +65,10 @@ enum endian {
 };
 typedef enum endian endian_t;
 
+extern FILE        *fin;                ///< Input stream.
 extern off_t        fin_offset;         ///< Current input file offset.
 extern char const  *fin_path;           ///< Input file path name.
+extern FILE        *fout;               ///< Output stream.
 extern char const  *me;                 ///< Program name.
 extern unsigned     row_bytes;          ///< Bytes dumped on a row.
 
@@ -0,0 +1,375 @@
+/*
+**      ad -- ASCII dump
+**      src/address_map.c
+**
+**      Copyright (C) 2024  Paul J. Lucas
+**
+**      This program is free software: you can redistribute it and/or modify
+**      it under the terms of the GNU General Public License as published by
+**      the Free Software Foundation, either version 3 of the License, or
+**      (at your option) any later version.
+**
+**      This program is distributed in the hope that it will be useful,
+**      but WITHOUT ANY WARRANTY; without even the implied warranty of
+**      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**      GNU General Public License for more details.
+**
+**      You should have received a copy of the GNU General Public License
+**      along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * Defines functions for mapping input offsets to addresses.
+ */
+
+// local
+#include "pjl_config.h"                 /* must go first */
+#include "address_map.h"
+#include "ad.h"
+#include "options.h"
+#include "util.h"
+
+/// @cond DOXYGEN_IGNORE
+
+// standard
+#include <assert.h>
+#include <ctype.h>                      /* for isspace() */
+#include <errno.h>
+#include <inttypes.h>                   /* for PRIX64 */
+#include <stdint.h>                     /* for uint*_t */
+#include <stdio.h>
+#include <stdlib.h>                     /* for qsort(), strtoull() */
+#include <string.h>                     /* for memcmp(), strchr() */
+#include <sysexits.h>
+
+/// @endcond
+
+/**
+ * @addtogroup address-map-group
+ * @{
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+
+#define ELF_MAGIC           "\x7F" "ELF"  /**< ELF file magic number.       */
+#define ELF_PT_LOAD         1u          /**< Loadable segment type.         */
+#define MAP_LINE_MAX        256         /**< Longest text map line.         */
+#define PE_MAGIC            "MZ"        /**< PE (DOS) file magic number.    */
+#define PE_OPT_MAGIC_32     0x10Bu      /**< PE32 optional header magic.    */
+#define PE_OPT_MAGIC_64     0x20Bu      /**< PE32+ optional header magic.   */
+
+/**
+ * A segment mapping a range of input offsets to a range of addresses.
+ */
+struct map_seg {
+  uint64_t  offset;                     ///< Input offset of the segment.
+  uint64_t  addr;                       ///< Address of the segment.
+  uint64_t  size;                       ///< Size of the segment in bytes.
+};
+typedef struct map_seg map_seg_t;
+
+static size_t     cursor;               ///< Segment of the last lookup.
+static off_t      last_offset;          ///< Offset of the last lookup.
+static map_seg_t *segs;                 ///< Segments sorted by offset.
+static size_t     segs_cap;             ///< Capacity of \ref segs.
+static size_t     segs_len;             ///< Number of \ref segs.
+
+////////// local functions ////////////////////////////////////////////////////
+
+/**
+ * Adds a segment to the address map.
+ *
+ * @param offset The input offset of the segment.
+ * @param addr The address of the segment.
+ * @param size The size of the segment; if 0, does nothing.
+ */
+static void map_add( uint64_t offset, uint64_t addr, uint64_t size ) {
+  if ( size == 0 )
+    return;
+  if ( segs_len == segs_cap ) {
+    segs_cap = segs_cap == 0 ? 8 : segs_cap * 2;
+    REALLOC( segs, segs_cap );
+  }
+  segs[ segs_len++ ] = (map_seg_t){ offset, addr, size };
+}
+
+/**
+ * Compares two segments by offset.
+ *
+ * @param i_data A pointer to the first \ref map_seg.
+ * @param j_data A pointer to the second \ref map_seg.
+ * @return Returns a number less than 0, 0, or greater than 0 if the offset of
+ * \a i_data is less than, equal to, or greater than that of \a j_data.
+ */
+NODISCARD
+static int map_cmp( void const *i_data, void const *j_data ) {
+  map_seg_t const *const i_seg = i_data;
+  map_seg_t const *const j_seg = j_data;
+  return (i_seg->offset > j_seg->offset) - (i_seg->offset < j_seg->offset);
+}
+
+/**
+ * Prints an error message that the address map file is invalid and exits.
+ *
+ * @param what What kind of file it is, e.g., "ELF".
+ */
+_Noreturn
+static void map_invalid( char const *what ) {
+  fatal_error( EX_DATAERR,
+    "\"%s\": invalid or truncated %s file\n", opt_address_map_path, what
+  );
+}
+
+/**
+ * Reads bytes from the address map file.
+ *
+ * @param file The file to read from.
+ * @param offset The offset to read from.
+ * @param buf The buffer to read into.
+ * @param size The number of bytes to read.
+ * @param what What's being read, e.g., "ELF".
+ */
+static void map_read( FILE *file, uint64_t offset, void *buf, size_t size,
+                      char const *what ) {
+  if ( fseeko( file, STATIC_CAST( off_t, offset ), SEEK_SET ) != 0 ||
+       fread( buf, 1, size, file ) != size ) {
+    map_invalid( what );
+  }
+}
+
+/**
+ * Decodes an unsigned integer.
+ *
+ * @param buf A pointer to the bytes of the integer.
+ * @param size The number of bytes of the integer: 2, 4, or 8.
+ * @param is_big Are the bytes in big-endian order?
+ * @return Returns said integer.
+ */
+NODISCARD
+static uint64_t map_uint( char8_t const *buf, size_t size, bool is_big ) {
+  uint64_t n = 0;
+  for ( size_t i = 0; i < size; ++i )
+    n = n << 8 | buf[ is_big ? i : size - 1 - i ];
+  return n;
+}
+
+/**
+ * Reads the segments of an address map from the `PT_LOAD` program headers of
+ * an ELF file.
+ *
+ * @param file The ELF file.
+ */
+static void map_load_elf( FILE *file ) {
+  char8_t ehdr[64];
+  map_read( file, 0, ehdr, 16, "ELF" );
+  bool const is_64 = ehdr[4] == 2;
+  bool const is_big = ehdr[5] == 2;
+  if ( (ehdr[4] != 1 && !is_64) || (ehdr[5] != 1 && !is_big) )
+    map_invalid( "ELF" );
+  map_read( file, 0, ehdr, is_64 ? 64 : 52, "ELF" );
+
+  uint64_t const phoff = is_64 ?
+    map_uint( ehdr + 0x20, 8, is_big ) : map_uint( ehdr + 0x1C, 4, is_big );
+  size_t const phentsize = STATIC_CAST( size_t,
+    map_uint( ehdr + (is_64 ? 0x36 : 0x2A), 2, is_big )
+  );
+  size_t const phnum = STATIC_CAST( size_t,
+    map_uint( ehdr + (is_64 ? 0x38 : 0x2C), 2, is_big )
+  );
+  if ( phentsize < (is_64 ? 56u : 32u) )
+    map_invalid( "ELF" );
+
+  char8_t phdr[56];
+  for ( size_t i = 0; i < phnum; ++i ) {
+    map_read( file, phoff + i * phentsize, phdr, is_64 ? 56 : 32, "ELF" );
+    if ( map_uint( phdr, 4, is_big ) != ELF_PT_LOAD )
+      continue;
+    if ( is_64 ) {
+      map_add(
+        map_uint( phdr + 0x08, 8, is_big ),
+        map_uint( phdr + 0x10, 8, is_big ),
+        map_uint( phdr + 0x20, 8, is_big )
+      );
+    } else {
+      map_add(
+        map_uint( phdr + 0x04, 4, is_big ),
+        map_uint( phdr + 0x08, 4, is_big ),
+        map_uint( phdr + 0x10, 4, is_big )
+      );
+    }
+  } // for
+}
+
+/**
+ * Reads the segments of an address map from the headers and section headers
+ * of a PE file.
+ *
+ * @param file The PE file.
+ */
+static void map_load_pe( FILE *file ) {
+  char8_t buf[40];
+  map_read( file, 0x3C, buf, 4, "PE" );
+  uint64_t const pe_off = map_uint( buf, 4, /*is_big=*/false );
+  map_read( file, pe_off, buf, 24, "PE" );
+  if ( memcmp( buf, "PE\0\0", 4 ) != 0 )
+    map_invalid( "PE" );
+  size_t const n_sections =
+    STATIC_CAST( size_t, map_uint( buf + 6, 2, false ) );
+  uint64_t const opt_size = map_uint( buf + 20, 2, false );
+
+  uint64_t const opt_off = pe_off + 24;
+  map_read( file, opt_off, buf, 2, "PE" );
+  uint64_t base;
+  switch ( map_uint( buf, 2, false ) ) {
+    case PE_OPT_MAGIC_32:
+      map_read( file, opt_off + 28, buf, 4, "PE" );
+      base = map_uint( buf, 4, false );
+      break;
+    case PE_OPT_MAGIC_64:
+      map_read( file, opt_off + 24, buf, 8, "PE" );
+      base = map_uint( buf, 8, false );
+      break;
+    default:
+      map_invalid( "PE" );
+  } // switch
+  map_read( file, opt_off + 60, buf, 4, "PE" );
+  map_add( 0, base, map_uint( buf, 4, false ) );  // SizeOfHeaders
+
+  uint64_t const sections_off = opt_off + opt_size;
+  for ( size_t i = 0; i < n_sections; ++i ) {
+    map_read( file, sections_off + i * 40, buf, 40, "PE" );
+    uint64_t const virtual_size = map_uint( buf + 8, 4, false );
+    uint64_t const virtual_addr = map_uint( buf + 12, 4, false );
+    uint64_t size = map_uint( buf + 16, 4, false );
+    uint64_t const raw_off = map_uint( buf + 20, 4, false );
+    if ( virtual_size > 0 && virtual_size < size )
+      size = virtual_size;              // the rest is file alignment padding
+    if ( raw_off > 0 )
+      map_add( raw_off, base + virtual_addr, size );
+  } // for
+}
+
+/**
+ * Reads the segments of an address map from a text file having lines of an
+ * input offset, address, and size, in C notation, separated by whitespace.
+ * A `#` starts a comment.
+ *
+ * @param file The text file.
+ */
+static void map_load_text( FILE *file ) {
+  char buf[ MAP_LINE_MAX ];
+  for ( unsigned line = 1; fgets( buf, sizeof buf, file ) != NULL; ++line ) {
+    char *const comment = strchr( buf, '#' );
+    if ( comment != NULL )
+      *comment = '\0';
+    char const *s = buf;
+    SKIP_WS( s );
+    if ( *s == '\0' )
+      continue;
+    uint64_t n[3];
+    for ( size_t i = 0; i < ARRAY_SIZE( n ); ++i ) {
+      SKIP_WS( s );
+      char *end;
+      errno = 0;
+      n[i] = strtoull( s, &end, 0 );
+      if ( !isdigit( *s ) || errno != 0 ||
+           (*end != '\0' && !isspace( *end )) ) {
+        fatal_error( EX_DATAERR,
+          "\"%s\": line %u: \"offset address size\" expected\n",
+          opt_address_map_path, line
+        );
+      }
+      s = end;
+    } // for
+    SKIP_WS( s );
+    if ( *s != '\0' ) {
+      fatal_error( EX_DATAERR,
+        "\"%s\": line %u: \"%s\": unexpected\n", opt_address_map_path, line, s
+      );
+    }
+    map_add( n[0], n[1], n[2] );
+  } // for
+}
+
+////////// extern functions ///////////////////////////////////////////////////
+
+bool address_map_lookup( off_t offset, size_t len, uint64_t *paddr ) {
+  if ( offset < last_offset )
+    cursor = 0;
+  last_offset = offset;
+
+  uint64_t const begin = STATIC_CAST( uint64_t, offset );
+  while ( cursor < segs_len &&
+          segs[ cursor ].offset + segs[ cursor ].size <= begin ) {
+    ++cursor;
+  } // while
+  if ( cursor == segs_len || segs[ cursor ].offset >= begin + len )
+    return false;
+  if ( paddr != NULL )                  // wraps if segment starts mid-row
+    *paddr = segs[ cursor ].addr + (begin - segs[ cursor ].offset);
+  return true;
+}
+
+void address_map_load( void ) {
+  assert( opt_address_map_path != NULL );
+  FILE *const file = fopen( opt_address_map_path, "r" );
+  if ( unlikely( file == NULL ) ) {
+    fatal_error( EX_NOINPUT,
+      "\"%s\": %s\n", opt_address_map_path, STRERROR()
+    );
+  }
+
+  char magic[4] = { 0 };
+  size_t const magic_len = fread( magic, 1, sizeof magic, file );
+  rewind( file );
+  if ( magic_len == sizeof magic && memcmp( magic, ELF_MAGIC, 4 ) == 0 )
+    map_load_elf( file );
+  else if ( magic_len >= 2 && memcmp( magic, PE_MAGIC, 2 ) == 0 )
+    map_load_pe( file );
+  else
+    map_load_text( file );
+  fclose( file );
+
+  if ( segs_len == 0 ) {
+    fatal_error( EX_DATAERR,
+      "\"%s\": no segments in address map\n", opt_address_map_path
+    );
+  }
+  qsort( segs, segs_len, sizeof( map_seg_t ), &map_cmp );
+  for ( size_t i = 1; i < segs_len; ++i ) {
+    if ( segs[i].offset < segs[i-1].offset + segs[i-1].size ) {
+      fatal_error( EX_DATAERR,
+        "\"%s\": segments at offsets 0x%" PRIX64 " and 0x%" PRIX64
+        " overlap\n",
+        opt_address_map_path, segs[i-1].offset, segs[i].offset
+      );
+    }
+  } // for
+  PJL_DISCARD_RV( free_later( segs ) );
+}
+
+off_t address_map_offset( uint64_t addr ) {
+  for ( size_t i = 0; i < segs_len; ++i ) {
+    if ( addr >= segs[i].addr && addr - segs[i].addr < segs[i].size )
+      return STATIC_CAST( off_t, segs[i].offset + (addr - segs[i].addr) );
+  } // for
+  fatal_error( EX_USAGE,
+    "\"0x%" PRIX64 "\": address not in \"%s\"\n", addr, opt_address_map_path
+  );
+}
+
+void address_map_range( off_t *pbegin, off_t *pend ) {
+  assert( pbegin != NULL );
+  assert( pend != NULL );
+  assert( segs_len > 0 );
+  map_seg_t const *const last = &segs[ segs_len - 1 ];
+  *pbegin = STATIC_CAST( off_t, segs[0].offset );
+  *pend = STATIC_CAST( off_t, last->offset + last->size );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/** @} */
+
+/* vim:set et sw=2 ts=2: */
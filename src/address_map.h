@@ -0,0 +1,99 @@
+/*
+**      ad -- ASCII dump
+**      src/address_map.h
+**
+**      Copyright (C) 2024  Paul J. Lucas
+**
+**      This program is free software: you can redistribute it and/or modify
+**      it under the terms of the GNU General Public License as published by
+**      the Free Software Foundation, either version 3 of the License, or
+**      (at your option) any later version.
+**
+**      This program is distributed in the hope that it will be useful,
+**      but WITHOUT ANY WARRANTY; without even the implied warranty of
+**      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**      GNU General Public License for more details.
+**
+**      You should have received a copy of the GNU General Public License
+**      along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ad_address_map_H
+#define ad_address_map_H
+
+/**
+ * @file
+ * Declares functions for mapping input offsets to addresses.
+ */
+
+// local
+#include "pjl_config.h"                 /* must go first */
+
+/// @cond DOXYGEN_IGNORE
+
+// standard
+#include <stdbool.h>
+#include <stddef.h>                     /* for size_t */
+#include <stdint.h>                     /* for uint64_t */
+#include <sys/types.h>                  /* for off_t */
+
+/// @endcond
+
+/**
+ * @defgroup address-map-group Address Map
+ * Functions for mapping input offsets to addresses.
+ *
+ * @remarks An address map is a table of segments, each mapping a range of
+ * input offsets to a range of (typically virtual load) addresses, sorted by
+ * offset.  It's read from either the program headers of an ELF file, the
+ * section headers of a PE file, or a text file.  Since rows are dumped in
+ * ascending offset order, the segment for each row is found incrementally.
+ * @{
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Gets the address of \a offset.
+ *
+ * @remarks Successive calls should be for ascending offsets; otherwise
+ * they're slower.
+ *
+ * @param offset The input offset of a row.
+ * @param len The length of the row.
+ * @param paddr If not NULL and the row is mapped, set to the address of \a
+ * offset according to the first segment containing any byte of the row.
+ * @return Returns `true` only if any byte of the row is mapped.
+ */
+NODISCARD
+bool address_map_lookup( off_t offset, size_t len, uint64_t *paddr );
+
+/**
+ * Reads the address map from \ref opt_address_map_path.
+ */
+void address_map_load( void );
+
+/**
+ * Gets the input offset of \a addr.
+ *
+ * @param addr The address.
+ * @return Returns said offset or prints an error message and exits if \a addr
+ * isn't mapped.
+ */
+NODISCARD
+off_t address_map_offset( uint64_t addr );
+
+/**
+ * Gets the range of input offsets spanned by all segments.
+ *
+ * @param pbegin Set to the offset of the first mapped byte.
+ * @param pend Set to the offset of one past the last mapped byte.
+ */
+void address_map_range( off_t *pbegin, off_t *pend );
+
+///////////////////////////////////////////////////////////////////////////////
+
+/** @} */
+
+#endif /* ad_address_map_H */
+/* vim:set et sw=2 ts=2: */
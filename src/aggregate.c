@@ -0,0 +1,621 @@
+/*
+**      ad -- ASCII dump
+**      src/aggregate.c
+**
+**      Copyright (C) 2024  Paul J. Lucas
+**
+**      This program is free software: you can redistribute it and/or modify
+**      it under the terms of the GNU General Public License as published by
+**      the Free Software Foundation, either version 3 of the License, or
+**      (at your option) any later version.
+**
+**      This program is distributed in the hope that it will be useful,
+**      but WITHOUT ANY WARRANTY; without even the implied warranty of
+**      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**      GNU General Public License for more details.
+**
+**      You should have received a copy of the GNU General Public License
+**      along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * Defines types and functions for reporting the unique strings in a file
+ * along with their counts and first offsets.
+ */
+
+// local
+#include "pjl_config.h"                 /* must go first */
+#include "ad.h"
+#include "color.h"
+#include "input.h"
+#include "match.h"
+#include "options.h"
+#include "parallel.h"
+#include "unicode.h"
+#include "util.h"
+
+/// @cond DOXYGEN_IGNORE
+
+// standard
+#include <assert.h>
+#include <inttypes.h>                   /* for PRIu64, etc. */
+#include <stddef.h>                     /* for size_t */
+#include <stdint.h>                     /* for uint64_t */
+#include <stdio.h>
+#include <stdlib.h>                     /* for exit(), qsort() */
+#include <string.h>                     /* for memcmp(), memcpy() */
+#include <sysexits.h>
+
+/// @endcond
+
+/**
+ * @defgroup aggregate-group Aggregating Strings
+ * Types and functions for reporting the unique strings in a file.
+ * @{
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+
+#define AGG_ARENA_CAP_MIN   (64 * 1024u)  /**< Initial arena capacity.      */
+#define AGG_TABLE_CAP_MIN   1024u         /**< Initial table capacity.      */
+
+/**
+ * Storage for strings: each unique string is stored once, contiguously, and
+ * referred to by its position rather than by pointer since the storage may be
+ * reallocated.
+ */
+struct agg_arena {
+  char8_t  *buf;                        ///< Bytes of all strings.
+  size_t    len;                        ///< Bytes used.
+  size_t    cap;                        ///< Bytes allocated.
+};
+typedef struct agg_arena agg_arena_t;
+
+/**
+ * An entry in an \ref agg_table.
+ */
+struct agg_entry {
+  uint64_t      hash;                   ///< Hash of the string.
+  off_t         offset;                 ///< Offset of first occurrence.
+  unsigned long count;                  ///< Occurrences; 0 = empty slot.
+  size_t        str_pos;                ///< Position of string in arena.
+  size_t        str_len;                ///< Length of string.
+};
+typedef struct agg_entry agg_entry_t;
+
+/**
+ * A hash table of unique strings using open addressing with linear probing.
+ */
+struct agg_table {
+  agg_entry_t  *entries;                ///< Entries; capacity is power of 2.
+  size_t        cap;                    ///< Capacity of \ref entries.
+  size_t        len;                    ///< Number of used entries.
+  agg_arena_t   arena;                  ///< Storage for strings.
+};
+typedef struct agg_table agg_table_t;
+
+/**
+ * State for scanning bytes for strings.
+ */
+struct agg_scan {
+  agg_table_t  *table;                  ///< Table to add strings to.
+  char8_t      *run;                    ///< Current run of string bytes.
+  size_t        run_cap;                ///< Capacity of \ref run.
+  size_t        run_len;                ///< Bytes in \ref run.
+  size_t        run_chars;              ///< Complete characters in \ref run.
+  off_t         run_offset;             ///< Offset of \ref run.
+  unsigned      utf8_len;               ///< Bytes of partial UTF-8 character.
+  unsigned      utf8_left;              ///< Bytes left for UTF-8 character.
+};
+typedef struct agg_scan agg_scan_t;
+
+/**
+ * Data shared by all tasks of a parallel aggregation.
+ */
+struct agg_job {
+  off_t         begin;                  ///< File offset to start at.
+  off_t         end;                    ///< File offset to end at.
+  size_t        chunk_size;             ///< Bytes per task.
+  char8_t     **bufs;                   ///< Per-worker read buffers.
+  agg_scan_t   *scans;                  ///< Per-worker scan states.
+};
+typedef struct agg_job agg_job_t;
+
+////////// local functions ////////////////////////////////////////////////////
+
+/**
+ * Adds a string to \a arena.
+ *
+ * @param arena The \ref agg_arena to add to.
+ * @param s The string to add.
+ * @param len The length of \a s.
+ * @return Returns the position of the string within \a arena.
+ */
+NODISCARD
+static size_t agg_arena_add( agg_arena_t *arena, char8_t const *s,
+                             size_t len ) {
+  assert( arena != NULL );
+  assert( s != NULL );
+
+  if ( arena->len + len > arena->cap ) {
+    if ( arena->cap == 0 )
+      arena->cap = AGG_ARENA_CAP_MIN;
+    while ( arena->len + len > arena->cap )
+      arena->cap <<= 1;
+    REALLOC( arena->buf, arena->cap );
+  }
+  size_t const pos = arena->len;
+  memcpy( arena->buf + pos, s, len );
+  arena->len += len;
+  return pos;
+}
+
+/**
+ * Computes the FNV-1a hash of a string.
+ *
+ * @param s The string to hash.
+ * @param len The length of \a s.
+ * @return Returns said hash.
+ */
+NODISCARD
+static uint64_t agg_hash( char8_t const *s, size_t len ) {
+  uint64_t hash = 0xCBF29CE484222325ull;
+  while ( len-- > 0 ) {
+    hash ^= *s++;
+    hash *= 0x100000001B3ull;
+  } // while
+  return hash;
+}
+
+/**
+ * Checks whether \a byte ends any string regardless of the bytes preceding
+ * it, i.e., after it, scanning always starts afresh.
+ *
+ * @param byte The byte to check.
+ * @return Returns `true` only if \a byte is such a byte.
+ */
+NODISCARD
+static bool agg_is_break( char8_t byte ) {
+  return  !match_strings_byte( byte, /*must_be_utf8_cont=*/false ) &&
+          !(opt_utf8 && utf8_is_cont( byte ));
+}
+
+/**
+ * Reads exactly \a len bytes from the input at \a offset.
+ *
+ * @param buf The buffer to read into.
+ * @param len The number of bytes to read.
+ * @param offset The file offset to read from.
+ */
+static void agg_read( char8_t *buf, size_t len, off_t offset ) {
+  while ( len > 0 ) {
+    ssize_t const bytes_read = input_pread( buf, len, offset );
+    if ( unlikely( bytes_read <= 0 ) ) {
+      fatal_error( EX_IOERR,
+        "\"%s\": read failed: %s\n", fin_path, STRERROR()
+      );
+    }
+    buf += bytes_read;
+    len -= STATIC_CAST( size_t, bytes_read );
+    offset += bytes_read;
+  } // while
+}
+
+/**
+ * Adds a string or merges its count and offset into \a table.
+ *
+ * @param table The \ref agg_table to add to.
+ * @param s The string to add.
+ * @param len The length of \a s.
+ * @param hash The hash of \a s.
+ * @param offset The offset of the first occurrence of \a s.
+ * @param count The number of occurrences of \a s.
+ */
+static void agg_table_add( agg_table_t *table, char8_t const *s, size_t len,
+                           uint64_t hash, off_t offset, unsigned long count ) {
+  assert( table != NULL );
+  assert( s != NULL );
+  assert( count > 0 );
+
+  if ( (table->len + 1) * 4 > table->cap * 3 ) {
+    //
+    // Grow the table: since each entry has its hash, the strings themselves
+    // needn't be touched.
+    //
+    size_t const new_cap =
+      table->cap == 0 ? AGG_TABLE_CAP_MIN : table->cap << 1;
+    agg_entry_t *const new_entries = MALLOC( agg_entry_t, new_cap );
+    memset( new_entries, 0, sizeof( agg_entry_t ) * new_cap );
+    for ( size_t i = 0; i < table->cap; ++i ) {
+      agg_entry_t const *const e = &table->entries[i];
+      if ( e->count == 0 )
+        continue;
+      size_t j = e->hash & (new_cap - 1);
+      while ( new_entries[j].count != 0 )
+        j = (j + 1) & (new_cap - 1);
+      new_entries[j] = *e;
+    } // for
+    free( table->entries );
+    table->entries = new_entries;
+    table->cap = new_cap;
+  }
+
+  size_t i = hash & (table->cap - 1);
+  for ( ; table->entries[i].count != 0; i = (i + 1) & (table->cap - 1) ) {
+    agg_entry_t *const e = &table->entries[i];
+    if ( e->hash == hash && e->str_len == len &&
+         memcmp( table->arena.buf + e->str_pos, s, len ) == 0 ) {
+      e->count += count;
+      if ( offset < e->offset )
+        e->offset = offset;
+      return;
+    }
+  } // for
+
+  table->entries[i] = (agg_entry_t){
+    .hash = hash,
+    .offset = offset,
+    .count = count,
+    .str_pos = agg_arena_add( &table->arena, s, len ),
+    .str_len = len
+  };
+  ++table->len;
+}
+
+/**
+ * Ends the current run of string bytes, if any, adding it to the table if it
+ * comprises a string.
+ *
+ * @param scan The \ref agg_scan to use.
+ * @param terminator The byte that ended the run or `EOF`.
+ */
+static void agg_scan_end( agg_scan_t *scan, int terminator ) {
+  assert( scan != NULL );
+
+  if ( scan->utf8_left > 0 )            // drop incomplete UTF-8 character
+    scan->run_len -= scan->utf8_len;
+
+  if ( scan->run_len > 0 && scan->run_chars >= opt_search_len &&
+       ((opt_strings_opts & STRINGS_NULL) == 0 || terminator == '\0') ) {
+    agg_table_add(
+      scan->table, scan->run, scan->run_len,
+      agg_hash( scan->run, scan->run_len ), scan->run_offset, 1
+    );
+  }
+
+  scan->run_len = scan->run_chars = 0;
+  scan->utf8_len = scan->utf8_left = 0;
+}
+
+/**
+ * Scans a byte for strings.
+ *
+ * @param scan The \ref agg_scan to use.
+ * @param byte The byte to scan.
+ * @param offset The offset of \a byte.
+ */
+static void agg_scan_byte( agg_scan_t *scan, char8_t byte, off_t offset ) {
+  assert( scan != NULL );
+
+  if ( scan->utf8_left > 0 ) {
+    if ( !match_strings_byte( byte, /*must_be_utf8_cont=*/true ) ) {
+      agg_scan_end( scan, byte );
+    }
+    else {
+      scan->run[ scan->run_len++ ] = byte;
+      ++scan->utf8_len;
+      if ( --scan->utf8_left == 0 ) {
+        ++scan->run_chars;
+        scan->utf8_len = 0;
+      }
+      return;
+    }
+  }
+
+  if ( !match_strings_byte( byte, /*must_be_utf8_cont=*/false ) ) {
+    agg_scan_end( scan, byte );
+    return;
+  }
+
+  unsigned const len = opt_utf8 ? utf8c_len( byte ) : 1;
+  if ( scan->run_len == 0 )
+    scan->run_offset = offset;
+  if ( scan->run_len + len > scan->run_cap ) {
+    scan->run_cap = scan->run_cap == 0 ? 256 : scan->run_cap << 1;
+    REALLOC( scan->run, scan->run_cap );
+  }
+  scan->run[ scan->run_len++ ] = byte;
+
+  if ( len > 1 ) {
+    scan->utf8_len = 1;
+    scan->utf8_left = len - 1;
+  } else {
+    ++scan->run_chars;
+  }
+}
+
+/**
+ * Scans one chunk of the input for strings.
+ *
+ * @remarks A chunk's strings are those starting after the first byte in the
+ * chunk after which scanning always starts afresh (see agg_is_break()) through
+ * the first such byte at or after the chunk's end, even if that's in later
+ * chunks.  Hence every string is scanned by exactly one task and the result is
+ * the same as scanning the whole input sequentially.
+ *
+ * @param data A pointer to the \ref agg_job.
+ * @param task The chunk number.
+ * @param worker The worker number.
+ */
+static void agg_task( void *data, size_t task, unsigned worker ) {
+  agg_job_t const *const job = data;
+  agg_scan_t *const scan = &job->scans[ worker ];
+  char8_t *const buf = job->bufs[ worker ];
+
+  off_t pos = job->begin + STATIC_CAST( off_t, task * job->chunk_size );
+  off_t chunk_end = pos + STATIC_CAST( off_t, job->chunk_size );
+  if ( chunk_end > job->end )
+    chunk_end = job->end;
+  bool started = task == 0;
+
+  while ( pos < job->end ) {
+    size_t len = job->chunk_size;
+    if ( STATIC_CAST( off_t, len ) > job->end - pos )
+      len = STATIC_CAST( size_t, job->end - pos );
+    agg_read( buf, len, pos );
+
+    for ( size_t i = 0; i < len; ++i, ++pos ) {
+      bool const is_break = agg_is_break( buf[i] );
+      if ( !started ) {
+        if ( pos >= chunk_end )         // no string starts in this chunk
+          return;
+        started = is_break;
+        continue;
+      }
+      agg_scan_byte( scan, buf[i], fin_offset + (pos - job->begin) );
+      if ( is_break && pos >= chunk_end )
+        return;
+    } // for
+  } // while
+
+  agg_scan_end( scan, EOF );
+}
+
+/**
+ * Compares two \ref agg_entry pointers by descending count, then ascending
+ * offset.
+ *
+ * @param i_data A pointer to the first \ref agg_entry pointer.
+ * @param j_data A pointer to the second \ref agg_entry pointer.
+ * @return Returns a number less than 0, 0, or greater than 0 if the first
+ * entry is less than, equal to, or greater than the second, respectively.
+ */
+NODISCARD
+static int agg_cmp_count( void const *i_data, void const *j_data ) {
+  agg_entry_t const *const i = *STATIC_CAST( agg_entry_t const *const*, i_data );
+  agg_entry_t const *const j = *STATIC_CAST( agg_entry_t const *const*, j_data );
+  if ( i->count != j->count )
+    return i->count > j->count ? -1 : 1;
+  return (i->offset > j->offset) - (i->offset < j->offset);
+}
+
+/**
+ * Compares two \ref agg_entry pointers by ascending offset.
+ *
+ * @param i_data A pointer to the first \ref agg_entry pointer.
+ * @param j_data A pointer to the second \ref agg_entry pointer.
+ * @return Returns a number less than 0, 0, or greater than 0 if the first
+ * entry is less than, equal to, or greater than the second, respectively.
+ */
+NODISCARD
+static int agg_cmp_offset( void const *i_data, void const *j_data ) {
+  agg_entry_t const *const i = *STATIC_CAST( agg_entry_t const *const*, i_data );
+  agg_entry_t const *const j = *STATIC_CAST( agg_entry_t const *const*, j_data );
+  return (i->offset > j->offset) - (i->offset < j->offset);
+}
+
+/**
+ * Prints a string escaping the whitespace characters that can be part of a
+ * string.
+ *
+ * @param s The string to print.
+ * @param len The length of \a s.
+ */
+static void agg_print_string( char8_t const *s, size_t len ) {
+  for ( char8_t const *const end = s + len; s < end; ++s ) {
+    switch ( *s ) {
+      case '\f': PUTS( "\\f" ); break;
+      case '\n': PUTS( "\\n" ); break;
+      case '\r': PUTS( "\\r" ); break;
+      case '\t': PUTS( "\\t" ); break;
+      case '\v': PUTS( "\\v" ); break;
+      default  : PUTC( *s );
+    } // switch
+  } // for
+}
+
+/**
+ * Prints the report of unique strings in \a table.
+ *
+ * @param table The \ref agg_table to print.
+ */
+static void agg_print( agg_table_t const *table ) {
+  assert( table != NULL );
+
+  agg_entry_t const **const sorted = MALLOC( agg_entry_t const*, table->len );
+  unsigned long count_max = 0;
+  size_t n = 0;
+  for ( size_t i = 0; i < table->cap; ++i ) {
+    agg_entry_t const *const e = &table->entries[i];
+    if ( e->count == 0 )
+      continue;
+    sorted[ n++ ] = e;
+    if ( e->count > count_max )
+      count_max = e->count;
+  } // for
+  assert( n == table->len );
+
+  qsort(
+    sorted, n, sizeof( agg_entry_t const* ),
+    opt_aggregate == AGGREGATE_OFFSET ? &agg_cmp_offset : &agg_cmp_count
+  );
+
+  int count_width = 1;
+  while ( count_max >= 10 ) {
+    count_max /= 10;
+    ++count_width;
+  } // while
+
+  char const *const offset_format = get_offsets_format();
+  for ( size_t i = 0; i < n; ++i ) {
+    agg_entry_t const *const e = sorted[i];
+    if ( opt_offsets != OFFSETS_NONE ) {
+      color_start( fout, sgr_offset );
+      PRINTF( offset_format, STATIC_CAST( uint64_t, e->offset ) );
+      color_end( fout, sgr_offset );
+      color_start( fout, sgr_sep );
+      PUTC( ':' );
+      color_end( fout, sgr_sep );
+      PUTC( ' ' );
+    }
+    PRINTF( "%*lu ", count_width, e->count );
+    color_start( fout, sgr_ascii_match );
+    agg_print_string( table->arena.buf + e->str_pos, e->str_len );
+    color_end( fout, sgr_ascii_match );
+    PUTC( '\n' );
+  } // for
+
+  free( sorted );
+}
+
+/**
+ * Aggregates the strings of a regular file in parallel.
+ *
+ * @param tables The per-worker tables to add strings to.
+ * @param jobs The number of workers.
+ */
+static void agg_file_parallel( agg_table_t *tables, unsigned jobs ) {
+  agg_job_t job = {
+    .begin = FTELL_FN( fin ),
+    .end = input_size(),
+    .chunk_size = par_chunk_size(),
+    .bufs = MALLOC( char8_t*, jobs ),
+    .scans = MALLOC( agg_scan_t, jobs )
+  };
+  if ( job.end - job.begin > 0 &&
+       STATIC_CAST( uint64_t, job.end - job.begin ) > opt_max_bytes ) {
+    job.end = job.begin + STATIC_CAST( off_t, opt_max_bytes );
+  }
+
+  for ( unsigned w = 0; w < jobs; ++w ) {
+    job.bufs[w] = MALLOC( char8_t, job.chunk_size );
+    job.scans[w] = (agg_scan_t){ .table = &tables[w] };
+  } // for
+
+  if ( job.end > job.begin ) {
+    size_t const n_tasks =
+      (STATIC_CAST( size_t, job.end - job.begin ) + job.chunk_size - 1)
+      / job.chunk_size;
+    par_for( n_tasks, &agg_task, &job );
+  }
+
+  for ( unsigned w = 0; w < jobs; ++w ) {
+    free( job.bufs[w] );
+    free( job.scans[w].run );
+  } // for
+  free( job.bufs );
+  free( job.scans );
+}
+
+/**
+ * Aggregates the strings of a non-regular file sequentially.
+ *
+ * @param table The table to add strings to.
+ */
+static void agg_file_sequential( agg_table_t *table ) {
+  agg_scan_t scan = { .table = table };
+  char8_t buf[ 8192 ];
+  size_t total_read = 0;
+
+  while ( total_read < opt_max_bytes ) {
+    size_t len = sizeof buf;
+    if ( len > opt_max_bytes - total_read )
+      len = opt_max_bytes - total_read;
+    size_t const bytes_read = fread( buf, 1, len, fin );
+    if ( unlikely( ferror( fin ) ) ) {
+      fatal_error( EX_IOERR,
+        "\"%s\": read failed: %s\n", fin_path, STRERROR()
+      );
+    }
+    for ( size_t i = 0; i < bytes_read; ++i ) {
+      agg_scan_byte(
+        &scan, buf[i], fin_offset + STATIC_CAST( off_t, total_read + i )
+      );
+    } // for
+    total_read += bytes_read;
+    if ( bytes_read < len )
+      break;
+  } // while
+
+  agg_scan_end( &scan, EOF );
+  free( scan.run );
+}
+
+/////////// extern functions //////////////////////////////////////////////////
+
+/**
+ * Reports the unique strings in a file along with their counts and first
+ * offsets.
+ */
+void aggregate_file( void ) {
+  bool const is_file = input_is_file();
+  unsigned const jobs = is_file ? par_jobs() : 1;
+  agg_table_t *const tables = MALLOC( agg_table_t, jobs );
+  memset( tables, 0, sizeof( agg_table_t ) * jobs );
+
+  if ( is_file )
+    agg_file_parallel( tables, jobs );
+  else
+    agg_file_sequential( tables );
+
+  // Merge the per-worker tables into the first.
+  for ( unsigned w = 1; w < jobs; ++w ) {
+    agg_table_t *const t = &tables[w];
+    for ( size_t i = 0; i < t->cap; ++i ) {
+      agg_entry_t const *const e = &t->entries[i];
+      if ( e->count > 0 ) {
+        agg_table_add(
+          tables, t->arena.buf + e->str_pos, e->str_len, e->hash, e->offset,
+          e->count
+        );
+      }
+    } // for
+  } // for
+
+  for ( size_t i = 0; i < tables->cap; ++i )
+    total_matches += tables->entries[i].count;
+
+  if ( opt_matches != MATCHES_ONLY_PRINT )
+    agg_print( tables );
+
+  if ( opt_matches != MATCHES_NO_PRINT ) {
+    FFLUSH( fout );
+    EPRINTF( "%lu\n", total_matches );
+  }
+
+  for ( unsigned w = 0; w < jobs; ++w ) {
+    free( tables[w].entries );
+    free( tables[w].arena.buf );
+  } // for
+  free( tables );
+
+  if ( total_matches == 0 )
+    exit( EX_NO_MATCHES );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/** @} */
+
+/* vim:set et sw=2 ts=2: */
@@ -0,0 +1,714 @@
+/*
+**      ad -- ASCII dump
+**      src/cache.c
+**
+**      Copyright (C) 2024  Paul J. Lucas
+**
+**      This program is free software: you can redistribute it and/or modify
+**      it under the terms of the GNU General Public License as published by
+**      the Free Software Foundation, either version 3 of the License, or
+**      (at your option) any later version.
+**
+**      This program is distributed in the hope that it will be useful,
+**      but WITHOUT ANY WARRANTY; without even the implied warranty of
+**      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**      GNU General Public License for more details.
+**
+**      You should have received a copy of the GNU General Public License
+**      along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * Defines functions for caching the results of runs.
+ */
+
+// local
+#include "pjl_config.h"                 /* must go first */
+#include "ad.h"
+#include "color.h"
+#include "input.h"
+#include "options.h"
+#include "unicode.h"
+#include "util.h"
+
+/// @cond DOXYGEN_IGNORE
+
+// standard
+#include <assert.h>
+#include <ctype.h>                      /* for isdigit(), isxdigit() */
+#include <dirent.h>                     /* for opendir(3) */
+#include <errno.h>
+#include <fcntl.h>                      /* for open(2) */
+#include <inttypes.h>                   /* for PRIx64 */
+#include <poll.h>
+#include <signal.h>                     /* for raise(3) */
+#include <stdint.h>                     /* for uint*_t */
+#include <stdio.h>
+#include <stdlib.h>                     /* for exit(), getenv(), mkstemp() */
+#include <string.h>                     /* for str...() */
+#include <sys/stat.h>                   /* for fstat(2), futimens(2) */
+#include <sys/types.h>                  /* for off_t, pid_t */
+#include <sys/wait.h>                   /* for waitpid(2) */
+#include <sysexits.h>
+#include <time.h>                       /* for time(3) */
+#include <unistd.h>                     /* for fork(2), pipe(2), pread(2) */
+
+/// @endcond
+
+/**
+ * @defgroup cache-group Result Cache
+ * Functions for caching the results of runs.
+ *
+ * @remarks With \c --cache, the output of a run is stored in a file in the
+ * cache directory named by a 128-bit hash (the _key_) of the identity (or
+ * content) of the input, the normalized options, and whatever else affects
+ * the output, e.g., colors.  A later run having the same key copies the
+ * stored output and exit status rather than running again.
+ *
+ * On a miss, **ad** forks: the child runs as usual, but with its standard
+ * output and error connected to pipes; the parent copies both to where they
+ * were going as they arrive (so output still streams) and also to a temporary
+ * file that, if the child succeeds, is renamed to be the entry.  Since renames
+ * are atomic, concurrent runs never see a partial entry: at worst, runs
+ * having the same key each store it.
+ *
+ * When the total size of entries exceeds the limit, the least recently used
+ * are evicted first: a hit updates the modification time of its entry.
+ * @{
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+
+#define CACHE_DIR_ENV       "AD_CACHE_DIR"  /**< Cache directory override.  */
+#define CACHE_DIR_PATH      "ad"        /**< Relative to user cache dir.    */
+#define CACHE_HASH_SIZE     (1024 * 1024u)  /**< Read size for hashing.     */
+#define CACHE_KEY_LEN       32          /**< Hexadecimal digits in a key.   */
+#define CACHE_MAGIC         "ADCACHE1"  /**< Entry file magic number.       */
+#define CACHE_PIPE_SIZE     (64 * 1024u)    /**< Read size for pipes.       */
+#define CACHE_SIZE_DEFAULT  (64 * 1024 * 1024u) /**< Default size limit.    */
+#define CACHE_SIZE_ENV      "AD_CACHE_SIZE" /**< Size limit override.       */
+#define CACHE_TMP_AGE_MAX   (24 * 60 * 60)  /**< Stale temporary file age.  */
+#define CACHE_TMP_PREFIX    ".tmp-"     /**< Temporary entry file prefix.   */
+
+/**
+ * A cache key: a 128-bit hash of everything that affects the output.
+ */
+struct cache_key {
+  uint64_t  h[2];                       ///< Hash halves.
+};
+typedef struct cache_key cache_key_t;
+
+/**
+ * The header of a cache entry file.  It's followed by the bytes of standard
+ * output and then those of standard error.
+ */
+struct cache_header {
+  char        magic[ sizeof CACHE_MAGIC - 1 ];  ///< #CACHE_MAGIC.
+  cache_key_t key;                      ///< Key of the entry.
+  uint64_t    out_len;                  ///< Bytes of standard output.
+  uint64_t    err_len;                  ///< Bytes of standard error.
+  int64_t     status;                   ///< Exit status.
+};
+typedef struct cache_header cache_header_t;
+
+/**
+ * A cache entry file for eviction.
+ */
+struct cache_file {
+  char      name[ CACHE_KEY_LEN + 1 ];  ///< File name.
+  uint64_t  size;                       ///< File size.
+  int64_t   mtime;                      ///< Modification time in nanoseconds.
+};
+typedef struct cache_file cache_file_t;
+
+////////// local functions ////////////////////////////////////////////////////
+
+/**
+ * Compares two \ref cache_file by modification time for **qsort**(3).
+ *
+ * @param i_data A pointer to the first \ref cache_file.
+ * @param j_data A pointer to the second \ref cache_file.
+ * @return Returns a number less than 0, 0, or greater than 0 if the first is
+ * less recently, equally, or more recently modified than the second.
+ */
+NODISCARD
+static int cache_file_cmp( void const *i_data, void const *j_data ) {
+  cache_file_t const *const i = i_data;
+  cache_file_t const *const j = j_data;
+  return (i->mtime > j->mtime) - (i->mtime < j->mtime);
+}
+
+/**
+ * Gets the modification time of a file.
+ *
+ * @param st The status of the file.
+ * @return Returns said time in nanoseconds.
+ */
+NODISCARD
+static int64_t cache_mtime( struct stat const *st ) {
+  int64_t const ns = STATIC_CAST( int64_t, st->st_mtime ) * 1000000000;
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+  return ns + st->st_mtim.tv_nsec;
+#else
+  return ns;
+#endif /* HAVE_STRUCT_STAT_ST_MTIM */
+}
+
+/**
+ * Gets the path of the cache directory.
+ *
+ * @return Returns said path or NULL if there is none.
+ */
+NODISCARD
+static char const* cache_dir( void ) {
+  char const *const env = getenv( CACHE_DIR_ENV );
+  if ( env != NULL && env[0] != '\0' )
+    return env;
+
+  char const *dir = getenv( "XDG_CACHE_HOME" );
+  char const *sub = "/";
+  if ( dir == NULL || dir[0] == '\0' ) {
+    dir = getenv( "HOME" );
+    if ( dir == NULL || dir[0] == '\0' )
+      return NULL;
+    sub = "/.cache/";
+  }
+  char *const path = free_later(
+    MALLOC( char, strlen( dir ) + strlen( sub ) + sizeof CACHE_DIR_PATH )
+  );
+  strcpy( path, dir );
+  strcat( path, sub );
+  strcat( path, CACHE_DIR_PATH );
+  return path;
+}
+
+/**
+ * Evicts the least recently used entries until their total size is at most
+ * \a limit and removes stale temporary files left by runs that were killed.
+ *
+ * @remarks Concurrent runs may evict the same entries; that one of them can't
+ * remove an entry the other already has is harmless.
+ *
+ * @param dir The path of the cache directory.
+ * @param limit The maximum total size of entries.
+ */
+static void cache_evict( char const *dir, uint64_t limit ) {
+  DIR *const d = opendir( dir );
+  if ( d == NULL )
+    return;
+  int const dir_fd = dirfd( d );
+  time_t const now = time( NULL );
+
+  cache_file_t *files = NULL;
+  size_t files_cap = 0, files_len = 0;
+  uint64_t total = 0;
+
+  for ( struct dirent const *de; (de = readdir( d )) != NULL; ) {
+    struct stat st;
+    if ( fstatat( dir_fd, de->d_name, &st, AT_SYMLINK_NOFOLLOW ) != 0 ||
+         !S_ISREG( st.st_mode ) ) {
+      continue;
+    }
+    if ( strncmp( de->d_name, CACHE_TMP_PREFIX,
+                  STRLITLEN( CACHE_TMP_PREFIX ) ) == 0 ) {
+      if ( now - st.st_mtime > CACHE_TMP_AGE_MAX )
+        PJL_DISCARD_RV( unlinkat( dir_fd, de->d_name, 0 ) );
+      continue;
+    }
+    // Consider only files named like keys in case the directory is shared.
+    size_t name_len = 0;
+    while ( name_len <= CACHE_KEY_LEN && isxdigit( de->d_name[ name_len ] ) )
+      ++name_len;
+    if ( name_len != CACHE_KEY_LEN || de->d_name[ name_len ] != '\0' )
+      continue;
+
+    if ( files_len == files_cap ) {
+      files_cap = files_cap == 0 ? 64 : files_cap * 2;
+      REALLOC( files, files_cap );
+    }
+    cache_file_t *const file = &files[ files_len++ ];
+    strcpy( file->name, de->d_name );
+    file->size = STATIC_CAST( uint64_t, st.st_size );
+    file->mtime = cache_mtime( &st );
+    total += file->size;
+  } // for
+
+  if ( total > limit ) {
+    qsort( files, files_len, sizeof files[0], &cache_file_cmp );
+    for ( size_t i = 0; i < files_len && total > limit; ++i ) {
+      PJL_DISCARD_RV( unlinkat( dir_fd, files[i].name, 0 ) );
+      total -= files[i].size;
+    } // for
+  }
+
+  free( files );
+  closedir( d );
+}
+
+/**
+ * Adds \a len bytes of \a buf to \a key.
+ *
+ * @param key The key to add to.
+ * @param buf The bytes to add.
+ * @param len The number of bytes to add.
+ */
+static void cache_hash( cache_key_t *key, void const *buf, size_t len ) {
+  char8_t const *p = buf;
+  for ( size_t word_len = sizeof( uint64_t ); len > 0; p += word_len ) {
+    if ( len < word_len )
+      word_len = len;
+    uint64_t w = 0;
+    memcpy( &w, p, word_len );
+    len -= word_len;
+    // Two independent multiply-xorshift chains the CPU can run in parallel.
+    key->h[0] = (key->h[0] ^ w) * 0x9E3779B97F4A7C15ull;
+    key->h[0] ^= key->h[0] >> 29;
+    key->h[1] = (key->h[1] + w) * 0xC2B2AE3D27D4EB4Full;
+    key->h[1] ^= key->h[1] >> 31;
+  } // for
+}
+
+/**
+ * Finishes \a key so every bit of everything added affects every bit of it.
+ *
+ * @param key The key to finish.
+ */
+static void cache_key_final( cache_key_t *key ) {
+  FOREACH_ARRAY_ELEMENT( uint64_t, h, key->h ) {
+    uint64_t x = *h;
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDull;
+    x ^= x >> 33;
+    x *= 0xC4CEB9FE1A85EC53ull;
+    x ^= x >> 33;
+    *CONST_CAST( uint64_t*, h ) = x;
+  } // for
+}
+
+/**
+ * Adds the content of a file to \a key.
+ *
+ * @param key The key to add to.
+ * @param fd The file descriptor of the file or -1 for the input.
+ * @param path The path of the file.
+ */
+static void cache_hash_content( cache_key_t *key, int fd, char const *path ) {
+  char8_t *const buf = MALLOC( char8_t, CACHE_HASH_SIZE );
+  for ( off_t offset = 0;; ) {
+    ssize_t const bytes_read = fd == -1 ?
+      input_pread( buf, CACHE_HASH_SIZE, offset ) :
+      pread( fd, buf, CACHE_HASH_SIZE, offset );
+    if ( bytes_read == 0 )
+      break;
+    if ( unlikely( bytes_read == -1 ) )
+      fatal_error( EX_IOERR, "\"%s\": %s\n", path, STRERROR() );
+    cache_hash( key, buf, STATIC_CAST( size_t, bytes_read ) );
+    offset += bytes_read;
+  } // for
+  free( buf );
+}
+
+/**
+ * Adds the identity of a file to \a key.
+ *
+ * @param key The key to add to.
+ * @param st The status of the file.
+ */
+static void cache_hash_stat( cache_key_t *key, struct stat const *st ) {
+  uint64_t const identity[] = {
+    STATIC_CAST( uint64_t, st->st_dev ),
+    STATIC_CAST( uint64_t, st->st_ino ),
+    STATIC_CAST( uint64_t, st->st_size ),
+    STATIC_CAST( uint64_t, cache_mtime( st ) )
+  };
+  cache_hash( key, identity, sizeof identity );
+}
+
+/**
+ * Adds a string to \a key.
+ *
+ * @param key The key to add to.
+ * @param s The string to add or NULL.
+ */
+static void cache_hash_str( cache_key_t *key, char const *s ) {
+  bool const is_null = s == NULL;
+  cache_hash( key, &is_null, sizeof is_null );
+  if ( !is_null )
+    cache_hash( key, s, strlen( s ) + 1 );
+}
+
+/**
+ * Creates the cache directory and all its missing parent directories.
+ *
+ * @param dir The path of the cache directory.
+ * @return Returns `true` only if the directory exists.
+ */
+NODISCARD
+static bool cache_mkdirs( char const *dir ) {
+  char *const path = check_strdup( dir );
+  bool ok = true;
+  for ( char *slash = path; ok; ) {
+    slash = strchr( slash + 1, '/' );
+    if ( slash != NULL )
+      *slash = '\0';
+    ok = mkdir( path, 0755 ) == 0 || errno == EEXIST;
+    if ( slash == NULL )
+      break;
+    *slash = '/';
+  } // for
+  free( path );
+  return ok;
+}
+
+/**
+ * Parses the value of #CACHE_SIZE_ENV, if set.
+ *
+ * @return Returns the maximum total size of entries or prints an error message
+ * and exits if the value is invalid.
+ */
+NODISCARD
+static uint64_t cache_size_limit( void ) {
+  char const *const env = getenv( CACHE_SIZE_ENV );
+  if ( env == NULL || env[0] == '\0' )
+    return CACHE_SIZE_DEFAULT;
+  if ( isdigit( env[0] ) ) {
+    errno = 0;
+    char *end;
+    unsigned long long n = strtoull( env, &end, 10 );
+    if ( errno == 0 && (end[0] == '\0' || end[1] == '\0') ) {
+      switch ( end[0] ) {
+        case '\0':                                  return n;
+        case 'k'  : if ( n <= UINT64_MAX >> 10 )    return n << 10; break;
+        case 'm'  : if ( n <= UINT64_MAX >> 20 )    return n << 20; break;
+        case 'g'  : if ( n <= UINT64_MAX >> 30 )    return n << 30; break;
+      } // switch
+    }
+  }
+  fatal_error( EX_CONFIG,
+    "\"%s\": invalid value for %s; must be a size in bytes"
+    " optionally followed by k, m, or g\n",
+    env, CACHE_SIZE_ENV
+  );
+}
+
+/**
+ * Writes all bytes to a file descriptor.
+ *
+ * @param fd The file descriptor to write to.
+ * @param buf The bytes to write.
+ * @param buf_len The number of bytes in \a buf.
+ * @return Returns `true` only if all bytes were written.
+ */
+NODISCARD
+static bool cache_write_all( int fd, void const *buf, size_t buf_len ) {
+  for ( char8_t const *p = buf; buf_len > 0; ) {
+    ssize_t const n = write( fd, p, buf_len );
+    if ( n == -1 ) {
+      if ( errno == EINTR )
+        continue;
+      return false;
+    }
+    p += n;
+    buf_len -= STATIC_CAST( size_t, n );
+  } // for
+  return true;
+}
+
+/**
+ * Copies bytes from an entry file to a file descriptor.
+ *
+ * @param entry_fd The file descriptor of the entry file.
+ * @param offset The offset of the first byte to copy.
+ * @param len The number of bytes to copy.
+ * @param out_fd The file descriptor to copy to.
+ */
+static void cache_copy( int entry_fd, off_t offset, uint64_t len,
+                        int out_fd ) {
+  char8_t buf[ CACHE_PIPE_SIZE ];
+  while ( len > 0 ) {
+    size_t const want = len < sizeof buf ? STATIC_CAST( size_t, len ) :
+                                           sizeof buf;
+    ssize_t const bytes_read = pread( entry_fd, buf, want, offset );
+    PERROR_EXIT_IF( bytes_read <= 0, EX_IOERR );
+    size_t const n = STATIC_CAST( size_t, bytes_read );
+    PERROR_EXIT_IF( !cache_write_all( out_fd, buf, n ), EX_IOERR );
+    offset += bytes_read;
+    len -= n;
+  } // while
+}
+
+/**
+ * If \a entry_fd is a valid entry for \a key, copies its output and exits
+ * with its status.
+ *
+ * @param entry_fd The file descriptor of the entry file.
+ * @param key The key.
+ */
+static void cache_hit( int entry_fd, cache_key_t const *key ) {
+  cache_header_t header;
+  struct stat st;
+  if ( pread( entry_fd, &header, sizeof header, 0 ) != sizeof header ||
+       memcmp( header.magic, CACHE_MAGIC, sizeof header.magic ) != 0 ||
+       memcmp( &header.key, key, sizeof header.key ) != 0 ||
+       fstat( entry_fd, &st ) != 0 ||
+       STATIC_CAST( uint64_t, st.st_size ) !=
+         sizeof header + header.out_len + header.err_len ) {
+    return;
+  }
+
+  // Mark the entry as most recently used.
+  PJL_DISCARD_RV( futimens( entry_fd, NULL ) );
+
+  off_t const out_offset = sizeof header;
+  cache_copy( entry_fd, out_offset, header.out_len, STDOUT_FILENO );
+  cache_copy(
+    entry_fd, out_offset + STATIC_CAST( off_t, header.out_len ),
+    header.err_len, STDERR_FILENO
+  );
+  close( entry_fd );
+  exit( STATIC_CAST( int, header.status ) );
+}
+
+/**
+ * Forks a child to run as usual and copies its output to where it was going
+ * and to a temporary file that, if the child succeeds, becomes the entry.
+ *
+ * @param dir The path of the cache directory.
+ * @param entry_path The path of the entry file.
+ * @param key The key.
+ * @return Returns only in the child.
+ */
+static void cache_tee( char const *dir, char const *entry_path,
+                       cache_key_t const *key ) {
+  int out_pipe[2], err_pipe[2];
+  PERROR_EXIT_IF( pipe( out_pipe ) != 0 || pipe( err_pipe ) != 0, EX_OSERR );
+  FFLUSH( stdout );
+
+  pid_t const pid = fork();
+  PERROR_EXIT_IF( pid == -1, EX_OSERR );
+  if ( pid == 0 ) {                     // child: run as usual
+    DUP2( out_pipe[1], STDOUT_FILENO );
+    DUP2( err_pipe[1], STDERR_FILENO );
+    close( out_pipe[0] );
+    close( out_pipe[1] );
+    close( err_pipe[0] );
+    close( err_pipe[1] );
+    return;
+  }
+  close( out_pipe[1] );
+  close( err_pipe[1] );
+
+  uint64_t const limit = cache_size_limit();
+  cache_header_t header = { .key = *key };
+  memcpy( header.magic, CACHE_MAGIC, sizeof header.magic );
+
+  char *const tmp_path = free_later(
+    MALLOC( char, strlen( dir ) + sizeof "/" CACHE_TMP_PREFIX "XXXXXX" )
+  );
+  strcpy( tmp_path, dir );
+  strcat( tmp_path, "/" CACHE_TMP_PREFIX "XXXXXX" );
+  int tmp_fd = sizeof header <= limit ? mkstemp( tmp_path ) : -1;
+  if ( tmp_fd != -1 &&
+       lseek( tmp_fd, STATIC_CAST( off_t, sizeof header ), SEEK_SET ) == -1 ) {
+    close( tmp_fd );
+    PJL_DISCARD_RV( unlink( tmp_path ) );
+    tmp_fd = -1;
+  }
+
+  char8_t *err_buf = NULL;
+  size_t err_cap = 0;
+  char8_t *const buf = MALLOC( char8_t, CACHE_PIPE_SIZE );
+  struct pollfd fds[] = {
+    { .fd = out_pipe[0], .events = POLLIN },
+    { .fd = err_pipe[0], .events = POLLIN }
+  };
+
+  while ( fds[0].fd != -1 || fds[1].fd != -1 ) {
+    if ( poll( fds, ARRAY_SIZE( fds ), -1 ) == -1 ) {
+      PERROR_EXIT_IF( errno != EINTR, EX_OSERR );
+      continue;
+    }
+    // Copy only one chunk, preferring standard output, then poll again so any
+    // of standard output still in its pipe is copied before an error that
+    // followed it.
+    size_t const i = fds[0].revents != 0 ? 0 : 1;
+    ssize_t const bytes_read = read( fds[i].fd, buf, CACHE_PIPE_SIZE );
+    if ( bytes_read == -1 && errno == EINTR )
+      continue;
+    if ( bytes_read <= 0 ) {
+      close( fds[i].fd );
+      fds[i].fd = -1;
+      continue;
+    }
+    size_t const n = STATIC_CAST( size_t, bytes_read );
+    PERROR_EXIT_IF(
+      !cache_write_all( i == 0 ? STDOUT_FILENO : STDERR_FILENO, buf, n ),
+      EX_IOERR
+    );
+    if ( tmp_fd == -1 )
+      continue;
+
+    bool stored = sizeof header + header.out_len + header.err_len + n <= limit;
+    if ( stored && i == 0 ) {
+      stored = cache_write_all( tmp_fd, buf, n );
+      header.out_len += n;
+    }
+    else if ( stored ) {
+      if ( header.err_len + n > err_cap ) {
+        err_cap = err_cap == 0 ? CACHE_PIPE_SIZE : err_cap * 2;
+        if ( err_cap < header.err_len + n )
+          err_cap = STATIC_CAST( size_t, header.err_len ) + n;
+        REALLOC( err_buf, err_cap );
+      }
+      memcpy( err_buf + header.err_len, buf, n );
+      header.err_len += n;
+    }
+    if ( !stored ) {                    // too big: just copy from now on
+      close( tmp_fd );
+      PJL_DISCARD_RV( unlink( tmp_path ) );
+      tmp_fd = -1;
+    }
+  } // while
+  free( buf );
+
+  int wstatus;
+  while ( waitpid( pid, &wstatus, 0 ) == -1 )
+    PERROR_EXIT_IF( errno != EINTR, EX_OSERR );
+
+  int const status = WIFEXITED( wstatus ) ? WEXITSTATUS( wstatus ) : EX_OSERR;
+  if ( tmp_fd != -1 ) {
+    header.status = status;
+    // Only successful runs and those that found no matches are cached.
+    bool stored = status == EX_OK || status == EX_NO_MATCHES;
+    stored = stored && cache_write_all(
+      tmp_fd, err_buf, STATIC_CAST( size_t, header.err_len )
+    );
+    stored = stored &&
+      pwrite( tmp_fd, &header, sizeof header, 0 ) == sizeof header;
+    stored = close( tmp_fd ) == 0 && stored;
+    stored = stored && rename( tmp_path, entry_path ) == 0;
+    if ( !stored )
+      PJL_DISCARD_RV( unlink( tmp_path ) );
+  }
+  cache_evict( dir, limit );
+  free( err_buf );
+
+  if ( WIFSIGNALED( wstatus ) ) {       // die the same way the child did
+    signal( WTERMSIG( wstatus ), SIG_DFL );
+    raise( WTERMSIG( wstatus ) );
+  }
+  exit( status );
+}
+
+////////// extern functions ///////////////////////////////////////////////////
+
+/**
+ * Either copies the cached output and exits with the cached status or forks a
+ * child to run as usual and caches its output.
+ *
+ * @remarks The input must be a regular file (or, when keyed by content, a
+ * block device or split input); otherwise, or if the output can't be the same
+ * every run, does nothing.
+ *
+ * @note This function must be called after colors_init() since colors affect
+ * the output.
+ */
+void cache_run( void ) {
+  assert( opt_cache != CACHE_NONE );
+  if ( opt_sample_random )              // output differs every run
+    return;
+
+  cache_key_t key = { { 0x6A09E667F3BCC908ull, 0xBB67AE8584CAA73Bull } };
+  cache_hash_str( &key, PACKAGE_STRING );
+  size_t options_len;
+  char const *const options = options_normalized( &options_len );
+  cache_hash( &key, options, options_len );
+
+  // The input's name since it's in, e.g., -C output and error messages.
+  cache_hash_str( &key, fin_path );
+
+  // Values not given by options alone, e.g., an offset given as +offset.
+  uint64_t const values[] = {
+    STATIC_CAST( uint64_t, fin_offset ),
+    opt_max_bytes,
+    opt_utf8
+  };
+  cache_hash( &key, values, sizeof values );
+
+  cache_hash_str( &key, sgr_ascii_match );
+  cache_hash_str( &key, sgr_elided );
+  cache_hash_str( &key, sgr_hex_match );
+  cache_hash_str( &key, sgr_offset );
+  cache_hash_str( &key, sgr_sep );
+  FOREACH_ARRAY_ELEMENT( char const*, sgr, sgr_byte_class )
+    cache_hash_str( &key, *sgr );
+
+  if ( opt_cache == CACHE_STAT ) {
+    struct stat st;
+    if ( opt_split || fstat( STDIN_FILENO, &st ) != 0 ||
+         !S_ISREG( st.st_mode ) ) {
+      return;
+    }
+    cache_hash_stat( &key, &st );
+  }
+  else {
+    if ( input_size() == -1 )
+      return;
+    cache_hash_content( &key, -1, fin_path );
+  }
+
+  // Other files read whose content affects the output.
+  char const *const paths[] = {
+    opt_address_map_path, opt_bit_errors_path, opt_verify_path
+  };
+  FOREACH_ARRAY_ELEMENT( char const*, path, paths ) {
+    if ( *path == NULL )
+      continue;
+    int const fd = open( *path, O_RDONLY );
+    if ( fd == -1 )
+      continue;                         // reported when it's read
+    struct stat st;
+    if ( fstat( fd, &st ) == 0 ) {
+      if ( opt_cache == CACHE_STAT )
+        cache_hash_stat( &key, &st );
+      else
+        cache_hash_content( &key, fd, *path );
+    }
+    close( fd );
+  } // for
+
+  cache_key_final( &key );
+
+  char const *const dir = cache_dir();
+  if ( dir == NULL ) {
+    EPRINTF( "%s: no cache directory: set %s, XDG_CACHE_HOME, or HOME;"
+      " not caching\n", me, CACHE_DIR_ENV
+    );
+    return;
+  }
+  if ( !cache_mkdirs( dir ) ) {
+    EPRINTF( "%s: \"%s\": %s; not caching\n", me, dir, STRERROR() );
+    return;
+  }
+
+  char *const entry_path = free_later(
+    MALLOC( char, strlen( dir ) + 1/*/*/ + CACHE_KEY_LEN + 1/*\0*/ )
+  );
+  sprintf( entry_path,
+    "%s/%016" PRIx64 "%016" PRIx64, dir, key.h[0], key.h[1]
+  );
+
+  int const entry_fd = open( entry_path, O_RDONLY );
+  if ( entry_fd != -1 ) {
+    cache_hit( entry_fd, &key );        // returns only if invalid
+    close( entry_fd );
+  }
+  cache_tee( dir, entry_path, &key );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/** @} */
+
+/* vim:set et sw=2 ts=2: */
@@ -79,11 +79,19 @@ typedef struct color_cap color_cap_t;
 
 // extern variable definitions
 char const *sgr_ascii_match;
+char const *sgr_byte_class[ 256 ];
 char const *sgr_elided;
 char const *sgr_hex_match;
 char const *sgr_offset;
 char const *sgr_sep;
 
+// local variable definitions
+static char const  *sgr_class_high;     ///< Non-ASCII byte color.
+static char const  *sgr_class_other;    ///< Other ASCII byte color.
+static char const  *sgr_class_print;    ///< Printable ASCII byte color.
+static char const  *sgr_class_space;    ///< Whitespace ASCII byte color.
+static char const  *sgr_class_zero;     ///< Null byte color.
+
 // local functions
 NODISCARD
 static bool sgr_is_valid( char const* );
@@ -180,6 +188,11 @@ static bool colors_parse( char const *capabilities ) {
 
     static color_cap_t const COLOR_CAPS[] = {
       { "bn", SET_SGR( offset       ) },    // grep: byte offset
+      { "CN", SET_SGR( class_high   ) },    // class: non-ASCII
+      { "CO", SET_SGR( class_other  ) },    // class: other ASCII
+      { "CP", SET_SGR( class_print  ) },    // class: printable ASCII
+      { "CW", SET_SGR( class_space  ) },    // class: whitespace ASCII
+      { "CZ", SET_SGR( class_zero   ) },    // class: null
       { "EC", SET_SGR( elided       ) },    // elided count
       { "MA", SET_SGR( ascii_match  ) },    // matched ASCII
       { "MH", SET_SGR( hex_match    ) },    // matched hex
@@ -205,6 +218,26 @@ static bool colors_parse( char const *capabilities ) {
   return set_any;
 }
 
+/**
+ * Initializes \ref sgr_byte_class from the byte class colors, if any.
+ */
+static void colors_class_init( void ) {
+  for ( unsigned byte = 0; byte < ARRAY_SIZE( sgr_byte_class ); ++byte ) {
+    char const *sgr_color;
+    if ( byte == '\0' )
+      sgr_color = sgr_class_zero;
+    else if ( byte >= 0x80 )
+      sgr_color = sgr_class_high;
+    else if ( byte == ' ' || (byte >= '\t' && byte <= '\r') )
+      sgr_color = sgr_class_space;
+    else if ( byte > ' ' && byte < 0x7F )
+      sgr_color = sgr_class_print;
+    else
+      sgr_color = sgr_class_other;
+    sgr_byte_class[ byte ] = sgr_color;
+  } // for
+}
+
 /**
  * Determines whether we should emit escape sequences for color.
  *
@@ -250,8 +283,10 @@ void colors_init( void ) {
 
   if ( !should_colorize( opt_color_when ) )
     return;
-  if ( colors_parse( getenv( "AD_COLORS" ) ) )
+  if ( colors_parse( getenv( "AD_COLORS" ) ) ) {
+    colors_class_init();
     return;
+  }
 
   char const COLORS_DEFAULT[] =
     COLOR_CAP_BYTE_OFFSET   "=" SGR_FG_GREEN                      SGR_CAP_SEP
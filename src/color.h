@@ -111,6 +111,16 @@ typedef enum color_when color_when_t;
 
 // extern variables
 extern char const  *sgr_ascii_match;    ///< ASCII match color.
+
+/**
+ * Color for each byte value according to its class (null, printable,
+ * whitespace, other ASCII, or non-ASCII) or NULL if none.
+ *
+ * @remarks Precomputing the color for every byte value means that coloring by
+ * class requires only a table lookup per byte.
+ */
+extern char const  *sgr_byte_class[ 256 ];
+
 extern char const  *sgr_elided;         ///< Elided byte count color.
 extern char const  *sgr_hex_match;      ///< Hex match color.
 extern char const  *sgr_offset;         ///< Offset color.
@@ -0,0 +1,442 @@
+/*
+**      ad -- ASCII dump
+**      src/compress.c
+**
+**      Copyright (C) 2024  Paul J. Lucas
+**
+**      This program is free software: you can redistribute it and/or modify
+**      it under the terms of the GNU General Public License as published by
+**      the Free Software Foundation, either version 3 of the License, or
+**      (at your option) any later version.
+**
+**      This program is distributed in the hope that it will be useful,
+**      but WITHOUT ANY WARRANTY; without even the implied warranty of
+**      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**      GNU General Public License for more details.
+**
+**      You should have received a copy of the GNU General Public License
+**      along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * Defines functions for compressing output.
+ */
+
+// local
+#include "pjl_config.h"                 /* must go first */
+#include "ad.h"
+#include "options.h"
+#include "parallel.h"
+#include "util.h"
+
+/// @cond DOXYGEN_IGNORE
+
+// standard
+#include <assert.h>
+#include <stddef.h>                     /* for size_t */
+#include <stdint.h>                     /* for uint*_t */
+#include <stdio.h>
+#include <stdlib.h>                     /* for free() */
+#include <string.h>                     /* for memcpy(), memset() */
+#include <sys/types.h>                  /* for ssize_t */
+#include <sysexits.h>
+#include <unistd.h>                     /* for write(2), STDOUT_FILENO */
+#ifdef HAVE_ZLIB_H
+#include <zlib.h>
+#endif /* HAVE_ZLIB_H */
+
+/// @endcond
+
+/**
+ * @defgroup compress-group Compressing Output
+ * Functions for compressing output.
+ *
+ * @remarks Output is compressed in the BGZF (blocked gzip) format: a series of
+ * gzip members of at most 64 KiB each with the compressed size of each in an
+ * extra field, followed by an empty end-of-file member.  Since every member
+ * is independent, members are compressed in parallel; and since the size of
+ * each is known, readers can seek within the output without decompressing all
+ * of it.  Any **gzip**(1) can decompress it.
+ * @{
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+
+#if defined(HAVE_ZLIB_H) && (defined(HAVE_FOPENCOOKIE) || defined(HAVE_FUNOPEN))
+
+#define BGZF_BATCH_BLOCKS   64u         /**< Blocks compressed at a time.   */
+#define BGZF_BLOCK_DATA     0xFF00u     /**< Max uncompressed block bytes.  */
+#define BGZF_BLOCK_SIZE     0x10000u    /**< Max compressed block bytes.    */
+#define BGZF_HEADER_SIZE    18u         /**< Bytes of member header.        */
+#define BGZF_FOOTER_SIZE    8u          /**< Bytes of CRC32 + ISIZE.        */
+
+/**
+ * A block of compressed output.
+ */
+struct bgzf_block {
+  char8_t   buf[ BGZF_BLOCK_SIZE ];     ///< Complete gzip member.
+  size_t    len;                        ///< Length of \ref buf.
+};
+typedef struct bgzf_block bgzf_block_t;
+
+/**
+ * State of compressing output.
+ */
+struct bgzf_writer {
+  FILE         *zout;                   ///< Compressing stream, if any.
+  char8_t      *data;                   ///< Uncompressed data of a batch.
+  size_t        data_len;               ///< Length of \ref data.
+  bgzf_block_t *blocks;                 ///< Compressed blocks of a batch.
+  z_stream     *zs;                     ///< Per-worker compression state.
+  bool         *zs_init;                ///< Whether each \ref zs is init'd.
+  unsigned      zs_len;                 ///< Length of \ref zs.
+  bool          flushing;               ///< Is a batch being compressed?
+
+  /**
+   * If `true`, compress on the calling thread and report errors rather than
+   * exiting: set only when finishing via `atexit()` where neither calling
+   * par_for() nor `exit()` is safe.
+   */
+  bool          serial;
+
+  bool          failed;                 ///< Did a serial write fail?
+};
+typedef struct bgzf_writer bgzf_writer_t;
+
+static bgzf_writer_t  writer;           ///< The one output writer.
+
+////////// local functions ////////////////////////////////////////////////////
+
+/**
+ * Stores a 16-bit value in little-endian order.
+ *
+ * @param p A pointer to the bytes to store into.
+ * @param n The value to store.
+ */
+static inline void put_le16( char8_t *p, uint32_t n ) {
+  p[0] = STATIC_CAST( char8_t, n );
+  p[1] = STATIC_CAST( char8_t, n >> 8 );
+}
+
+/**
+ * Stores a 32-bit value in little-endian order.
+ *
+ * @param p A pointer to the bytes to store into.
+ * @param n The value to store.
+ */
+static inline void put_le32( char8_t *p, uint32_t n ) {
+  put_le16( p, n );
+  put_le16( p + 2, n >> 16 );
+}
+
+/**
+ * Writes all bytes to standard output.
+ *
+ * @param w The \ref bgzf_writer to use.
+ * @param buf The bytes to write.
+ * @param buf_len The number of bytes in \a buf.
+ */
+static void bgzf_write_all( bgzf_writer_t *w, char8_t const *buf,
+                            size_t buf_len ) {
+  while ( buf_len > 0 && !w->failed ) {
+    ssize_t const n = write( STDOUT_FILENO, buf, buf_len );
+    if ( unlikely( n < 0 ) ) {
+      PERROR_EXIT_IF( !w->serial, EX_IOERR );
+      EPRINTF( "%s: compressed output: %s\n", me, STRERROR() );
+      w->failed = true;
+      return;
+    }
+    buf += n;
+    buf_len -= STATIC_CAST( size_t, n );
+  } // while
+}
+
+/**
+ * Compresses bytes as a single raw deflate stream.
+ *
+ * @param zs The compression state to use.
+ * @param level The compression level.
+ * @param in The bytes to compress.
+ * @param in_len The number of bytes in \a in.
+ * @param out The buffer to compress into.
+ * @param out_max The size of \a out.
+ * @return Returns the number of compressed bytes or 0 if they don't fit into
+ * \a out.
+ */
+NODISCARD
+static size_t bgzf_deflate( z_stream *zs, int level, char8_t const *in,
+                            size_t in_len, char8_t *out, size_t out_max ) {
+  deflateReset( zs );
+  zs->next_out = out;
+  zs->avail_out = STATIC_CAST( uInt, out_max );
+  deflateParams( zs, level, Z_DEFAULT_STRATEGY );
+  zs->next_in = POINTER_CAST( Bytef*, in );
+  zs->avail_in = STATIC_CAST( uInt, in_len );
+  if ( deflate( zs, Z_FINISH ) != Z_STREAM_END )
+    return 0;
+  return out_max - zs->avail_out;
+}
+
+/**
+ * Compresses one block of a batch.
+ *
+ * @param w The \ref bgzf_writer to use.
+ * @param task The block number.
+ * @param worker The worker number.
+ * @return Returns `true` only if the block was compressed.
+ */
+NODISCARD
+static bool bgzf_compress( bgzf_writer_t *w, size_t task, unsigned worker ) {
+  size_t const begin = task * BGZF_BLOCK_DATA;
+  assert( begin < w->data_len );
+  size_t const len = w->data_len - begin < BGZF_BLOCK_DATA ?
+    w->data_len - begin : BGZF_BLOCK_DATA;
+  char8_t const *const in = w->data + begin;
+  bgzf_block_t *const block = &w->blocks[ task ];
+  z_stream *const zs = &w->zs[ worker ];
+
+  if ( !w->zs_init[ worker ] ) {
+    if ( unlikely( deflateInit2( zs, STATIC_CAST( int, opt_output_compress ),
+                                 Z_DEFLATED, -MAX_WBITS, 8,
+                                 Z_DEFAULT_STRATEGY ) != Z_OK ) ) {
+      return false;
+    }
+    w->zs_init[ worker ] = true;
+  }
+
+  size_t const out_max = BGZF_BLOCK_SIZE - BGZF_HEADER_SIZE - BGZF_FOOTER_SIZE;
+  size_t zlen = bgzf_deflate(
+    zs, STATIC_CAST( int, opt_output_compress ), in, len,
+    block->buf + BGZF_HEADER_SIZE, out_max
+  );
+  if ( zlen == 0 ) {
+    //
+    // Incompressible data can expand beyond the block size, so store it
+    // instead: that adds only 5 bytes per 64 KiB.
+    //
+    zlen = bgzf_deflate(
+      zs, Z_NO_COMPRESSION, in, len, block->buf + BGZF_HEADER_SIZE, out_max
+    );
+    if ( unlikely( zlen == 0 ) )
+      return false;
+  }
+
+  static char8_t const HEADER[ BGZF_HEADER_SIZE - 2 ] = {
+    0x1F, 0x8B,                         // gzip magic number
+    8,                                  // CM = deflate
+    4,                                  // FLG = FEXTRA
+    0, 0, 0, 0,                         // MTIME
+    0,                                  // XFL
+    0xFF,                               // OS = unknown
+    6, 0,                               // XLEN
+    'B', 'C', 2, 0                      // BGZF subfield with 2 bytes
+  };
+  memcpy( block->buf, HEADER, sizeof HEADER );
+  block->len = BGZF_HEADER_SIZE + zlen + BGZF_FOOTER_SIZE;
+  put_le16( block->buf + sizeof HEADER,
+            STATIC_CAST( uint32_t, block->len - 1 ) );
+
+  char8_t *const footer = block->buf + BGZF_HEADER_SIZE + zlen;
+  put_le32( footer,
+    STATIC_CAST( uint32_t, crc32( 0, in, STATIC_CAST( uInt, len ) ) )
+  );
+  put_le32( footer + 4, STATIC_CAST( uint32_t, len ) );
+  return true;
+}
+
+/**
+ * Compresses one block of a batch as a parallel task.
+ *
+ * @param data A pointer to the \ref bgzf_writer.
+ * @param task The block number.
+ * @param worker The worker number.
+ */
+static void bgzf_task( void *data, size_t task, unsigned worker ) {
+  if ( unlikely( !bgzf_compress( data, task, worker ) ) )
+    INTERNAL_ERROR( "%s\n", "deflate() failed" );
+}
+
+/**
+ * Compresses and writes all buffered data.
+ *
+ * @param w The \ref bgzf_writer to use.
+ */
+static void bgzf_flush( bgzf_writer_t *w ) {
+  if ( w->data_len == 0 )
+    return;
+  size_t const n_blocks =
+    (w->data_len + BGZF_BLOCK_DATA - 1) / BGZF_BLOCK_DATA;
+  w->flushing = true;
+  if ( w->serial ) {
+    for ( size_t i = 0; i < n_blocks && !w->failed; ++i ) {
+      if ( unlikely( !bgzf_compress( w, i, 0 ) ) ) {
+        EPRINTF( "%s: compressed output: deflate() failed\n", me );
+        w->failed = true;
+      }
+    } // for
+  }
+  else {
+    par_for( n_blocks, &bgzf_task, w );
+  }
+  for ( size_t i = 0; i < n_blocks; ++i )
+    bgzf_write_all( w, w->blocks[i].buf, w->blocks[i].len );
+  w->data_len = 0;
+  w->flushing = false;
+}
+
+/**
+ * Buffers output, compressing it whenever a batch is full.
+ *
+ * @param cookie A pointer to the \ref bgzf_writer.
+ * @param buf The bytes to write.
+ * @param buf_len The number of bytes in \a buf.
+ * @return Returns \a buf_len.
+ */
+static ssize_t bgzf_cookie_write( void *cookie, char const *buf,
+                                  size_t buf_len ) {
+  bgzf_writer_t *const w = cookie;
+  size_t const batch_size = BGZF_BATCH_BLOCKS * BGZF_BLOCK_DATA;
+  for ( size_t left = buf_len; left > 0; ) {
+    size_t const room = batch_size - w->data_len;
+    size_t const n = left < room ? left : room;
+    memcpy( w->data + w->data_len, buf, n );
+    w->data_len += n;
+    buf += n;
+    left -= n;
+    if ( w->data_len == batch_size )
+      bgzf_flush( w );
+  } // for
+  return STATIC_CAST( ssize_t, buf_len );
+}
+
+/**
+ * Compresses all remaining data and writes the end-of-file block.
+ *
+ * @param cookie A pointer to the \ref bgzf_writer.
+ * @return Returns 0 only if all output was written.
+ */
+static int bgzf_cookie_close( void *cookie ) {
+  bgzf_writer_t *const w = cookie;
+  bgzf_flush( w );
+
+  static char8_t const EOF_BLOCK[] = {
+    0x1F, 0x8B, 8, 4, 0, 0, 0, 0, 0, 0xFF, 6, 0, 'B', 'C', 2, 0,
+    0x1B, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0
+  };
+  bgzf_write_all( w, EOF_BLOCK, sizeof EOF_BLOCK );
+
+  for ( unsigned i = 0; i < w->zs_len; ++i ) {
+    if ( w->zs_init[i] )
+      deflateEnd( &w->zs[i] );
+  } // for
+  free( w->data );
+  free( w->blocks );
+  free( w->zs );
+  free( w->zs_init );
+  return w->failed ? -1 : 0;
+}
+
+#ifdef HAVE_FUNOPEN
+/**
+ * Adapts bgzf_cookie_write() to the signature required by **funopen**(3).
+ *
+ * @param cookie A pointer to the \ref bgzf_writer.
+ * @param buf The bytes to write.
+ * @param buf_len The number of bytes in \a buf.
+ * @return Returns \a buf_len.
+ */
+static int bgzf_funopen_write( void *cookie, char const *buf, int buf_len ) {
+  return STATIC_CAST( int,
+    bgzf_cookie_write( cookie, buf, STATIC_CAST( size_t, buf_len ) )
+  );
+}
+#endif /* HAVE_FUNOPEN */
+
+#endif /* HAVE_ZLIB_H && (HAVE_FOPENCOOKIE || HAVE_FUNOPEN) */
+
+////////// extern functions ///////////////////////////////////////////////////
+
+/**
+ * Finishes compressed output, if any, when exiting before compress_finish()
+ * was called.
+ *
+ * @remarks This is called via `atexit()`, so it compresses on the calling
+ * thread and only reports errors.  If a batch was being compressed when
+ * `exit()` was called, the writer is in an unknown state, so the output is
+ * left truncated.
+ *
+ * @sa compress_finish()
+ */
+void compress_cleanup( void ) {
+#if defined(HAVE_ZLIB_H) && (defined(HAVE_FOPENCOOKIE) || defined(HAVE_FUNOPEN))
+  FILE *const zout = writer.zout;
+  if ( zout == NULL )
+    return;
+  writer.zout = NULL;
+  fout = stdout;
+  if ( writer.flushing ) {
+    EPRINTF( "%s: compressed output truncated\n", me );
+    return;
+  }
+  writer.serial = true;
+  PJL_DISCARD_RV( fclose( zout ) );
+#endif /* HAVE_ZLIB_H && (HAVE_FOPENCOOKIE || HAVE_FUNOPEN) */
+}
+
+/**
+ * Finishes compressed output, if any, by compressing all remaining data and
+ * writing the end-of-file block.
+ *
+ * @remarks This must be called before par_cleanup().
+ *
+ * @sa compress_cleanup()
+ */
+void compress_finish( void ) {
+#if defined(HAVE_ZLIB_H) && (defined(HAVE_FOPENCOOKIE) || defined(HAVE_FUNOPEN))
+  FILE *const zout = writer.zout;
+  if ( zout == NULL )
+    return;
+  writer.zout = NULL;
+  fout = stdout;
+  PERROR_EXIT_IF( fclose( zout ) != 0, EX_IOERR );
+#endif /* HAVE_ZLIB_H && (HAVE_FOPENCOOKIE || HAVE_FUNOPEN) */
+}
+
+/**
+ * Initializes compressed output by setting \ref fout to a stream that
+ * compresses everything written to it into standard output.
+ */
+void compress_init( void ) {
+#if defined(HAVE_ZLIB_H) && (defined(HAVE_FOPENCOOKIE) || defined(HAVE_FUNOPEN))
+  assert( opt_output_compress > 0 );
+  unsigned const jobs = par_jobs();
+  writer = (bgzf_writer_t){
+    .data = MALLOC( char8_t, BGZF_BATCH_BLOCKS * BGZF_BLOCK_DATA ),
+    .blocks = MALLOC( bgzf_block_t, BGZF_BATCH_BLOCKS ),
+    .zs = MALLOC( z_stream, jobs ),
+    .zs_init = MALLOC( bool, jobs ),
+    .zs_len = jobs
+  };
+  memset( writer.zs, 0, jobs * sizeof *writer.zs );
+  memset( writer.zs_init, 0, jobs * sizeof *writer.zs_init );
+
+#ifdef HAVE_FOPENCOOKIE
+  writer.zout = fopencookie( &writer, "w", (cookie_io_functions_t){
+    .write = &bgzf_cookie_write,
+    .close = &bgzf_cookie_close
+  } );
+#else
+  writer.zout =
+    funopen( &writer, NULL, &bgzf_funopen_write, NULL, &bgzf_cookie_close );
+#endif /* HAVE_FOPENCOOKIE */
+  PERROR_EXIT_IF( writer.zout == NULL, EX_OSERR );
+  fout = writer.zout;
+#endif /* HAVE_ZLIB_H && (HAVE_FOPENCOOKIE || HAVE_FUNOPEN) */
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/** @} */
+
+/* vim:set et sw=2 ts=2: */
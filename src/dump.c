@@ -26,9 +26,14 @@
 // local
 #include "pjl_config.h"                 /* must go first */
 #include "ad.h"
+#include "address_map.h"
 #include "color.h"
+#include "input.h"
+#include "line_index.h"
 #include "match.h"
 #include "options.h"
+#include "output.h"
+#include "parallel.h"
 #include "unicode.h"
 #include "util.h"
 
@@ -38,6 +43,7 @@
 #include <assert.h>
 #include <ctype.h>
 #include <inttypes.h>                   /* for PRIu64, etc. */
+#include <math.h>                       /* for log2(), sqrt() */
 #include <stddef.h>                     /* for size_t */
 #include <stdio.h>
 #include <stdlib.h>                     /* for exit() */
@@ -55,33 +61,138 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 /**
- * Convenience macro that calls color_start() only if \a EXPR is `true`.
- *
- * @param EXPR The expression.
+ * Buffer for row of data.
+ */
+struct row_buf {
+  char8_t       bytes[ ROW_BYTES_MAX ]; ///< Bytes in buffer, left-to-right.
+  size_t        len;                    ///< Length of buffer.
+  match_bits_t  match_bits;             ///< Which bytes match, right-to-left.
+};
+typedef struct row_buf row_buf_t;
+
+#ifdef HAVE_OPEN_MEMSTREAM
+#define ROW_CACHE_BYPASS_ROWS (64 * 1024u) /**< Rows not cached if useless. */
+#define ROW_CACHE_ENTRIES   32u         /**< Rendered rows cached.          */
+#define ROW_CACHE_PROBE_ROWS 1024u      /**< Rows to measure hit rate over. */
+#define ROW_CACHE_TEXT_MAX  480u        /**< Max bytes of a cached row.     */
+
+/**
+ * A cached rendering of the hex and ASCII parts of a row.
  */
-#define COLOR_START_IF(EXPR,COLOR) \
-  BLOCK( if ( EXPR ) color_start( stdout, (COLOR) ); )
+struct row_cache_entry {
+  char8_t       bytes[ ROW_BYTES_MAX ]; ///< Bytes of the row.
+  size_t        bytes_len;              ///< Length of \ref bytes; 0 if unused.
+  char          text[ ROW_CACHE_TEXT_MAX ]; ///< Rendered row.
+  size_t        text_len;               ///< Length of \ref text.
+};
+typedef struct row_cache_entry row_cache_entry_t;
 
 /**
- * Convenience macro that calls color_end() only if \a EXPR is `true`.
+ * A direct-mapped cache of rendered rows keyed by a hash of their bytes so
+ * repeated rows (that aren't elided because of \ref opt_verbose) are printed
+ * with a copy.  It's small enough to fit in L1 cache.
  *
- * @param EXPR The expression.
+ * @remarks Since rendering a row into the cache costs more than rendering it
+ * directly, the hit rate is measured over every #ROW_CACHE_PROBE_ROWS rows;
+ * if it's too low, the cache is bypassed for the next #ROW_CACHE_BYPASS_ROWS
+ * rows.
  */
-#define COLOR_END_IF(EXPR,COLOR) \
-  BLOCK( if ( EXPR ) color_end( stdout, (COLOR) ); )
+struct row_cache {
+  row_cache_entry_t entries[ ROW_CACHE_ENTRIES ]; ///< Cached rows.
+  FILE             *mem_file;           ///< Stream to render rows into.
+  char             *mem_buf;            ///< Buffer of \ref mem_file.
+  size_t            mem_size;           ///< Size of \ref mem_buf.
+  unsigned          probe_rows;         ///< Rows looked up while probing.
+  unsigned          probe_hits;         ///< Rows found while probing.
+  unsigned          bypass_rows;        ///< Rows left to bypass cache for.
+};
+typedef struct row_cache row_cache_t;
+
+static row_cache_t *row_cache;          ///< Rendered rows, if used.
+#endif /* HAVE_OPEN_MEMSTREAM */
+
+#define BIT_ERRORS_BATCH_BYTES (4u * 1024 * 1024) /**< Bytes per batch.   */
+#define BIT_ERRORS_WORST    10u         /**< Worst blocks to report.        */
 
 /**
- * Buffer for row of data.
+ * A block of bytes compared against its reference.
  */
-struct row_buf {
-  char8_t       bytes[ ROW_BYTES_MAX ]; ///< Bytes in buffer, left-to-right.
-  size_t        len;                    ///< Length of buffer.
-  match_bits_t  match_bits;             ///< Which bytes match, right-to-left.
+struct bit_errors_block {
+  off_t         offset;                 ///< File offset of first byte.
+  size_t        len;                    ///< Number of bytes.
+  uint64_t      cleared;                ///< Bits that are 0 but should be 1.
+  uint64_t      set;                    ///< Bits that are 1 but should be 0.
 };
-typedef struct row_buf row_buf_t;
+typedef struct bit_errors_block bit_errors_block_t;
+
+/**
+ * Data shared by all tasks of a batch of blocks compared for bit errors.
+ */
+struct bit_errors_job {
+  size_t              block_size;       ///< Bytes per block.
+  bit_errors_block_t *blocks;           ///< Blocks of current batch.
+  char8_t            *bytes;            ///< Bytes of current batch.
+  char8_t            *ref;              ///< Reference bytes of current batch.
+  bool               *flags;            ///< Which bytes differ, if dumping.
+};
+typedef struct bit_errors_job bit_errors_job_t;
+
+/**
+ * A sampled block of bytes and its statistics.
+ */
+struct sample_block {
+  off_t         offset;                 ///< File offset of first byte.
+  size_t        len;                    ///< Number of bytes read.
+  size_t        zeros;                  ///< Number of null bytes.
+  size_t        matches;                ///< Number of matches.
+  double        entropy;                ///< Entropy in bits per byte.
+};
+typedef struct sample_block sample_block_t;
+
+/**
+ * Data shared by all tasks of a batch of sampled blocks.
+ */
+struct sample_job {
+  off_t           begin;                ///< File offset of first block.
+  off_t           end;                  ///< File offset of end.
+  uint64_t        blocks_len;           ///< Number of blocks in the file.
+  uint64_t        samples_len;          ///< Number of blocks to sample.
+  uint64_t        batch_first;          ///< First sample of current batch.
+  size_t          block_size;           ///< Bytes per block.
+  size_t const   *kmps;                 ///< KMP table, if searching.
+  sample_block_t *blocks;               ///< Blocks of current batch.
+  char8_t        *bytes;                ///< Bytes of current batch.
+  bool           *flags;                ///< Which bytes match.
+};
+typedef struct sample_job sample_job_t;
+
+/**
+ * Sums of a per-block statistic for estimating its mean.
+ */
+struct sample_stat {
+  double        sum;                    ///< Sum of values.
+  double        sum2;                   ///< Sum of squared values.
+};
+typedef struct sample_stat sample_stat_t;
 
 ////////// inline functions ///////////////////////////////////////////////////
 
+/**
+ * Gets the color to print a byte in.
+ *
+ * @param row A pointer to the row containing the byte.
+ * @param pos The position of the byte within \a row.
+ * @param sgr_match The color to use if the byte matches.
+ * @return Returns \a sgr_match if the byte matches; otherwise the color of
+ * the byte's class, if any; otherwise NULL.
+ */
+NODISCARD
+static inline char const* byte_sgr( row_buf_t const *row, size_t pos,
+                                    char const *sgr_match ) {
+  return (row->match_bits & (STATIC_CAST( match_bits_t, 1 ) << pos)) != 0 ?
+    sgr_match : sgr_byte_class[ row->bytes[ pos ] ];
+}
+
 /**
  * Gets whether to print an extra space between byte columns for readability.
  *
@@ -137,80 +248,43 @@ static unsigned utf8_collect( row_buf_t const *curr, size_t curr_pos,
 }
 
 /**
- * Dumps a single row of bytes containing the offset and hex and ASCII parts.
+ * Dumps the hex and ASCII parts of a row of bytes.
  *
- * @param offset_format The \c printf() format for the offset.
+ * @param out The `FILE` to dump to.
  * @param curr A pointer to the current \a row_buf.
  * @param next A pointer to the next \a row_buf.
  */
-static void dump_row( char const *offset_format, row_buf_t const *curr,
-                      row_buf_t const *next ) {
-  assert( offset_format != NULL );
+static void dump_row_body( FILE *out, row_buf_t const *curr,
+                           row_buf_t const *next ) {
+  assert( out != NULL );
   assert( curr != NULL );
   assert( next != NULL );
 
-  static bool   any_dumped = false;     // any data dumped yet?
-  static off_t  dumped_offset = -1;     // offset of most recently dumped row
-
-  if ( dumped_offset == -1 )
-    dumped_offset = fin_offset;
-
-  size_t  curr_pos;
-  bool    prev_matches;
-
-  // print row separator (if necessary)
-  if ( !opt_only_matching && !opt_only_printing ) {
-    uint64_t const offset_delta = STATIC_CAST( uint64_t,
-      fin_offset - dumped_offset - STATIC_CAST( off_t, row_bytes )
-    );
-    if ( offset_delta > 0 && any_dumped ) {
-      color_start( stdout, sgr_elided );
-      for ( unsigned i = get_offsets_width(); i > 0; --i )
-        PUTC( ELIDED_SEP_CHAR );
-      color_end( stdout, sgr_elided );
-      color_start( stdout, sgr_sep );
-      PUTC( ':' );
-      color_end( stdout, sgr_sep );
-      PUTC( ' ' );
-      color_start( stdout, sgr_elided );
-      PRINTF( "(%" PRIu64 " | 0x%" PRIX64 ")", offset_delta, offset_delta );
-      color_end( stdout, sgr_elided );
-      PUTC( '\n' );
-    }
-  }
-
-  // print offset & column separator
-  if ( opt_offsets != OFFSETS_NONE ) {
-    color_start( stdout, sgr_offset );
-    PRINTF( offset_format, STATIC_CAST(uint64_t, fin_offset) );
-    color_end( stdout, sgr_offset );
-    color_start( stdout, sgr_sep );
-    PUTC( ':' );
-    color_end( stdout, sgr_sep );
-  }
+  size_t      curr_pos;
+  char const *prev_sgr;                 // color of previous byte, if any
 
   // dump hex part
-  prev_matches = false;
+  prev_sgr = NULL;
   for ( curr_pos = 0; curr_pos < curr->len; ++curr_pos ) {
-    bool const matches = (curr->match_bits & (1u << curr_pos)) != 0;
-    bool const matches_changed = matches != prev_matches;
+    char8_t const byte = curr->bytes[ curr_pos ];
+    char const *const sgr = byte_sgr( curr, curr_pos, sgr_hex_match );
 
     if ( curr_pos % opt_group_by == 0 ) {
-      COLOR_END_IF( prev_matches, sgr_hex_match );
+      color_end( out, prev_sgr );
       if ( opt_offsets != OFFSETS_NONE || curr_pos > 0 )
-        PUTC( ' ' );                    // print space between hex columns
+        FPUTC( ' ', out );              // print space between hex columns
       if ( print_readability_space( curr_pos ) )
-        PUTC( ' ' );
-      COLOR_START_IF( prev_matches, sgr_hex_match );
+        FPUTC( ' ', out );
+      color_start( out, prev_sgr );
+    }
+    if ( sgr != prev_sgr ) {            // only at the end of a run of a color
+      color_end( out, prev_sgr );
+      color_start( out, sgr );
     }
-    if ( matches )
-      COLOR_START_IF( matches_changed, sgr_hex_match );
-    else
-      COLOR_END_IF( matches_changed, sgr_hex_match );
-    PRINTF( "%02X", STATIC_CAST(unsigned, curr->bytes[ curr_pos ]) );
-    prev_matches = matches;
+    FPRINTF( out, "%02X", STATIC_CAST(unsigned, byte) );
+    prev_sgr = sgr;
   } // for
-  COLOR_END_IF( prev_matches, sgr_hex_match );
+  color_end( out, prev_sgr );
 
   if ( opt_dump_ascii ) {
     unsigned spaces = 2;
@@ -224,47 +298,657 @@ static void dump_row( char const *offset_format, row_buf_t const *curr,
       spaces += 2;
     } // for
 
-    FPUTNSP( spaces, stdout );
+    FPUTNSP( spaces, out );
 
     // dump ASCII part
-    prev_matches = false;
+    prev_sgr = NULL;
     for ( curr_pos = 0; curr_pos < curr->len; ++curr_pos ) {
-      bool const matches = (curr->match_bits & (1u << curr_pos)) != 0;
-      bool const matches_changed = matches != prev_matches;
       char8_t const byte = curr->bytes[ curr_pos ];
+      char const *const sgr = byte_sgr( curr, curr_pos, sgr_ascii_match );
 
-      if ( matches )
-        COLOR_START_IF( matches_changed, sgr_ascii_match );
-      else
-        COLOR_END_IF( matches_changed, sgr_ascii_match );
+      if ( sgr != prev_sgr ) {
+        color_end( out, prev_sgr );
+        color_start( out, sgr );
+      }
 
       static unsigned utf8_count;
       if ( utf8_count > 1 ) {
-        PUTS( POINTER_CAST( char const*, opt_utf8_pad ) );
+        FPUTS( POINTER_CAST( char const*, opt_utf8_pad ), out );
         --utf8_count;
       } else {
         char8_t utf8_char[ UTF8_CHAR_SIZE_MAX + 1 /*NULL*/ ];
         utf8_count = opt_utf8 ?
           utf8_collect( curr, curr_pos, next, utf8_char ) : 1;
         if ( utf8_count > 1 )
-          PUTS( POINTER_CAST( char*, utf8_char ) );
+          FPUTS( POINTER_CAST( char*, utf8_char ), out );
         else
-          PUTC( ascii_is_print( STATIC_CAST( char, byte ) ) ? byte : '.' );
+          FPUTC( ascii_is_print( STATIC_CAST( char, byte ) ) ? byte : '.',
+                 out );
       }
 
-      prev_matches = matches;
+      prev_sgr = sgr;
     } // for
-    COLOR_END_IF( prev_matches, sgr_ascii_match );
+    color_end( out, prev_sgr );
+  }
+}
+
+#ifdef HAVE_OPEN_MEMSTREAM
+/**
+ * Dumps the hex and ASCII parts of a row of bytes via \ref row_cache.
+ *
+ * @param curr A pointer to the current \a row_buf.
+ * @param next A pointer to the next \a row_buf.
+ * @return Returns `true` only if the row was dumped; `false` if the cache is
+ * being bypassed.
+ */
+NODISCARD
+static bool dump_row_body_cached( row_buf_t const *curr,
+                                  row_buf_t const *next ) {
+  if ( row_cache == NULL ) {
+    row_cache = MALLOC( row_cache_t, 1 );
+    memset( row_cache, 0, sizeof *row_cache );
+    row_cache->mem_file =
+      open_memstream( &row_cache->mem_buf, &row_cache->mem_size );
+    PERROR_EXIT_IF( row_cache->mem_file == NULL, EX_OSERR );
+  }
+  else if ( row_cache->bypass_rows > 0 ) {
+    --row_cache->bypass_rows;
+    return false;
+  }
+
+  if ( ++row_cache->probe_rows == ROW_CACHE_PROBE_ROWS ) {
+    if ( row_cache->probe_hits < ROW_CACHE_PROBE_ROWS / 4 )
+      row_cache->bypass_rows = ROW_CACHE_BYPASS_ROWS;
+    row_cache->probe_rows = row_cache->probe_hits = 0;
+  }
+
+  uint32_t hash = 2166136261u;          // FNV-1a
+  for ( size_t i = 0; i < curr->len; ++i )
+    hash = (hash ^ curr->bytes[i]) * 16777619u;
+  hash ^= hash >> 16;                   // FNV's low bits alone are weak
+  row_cache_entry_t *const entry =
+    &row_cache->entries[ hash % ROW_CACHE_ENTRIES ];
+
+  if ( entry->bytes_len == curr->len &&
+       memcmp( entry->bytes, curr->bytes, curr->len ) == 0 ) {
+    ++row_cache->probe_hits;
+  }
+  else {
+    FSEEK( row_cache->mem_file, 0, SEEK_SET );
+    dump_row_body( row_cache->mem_file, curr, next );
+    FFLUSH( row_cache->mem_file );
+    off_t const text_len = FTELL_FN( row_cache->mem_file );
+    PERROR_EXIT_IF( text_len == -1, EX_IOERR );
+    if ( STATIC_CAST( size_t, text_len ) > ROW_CACHE_TEXT_MAX ) {
+      PERROR_EXIT_IF(
+        fwrite( row_cache->mem_buf, 1, STATIC_CAST( size_t, text_len ),
+                fout ) < STATIC_CAST( size_t, text_len ),
+        EX_IOERR
+      );
+      return true;
+    }
+    memcpy( entry->bytes, curr->bytes, curr->len );
+    entry->bytes_len = curr->len;
+    memcpy( entry->text, row_cache->mem_buf, STATIC_CAST( size_t, text_len ) );
+    entry->text_len = STATIC_CAST( size_t, text_len );
+  }
+
+  PERROR_EXIT_IF(
+    fwrite( entry->text, 1, entry->text_len, fout ) < entry->text_len,
+    EX_IOERR
+  );
+  return true;
+}
+
+#endif /* HAVE_OPEN_MEMSTREAM */
+
+/**
+ * Frees the cache of rendered rows, if used.
+ */
+static void row_cache_free( void ) {
+#ifdef HAVE_OPEN_MEMSTREAM
+  if ( row_cache == NULL )
+    return;
+  fclose( row_cache->mem_file );
+  free( row_cache->mem_buf );
+  free( row_cache );
+  row_cache = NULL;
+#endif /* HAVE_OPEN_MEMSTREAM */
+}
+
+/**
+ * Dumps a single row of bytes containing the offset and hex and ASCII parts.
+ *
+ * @param offset_format The \c printf() format for the offset.
+ * @param curr A pointer to the current \a row_buf.
+ * @param next A pointer to the next \a row_buf.
+ */
+static void dump_row( char const *offset_format, row_buf_t const *curr,
+                      row_buf_t const *next ) {
+  assert( offset_format != NULL );
+  assert( curr != NULL );
+  assert( next != NULL );
+
+  static bool   any_dumped = false;     // any data dumped yet?
+  static off_t  dumped_offset = -1;     // offset of most recently dumped row
+
+  if ( dumped_offset == -1 )
+    dumped_offset = fin_offset;
+
+  // print row separator (if necessary)
+  if ( !opt_only_matching && !opt_only_printing ) {
+    uint64_t const offset_delta = STATIC_CAST( uint64_t,
+      fin_offset - dumped_offset - STATIC_CAST( off_t, row_bytes )
+    );
+    if ( offset_delta > 0 && any_dumped ) {
+      color_start( fout, sgr_elided );
+      for ( unsigned i = get_offsets_width(); i > 0; --i )
+        PUTC( ELIDED_SEP_CHAR );
+      color_end( fout, sgr_elided );
+      color_start( fout, sgr_sep );
+      PUTC( ':' );
+      color_end( fout, sgr_sep );
+      PUTC( ' ' );
+      color_start( fout, sgr_elided );
+      PRINTF( "(%" PRIu64 " | 0x%" PRIX64 ")", offset_delta, offset_delta );
+      color_end( fout, sgr_elided );
+      PUTC( '\n' );
+    }
   }
 
+  line_index_row( fin_offset );
+
+  // print offset (or address) & column separator
+  if ( opt_offsets != OFFSETS_NONE ) {
+    uint64_t offset = STATIC_CAST( uint64_t, fin_offset );
+    if ( opt_address_map_path != NULL )
+      PJL_DISCARD_RV( address_map_lookup( fin_offset, curr->len, &offset ) );
+    color_start( fout, sgr_offset );
+    PRINTF( offset_format, offset );
+    color_end( fout, sgr_offset );
+    color_start( fout, sgr_sep );
+    PUTC( ':' );
+    color_end( fout, sgr_sep );
+  }
+
+#ifdef HAVE_OPEN_MEMSTREAM
+  //
+  // With -V, repeated rows aren't elided, so use the cache of rendered rows --
+  // but not for rows having matches (since they're highlighted) or partial
+  // rows or with -u (since a UTF-8 character may continue into the next row).
+  //
+  if ( !(opt_verbose && !opt_utf8 && curr->match_bits == 0 &&
+         curr->len == row_bytes && dump_row_body_cached( curr, next )) )
+#endif /* HAVE_OPEN_MEMSTREAM */
+    dump_row_body( fout, curr, next );
   PUTC( '\n' );
 
   any_dumped = true;
   dumped_offset = fin_offset;
 }
 
+/**
+ * Gets the width of a full row as printed by dump_row() without color.
+ *
+ * @return Returns said width including the newline.
+ */
+NODISCARD
+static size_t dump_row_width( void ) {
+  size_t width = 1;                     // for '\n'
+  if ( opt_offsets != OFFSETS_NONE )
+    width += get_offsets_width() + 1 /* ':' */;
+  for ( size_t pos = 0; pos < row_bytes; ++pos ) {
+    width += 2;
+    if ( pos % opt_group_by == 0 && (opt_offsets != OFFSETS_NONE || pos > 0) )
+      ++width;
+    if ( print_readability_space( pos ) )
+      ++width;
+  } // for
+  if ( opt_dump_ascii )
+    width += 2 + row_bytes;
+  return width;
+}
+
+/**
+ * Reserves space for the output of dump_file() based on the size of the input
+ * if both are regular files.
+ *
+ * @remarks This is only an estimate since color and UTF-8 add bytes.  Nothing
+ * is reserved unless \ref opt_verbose since otherwise rows of repeated bytes
+ * are elided and the output could be any fraction of the estimate.
+ */
+static void dump_reserve( void ) {
+  if ( !opt_verbose || opt_only_matching || opt_only_printing || opt_last )
+    return;
+  if ( !input_is_file() )
+    return;
+  off_t const size = input_size();
+  if ( size <= fin_offset )
+    return;
+  uint64_t bytes = STATIC_CAST( uint64_t, size - fin_offset );
+  if ( bytes > opt_max_bytes )
+    bytes = opt_max_bytes;
+  uint64_t const rows = (bytes + row_bytes - 1) / row_bytes;
+  output_reserve( STATIC_CAST( off_t, rows * dump_row_width() ) );
+}
+
+/**
+ * Gets the bit error rate of a block.
+ *
+ * @param block The \ref bit_errors_block.
+ * @return Returns said rate.
+ */
+NODISCARD
+static double bit_errors_rate( bit_errors_block_t const *block ) {
+  return STATIC_CAST( double, block->cleared + block->set ) /
+         STATIC_CAST( double, block->len * 8 );
+}
+
+/**
+ * Prints the offset, number of flipped bits, and bit error rate of a block.
+ *
+ * @param out The `FILE` to print to.
+ * @param offset_format The \c printf() format for the offset.
+ * @param block The \ref bit_errors_block.
+ */
+static void bit_errors_print( FILE *out, char const *offset_format,
+                              bit_errors_block_t const *block ) {
+  if ( opt_offsets != OFFSETS_NONE ) {
+    color_start( out, sgr_offset );
+    FPRINTF( out, offset_format, STATIC_CAST( uint64_t, block->offset ) );
+    color_end( out, sgr_offset );
+    color_start( out, sgr_sep );
+    FPUTC( ':', out );
+    color_end( out, sgr_sep );
+    FPUTC( ' ', out );
+  }
+  uint64_t const flips = block->cleared + block->set;
+  if ( flips > 0 )
+    color_start( out, sgr_hex_match );
+  FPRINTF( out, "%" PRIu64, flips );
+  if ( flips > 0 )
+    color_end( out, sgr_hex_match );
+  FPRINTF( out, " %.3e\n", bit_errors_rate( block ) );
+}
+
+/**
+ * Counts the bits of a block that differ from its reference.
+ *
+ * @param data A pointer to the \ref bit_errors_job.
+ * @param task The index of the block within the current batch.
+ * @param worker The worker number (unused).
+ */
+static void bit_errors_task( void *data, size_t task, unsigned worker ) {
+  (void)worker;
+  bit_errors_job_t const *const job = data;
+  bit_errors_block_t *const b = &job->blocks[ task ];
+  size_t const pos = task * job->block_size;
+  char8_t const *const bytes = job->bytes + pos;
+  char8_t *const ref = job->ref + pos;
+
+  if ( opt_bit_errors_fill_len > 0 ) {
+    // The fill pattern repeats from offset 0 of the input.
+    size_t f = STATIC_CAST( uint64_t, b->offset ) % opt_bit_errors_fill_len;
+    for ( size_t i = 0; i < b->len; ++i ) {
+      ref[i] = opt_bit_errors_fill[ f ];
+      if ( ++f == opt_bit_errors_fill_len )
+        f = 0;
+    } // for
+  }
+
+  //
+  // Compare 8 bytes at a time so the XOR and population counts vectorize; a
+  // flipped bit is either cleared (in the reference but not the input) or set
+  // (vice versa).
+  //
+  uint64_t cleared = 0, set = 0;
+  size_t i = 0;
+  for ( ; i + sizeof( uint64_t ) <= b->len; i += sizeof( uint64_t ) ) {
+    uint64_t x, r;
+    memcpy( &x, bytes + i, sizeof x );
+    memcpy( &r, ref + i, sizeof r );
+    cleared += STATIC_CAST( uint64_t, __builtin_popcountll( r & ~x ) );
+    set += STATIC_CAST( uint64_t, __builtin_popcountll( x & ~r ) );
+  } // for
+  for ( ; i < b->len; ++i ) {
+    unsigned const x = bytes[i], r = ref[i];
+    cleared += STATIC_CAST( uint64_t, __builtin_popcount( r & ~x ) );
+    set += STATIC_CAST( uint64_t, __builtin_popcount( x & ~r ) );
+  } // for
+  b->cleared = cleared;
+  b->set = set;
+
+  if ( job->flags != NULL ) {
+    bool *const flags = job->flags + pos;
+    for ( i = 0; i < b->len; ++i )
+      flags[i] = bytes[i] != ref[i];
+  }
+}
+
+/**
+ * Fills a row from a block.
+ *
+ * @param bytes The bytes of the block.
+ * @param flags Which bytes of the block match.
+ * @param block_len The number of bytes in the block.
+ * @param pos The position of the row within the block.
+ * @param row The \ref row_buf to fill; its length is 0 if \a pos is past the
+ * end of the block.
+ */
+static void block_row( char8_t const *bytes, bool const *flags,
+                       size_t block_len, size_t pos, row_buf_t *row ) {
+  row->len = pos >= block_len ? 0 : block_len - pos;
+  if ( row->len > row_bytes )
+    row->len = row_bytes;
+  row->match_bits = 0;
+  if ( row->len == 0 )
+    return;
+  memcpy( row->bytes, bytes + pos, row->len );
+  for ( size_t i = 0; i < row->len; ++i ) {
+    if ( flags[ pos + i ] )
+      row->match_bits |= STATIC_CAST( match_bits_t, 1 ) << i;
+  } // for
+}
+
+/**
+ * Dumps the rows of a block, e.g., a sampled block, the same way dump_file()
+ * dumps rows.
+ *
+ * @param offset_format The \c printf() format for the offset.
+ * @param bytes The bytes of the block.
+ * @param flags Which bytes of the block match.
+ * @param offset The file offset of the block.
+ * @param len The number of bytes in the block.
+ */
+static void dump_block( char const *offset_format, char8_t const *bytes,
+                        bool const *flags, off_t offset, size_t len ) {
+  row_buf_t buf[2], *curr = buf, *next = buf + 1;
+  bool is_same_row = false;
+
+  block_row( bytes, flags, len, 0, curr );
+  for ( size_t pos = 0; pos < len; pos += row_bytes ) {
+    block_row( bytes, flags, len, pos + row_bytes, next );
+    bool const is_last_row = next->len == 0;
+
+    fin_offset = offset + STATIC_CAST( off_t, pos );
+    if ( curr->match_bits != 0 || (
+        !opt_only_matching &&
+        (opt_verbose || !is_same_row || is_last_row) &&
+        (!opt_only_printing ||
+          ascii_any_printable( (char*)curr->bytes, curr->len )) ) ) {
+      dump_row( offset_format, curr, next );
+    }
+
+    is_same_row =
+      !(opt_verbose || is_last_row) &&
+      curr->len == next->len &&
+      memcmp( curr->bytes, next->bytes, row_bytes ) == 0;
+
+    row_buf_t *const temp = curr;
+    curr = next;
+    next = temp;
+  } // for
+}
+
+/**
+ * Adds a per-block value to a \ref sample_stat.
+ *
+ * @param stat The \ref sample_stat to add to.
+ * @param value The value to add.
+ */
+static inline void sample_stat_add( sample_stat_t *stat, double value ) {
+  stat->sum += value;
+  stat->sum2 += value * value;
+}
+
+/**
+ * Prints the estimated mean of a per-block statistic along with its 95%
+ * confidence interval.
+ *
+ * @param what What the statistic is.
+ * @param stat The \ref sample_stat.
+ * @param n The number of blocks sampled.
+ * @param N The number of blocks in the file.
+ * @param scale The amount to multiply the mean and interval by.
+ * @param unit The unit of the statistic.
+ */
+static void sample_stat_print( char const *what, sample_stat_t const *stat,
+                               uint64_t n, uint64_t N, double scale,
+                               char const *unit ) {
+  double const dn = STATIC_CAST( double, n );
+  double const mean = stat->sum / dn;
+  EPRINTF( "%s: %.4g", what, mean * scale );
+  if ( n > 1 ) {
+    double var = (stat->sum2 - dn * mean * mean) / (dn - 1);
+    if ( var < 0 )                      // due to rounding
+      var = 0;
+    // Since blocks are sampled without replacement, the standard error
+    // shrinks by the finite population correction.
+    double const fpc = 1 - dn / STATIC_CAST( double, N );
+    double const se = sqrt( var / dn * fpc );
+    EPRINTF( " +/- %.2g", 1.96 * se * scale );
+  }
+  EPRINTF( "%s\n", unit );
+}
+
+/**
+ * Reads and calculates the statistics of a sampled block.
+ *
+ * @param data A pointer to the \ref sample_job.
+ * @param task The index of the block within the current batch.
+ * @param worker The worker number (unused).
+ */
+static void sample_task( void *data, size_t task, unsigned worker ) {
+  (void)worker;
+  sample_job_t const *const job = data;
+  uint64_t const sample = job->batch_first + task;
+
+  //
+  // Divide the blocks into as many equal strides as there are samples and
+  // take either the first or a random block from each.  Each random block is
+  // derived from only its sample number so the same blocks are sampled
+  // regardless of the number of jobs.
+  //
+  double const stride = STATIC_CAST( double, job->blocks_len ) /
+                        STATIC_CAST( double, job->samples_len );
+  uint64_t block = STATIC_CAST( uint64_t, STATIC_CAST( double, sample ) * stride );
+  if ( opt_sample_random ) {
+    uint64_t const next_block =
+      STATIC_CAST( uint64_t, STATIC_CAST( double, sample + 1 ) * stride );
+    if ( next_block > block + 1 ) {
+      uint64_t z = (sample + 1) * UINT64_C(0x9E3779B97F4A7C15);
+      z = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+      z = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+      z ^= z >> 31;
+      block += z % (next_block - block);
+    }
+  }
+
+  sample_block_t *const b = &job->blocks[ task ];
+  char8_t *const bytes = job->bytes + task * job->block_size;
+  *b = (sample_block_t){
+    .offset = job->begin + STATIC_CAST( off_t, block * job->block_size )
+  };
+  size_t len = job->block_size;
+  if ( STATIC_CAST( uint64_t, job->end - b->offset ) < len )
+    len = STATIC_CAST( size_t, job->end - b->offset );
+  while ( b->len < len ) {
+    ssize_t const bytes_read = input_pread(
+      bytes + b->len, len - b->len, b->offset + STATIC_CAST( off_t, b->len )
+    );
+    if ( unlikely( bytes_read == -1 ) )
+      fatal_error( EX_IOERR, "\"%s\": can not read: %s\n", fin_path, STRERROR() );
+    if ( bytes_read == 0 )
+      break;
+    b->len += STATIC_CAST( size_t, bytes_read );
+  } // while
+
+  size_t counts[ 256 ] = { 0 };
+  for ( size_t i = 0; i < b->len; ++i )
+    ++counts[ bytes[i] ];
+  b->zeros = counts[0];
+  for ( unsigned i = 0; i < 256; ++i ) {
+    if ( counts[i] > 0 ) {
+      double const p = STATIC_CAST( double, counts[i] ) /
+                       STATIC_CAST( double, b->len );
+      b->entropy -= p * log2( p );
+    }
+  } // for
+
+  bool *const flags = job->flags + task * job->block_size;
+  memset( flags, 0, b->len * sizeof( bool ) );
+  if ( job->kmps != NULL )
+    b->matches = match_block_count( bytes, b->len, job->kmps, flags );
+}
+
 /////////// extern functions //////////////////////////////////////////////////
 
+/**
+ * Compares the input against either a reference file or fill pattern in
+ * blocks and, for each block, prints the number of flipped bits and the bit
+ * error rate or, with \ref opt_only_matching, dumps the rows having flipped
+ * bits with those bytes highlighted.  The totals and worst blocks are printed
+ * to standard error.
+ *
+ * @remarks Batches of blocks are read sequentially from both the input and
+ * reference and compared in parallel, so the input need not be seekable.
+ */
+void bit_errors_file( void ) {
+  FILE *ref_file = NULL;
+  if ( opt_bit_errors_path != NULL ) {
+    ref_file = fopen( opt_bit_errors_path, "r" );
+    if ( unlikely( ref_file == NULL ) ) {
+      fatal_error( EX_NOINPUT,
+        "\"%s\": %s\n", opt_bit_errors_path, STRERROR()
+      );
+    }
+    fskip( fin_offset, ref_file );      // compare at the same offsets
+  }
+
+  size_t batch_cap = BIT_ERRORS_BATCH_BYTES / opt_bit_errors_block;
+  if ( batch_cap == 0 )
+    batch_cap = 1;
+  size_t const batch_size = batch_cap * opt_bit_errors_block;
+  bit_errors_job_t job = {
+    .block_size = opt_bit_errors_block,
+    .blocks = MALLOC( bit_errors_block_t, batch_cap ),
+    .bytes = MALLOC( char8_t, batch_size ),
+    .ref = MALLOC( char8_t, batch_size ),
+    .flags = opt_only_matching ? MALLOC( bool, batch_size ) : NULL
+  };
+
+  char const *const offset_format = get_offsets_format();
+  bit_errors_block_t total = { .offset = fin_offset };
+  bit_errors_block_t worst[ BIT_ERRORS_WORST ];
+  size_t worst_len = 0;
+  uint64_t blocks_len = 0;
+  size_t left = opt_max_bytes;
+  bool is_ref_short = false;
+
+  while ( left > 0 && !is_ref_short ) {
+    size_t const want = left < batch_size ? left : batch_size;
+    size_t len = fread( job.bytes, 1, want, fin );
+    if ( unlikely( ferror( fin ) ) )
+      fatal_error( EX_IOERR, "\"%s\": can not read: %s\n", fin_path, STRERROR() );
+    bool const is_eof = len < want;
+    if ( ref_file != NULL ) {
+      size_t const ref_len = fread( job.ref, 1, len, ref_file );
+      if ( unlikely( ferror( ref_file ) ) ) {
+        fatal_error( EX_IOERR,
+          "\"%s\": can not read: %s\n", opt_bit_errors_path, STRERROR()
+        );
+      }
+      if ( ref_len < len ) {
+        len = ref_len;
+        is_ref_short = true;
+      }
+    }
+    if ( len == 0 )
+      break;
+
+    size_t const n_blocks = (len + job.block_size - 1) / job.block_size;
+    for ( size_t i = 0; i < n_blocks; ++i ) {
+      size_t const pos = i * job.block_size;
+      job.blocks[i] = (bit_errors_block_t){
+        .offset = fin_offset + STATIC_CAST( off_t, pos ),
+        .len = len - pos < job.block_size ? len - pos : job.block_size
+      };
+    } // for
+    par_for( n_blocks, &bit_errors_task, &job );
+
+    for ( size_t i = 0; i < n_blocks; ++i ) {
+      bit_errors_block_t const *const b = &job.blocks[i];
+      uint64_t const flips = b->cleared + b->set;
+      total.len += b->len;
+      total.cleared += b->cleared;
+      total.set += b->set;
+
+      // Keep the worst blocks sorted by descending flips, then offset.
+      size_t w = worst_len;
+      if ( flips > 0 && (w < BIT_ERRORS_WORST ||
+           flips > worst[ w - 1 ].cleared + worst[ w - 1 ].set) ) {
+        if ( w == BIT_ERRORS_WORST )
+          --w;
+        for ( ; w > 0 && flips > worst[ w - 1 ].cleared + worst[ w - 1 ].set;
+              --w ) {
+          worst[w] = worst[ w - 1 ];
+        } // for
+        worst[w] = *b;
+        if ( worst_len < BIT_ERRORS_WORST )
+          ++worst_len;
+      }
+
+      if ( job.flags == NULL )
+        bit_errors_print( fout, offset_format, b );
+      else if ( flips > 0 ) {
+        dump_block(
+          offset_format, job.bytes + i * job.block_size,
+          job.flags + i * job.block_size, b->offset, b->len
+        );
+      }
+    } // for
+
+    blocks_len += n_blocks;
+    fin_offset += STATIC_CAST( off_t, len );
+    left -= len;
+    if ( is_eof )
+      break;
+  } // while
+
+  FFLUSH( fout );
+  if ( is_ref_short ) {
+    EPRINTF( "%s: \"%s\": shorter than input; compared %zu bytes\n",
+      me, opt_bit_errors_path, total.len
+    );
+  }
+  EPRINTF(
+    "compared: %zu bytes in %" PRIu64 " blocks of %zu bytes\n",
+    total.len, blocks_len, job.block_size
+  );
+  EPRINTF(
+    "flipped: %" PRIu64 " bits (%" PRIu64 " 1->0, %" PRIu64 " 0->1)\n",
+    total.cleared + total.set, total.cleared, total.set
+  );
+  if ( total.len > 0 )
+    EPRINTF( "bit error rate: %.3e\n", bit_errors_rate( &total ) );
+  if ( worst_len > 0 ) {
+    EPRINTF( "worst blocks:\n" );
+    for ( size_t w = 0; w < worst_len; ++w )
+      bit_errors_print( stderr, offset_format, &worst[w] );
+  }
+
+  if ( ref_file != NULL )
+    fclose( ref_file );
+  free( job.blocks );
+  free( job.bytes );
+  free( job.ref );
+  free( job.flags );
+  row_cache_free();
+
+  if ( opt_only_matching && total.cleared + total.set == 0 )
+    exit( EX_NO_MATCHES );
+}
+
 /**
  * Dumps a file.
  */
@@ -277,6 +961,10 @@ void dump_file( void ) {
   size_t        match_len = 0;          // used only by match_row()
   char const   *offset_format = get_offsets_format();
 
+  dump_reserve();
+  if ( opt_line_index_path != NULL )
+    line_index_begin();
+
   if ( opt_search_len > 0 ) {           // searching for anything?
     if ( opt_strings ) {
       match_len = opt_search_len < STRINGS_LEN_DEFAULT ?
@@ -289,9 +977,12 @@ void dump_file( void ) {
   }
 
   // prime the pump by reading the first row
-  curr->len = match_row(
-    curr->bytes, row_bytes, &curr->match_bits, kmps, &match_buf, &match_len
-  );
+  if ( opt_last && !match_last() )
+    curr->len = 0;
+  else
+    curr->len = match_row(
+      curr->bytes, row_bytes, &curr->match_bits, kmps, &match_buf, &match_len
+    );
 
   while ( curr->len > 0 ) {
     //
@@ -309,7 +1000,11 @@ void dump_file( void ) {
     if ( opt_matches != MATCHES_ONLY_PRINT ) {
       bool const is_last_row = next->len == 0;
 
-      if ( curr->match_bits != 0 || (   // always dump matching rows
+      // With an address map, never dump unmapped rows.
+      bool const is_mapped = opt_address_map_path == NULL ||
+        address_map_lookup( fin_offset, curr->len, /*paddr=*/NULL );
+
+      if ( is_mapped && (curr->match_bits != 0 || ( // always dump matching rows
           // Otherwise dump only if:
           //  + for non-matching rows, if not -m
           !opt_only_matching &&
@@ -317,7 +1012,7 @@ void dump_file( void ) {
           (opt_verbose || !is_same_row || is_last_row) &&
           //  + and if not -p or any printable bytes
           (!opt_only_printing ||
-            ascii_any_printable( (char*)curr->bytes, curr->len )) ) ) {
+            ascii_any_printable( (char*)curr->bytes, curr->len )) ) ) ) {
 
         dump_row( offset_format, curr, next );
       }
@@ -339,18 +1034,110 @@ void dump_file( void ) {
     fin_offset += STATIC_CAST( off_t, row_bytes );
   } // while
 
+  line_index_end( fin_offset );
+
   if ( opt_matches != MATCHES_NO_PRINT ) {
-    FFLUSH( stdout );
+    FFLUSH( fout );
     EPRINTF( "%lu\n", total_matches );
   }
 
   FREE( kmps );
   free( match_buf );
+  row_cache_free();
 
   if ( opt_search_len > 0 && !any_matches )
     exit( EX_NO_MATCHES );
 }
 
+/**
+ * Dumps only the rows of a sample of blocks of a file and prints estimates of
+ * the match density, entropy, and fraction of null bytes of the whole file.
+ *
+ * @remarks Blocks of #SAMPLE_BLOCK_ROWS rows are read in parallel via
+ * **pread**(2), so the input may be a huge block device.  Sampled rows are
+ * dumped with their true offsets and gaps between blocks are elided.  The
+ * estimates along with their 95% confidence intervals are printed to standard
+ * error.
+ */
+void dump_file_sampled( void ) {
+  sample_job_t job = {
+    .begin = fin_offset,
+    .block_size = SAMPLE_BLOCK_ROWS * row_bytes
+  };
+  job.end = input_size();
+  if ( unlikely( job.end == -1 ) )
+    fatal_error( EX_IOERR, "\"%s\": can not seek: %s\n", fin_path, STRERROR() );
+  if ( job.end > job.begin ) {
+    job.blocks_len = (STATIC_CAST( uint64_t, job.end - job.begin ) +
+                      job.block_size - 1) / job.block_size;
+    double const samples = ceil(
+      STATIC_CAST( double, job.blocks_len ) * opt_sample / 100
+    );
+    job.samples_len = STATIC_CAST( uint64_t, samples );
+    if ( job.samples_len > job.blocks_len )
+      job.samples_len = job.blocks_len;
+  }
+
+  if ( opt_search_len > 0 )
+    job.kmps = kmp_new( opt_search_buf, opt_search_len );
+  size_t const batch_cap = 256;
+  job.blocks = MALLOC( sample_block_t, batch_cap );
+  job.bytes = MALLOC( char8_t, batch_cap * job.block_size );
+  job.flags = MALLOC( bool, batch_cap * job.block_size );
+
+  char const *const offset_format = get_offsets_format();
+  sample_stat_t entropy = { 0 }, matches = { 0 }, zeros = { 0 };
+
+  for ( ; job.batch_first < job.samples_len; job.batch_first += batch_cap ) {
+    size_t batch_len = batch_cap;
+    if ( job.samples_len - job.batch_first < batch_len )
+      batch_len = STATIC_CAST( size_t, job.samples_len - job.batch_first );
+    par_for( batch_len, &sample_task, &job );
+
+    for ( size_t i = 0; i < batch_len; ++i ) {
+      sample_block_t const *const b = &job.blocks[i];
+      if ( b->len == 0 )
+        continue;
+      sample_stat_add( &entropy, b->entropy );
+      sample_stat_add( &matches, STATIC_CAST( double, b->matches ) );
+      sample_stat_add( &zeros,
+        STATIC_CAST( double, b->zeros ) / STATIC_CAST( double, b->len )
+      );
+      total_matches += b->matches;
+      dump_block(
+        offset_format, job.bytes + i * job.block_size,
+        job.flags + i * job.block_size, b->offset, b->len
+      );
+    } // for
+  } // for
+
+  FFLUSH( fout );
+  EPRINTF(
+    "sampled: %" PRIu64 " of %" PRIu64 " blocks of %zu bytes\n",
+    job.samples_len, job.blocks_len, job.block_size
+  );
+  if ( job.samples_len > 0 ) {
+    uint64_t const n = job.samples_len, N = job.blocks_len;
+    sample_stat_print( "null bytes", &zeros, n, N, 100, "%" );
+    sample_stat_print( "entropy", &entropy, n, N, 1, " bits/byte" );
+    if ( job.kmps != NULL ) {
+      sample_stat_print( "matches", &matches, n, N, 1, " per block" );
+      sample_stat_print(
+        "matches", &matches, n, N, STATIC_CAST( double, N ), " in all"
+      );
+    }
+  }
+
+  FREE( job.kmps );
+  free( job.blocks );
+  free( job.bytes );
+  free( job.flags );
+  row_cache_free();
+
+  if ( opt_search_len > 0 && total_matches == 0 )
+    exit( EX_NO_MATCHES );
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 /** @} */
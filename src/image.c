@@ -0,0 +1,539 @@
+/*
+**      ad -- ASCII dump
+**      src/image.c
+**
+**      Copyright (C) 2024  Paul J. Lucas
+**
+**      This program is free software: you can redistribute it and/or modify
+**      it under the terms of the GNU General Public License as published by
+**      the Free Software Foundation, either version 3 of the License, or
+**      (at your option) any later version.
+**
+**      This program is distributed in the hope that it will be useful,
+**      but WITHOUT ANY WARRANTY; without even the implied warranty of
+**      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**      GNU General Public License for more details.
+**
+**      You should have received a copy of the GNU General Public License
+**      along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * Defines types and functions for outputting a file as an image that maps
+ * bytes to pixels.
+ */
+
+// local
+#include "pjl_config.h"                 /* must go first */
+#include "ad.h"
+#include "input.h"
+#include "options.h"
+#include "parallel.h"
+#include "util.h"
+
+/// @cond DOXYGEN_IGNORE
+
+// standard
+#include <assert.h>
+#include <math.h>                       /* for log2() */
+#include <stdbool.h>
+#include <stddef.h>                     /* for size_t */
+#include <stdint.h>                     /* for uint*_t */
+#include <stdio.h>
+#include <stdlib.h>                     /* for free() */
+#include <string.h>                     /* for memset() */
+#include <sysexits.h>
+#ifdef HAVE_ZLIB_H
+#include <zlib.h>
+#endif /* HAVE_ZLIB_H */
+
+/// @endcond
+
+/**
+ * @defgroup image-group Byte Map Images
+ * Types and functions for outputting a file as an image.
+ * @{
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+
+#define ENTROPY_WINDOW_MIN  32u         /**< Minimum bytes for entropy.     */
+#define PIXEL_SIZE          3u          /**< Bytes per RGB pixel.           */
+
+#ifdef HAVE_ZLIB_H
+#define PNG_ZBUF_SIZE       (64 * 1024u)/**< Compressed data buffer size.   */
+#endif /* HAVE_ZLIB_H */
+
+/**
+ * Data shared by all tasks of a band of image rows.
+ */
+struct image_job {
+  off_t         begin;                  ///< File offset of first byte.
+  off_t         end;                    ///< File offset of end.
+  size_t        block_size;             ///< Bytes per pixel.
+  size_t        window;                 ///< Bytes per entropy window.
+  size_t        band_row;               ///< First row of current band.
+  size_t        band_rows;              ///< Rows in current band.
+  size_t        task_rows;              ///< Rows per task.
+  char8_t      *pixels;                 ///< Pixels of current band.
+  char8_t     **bufs;                   ///< Per-worker read buffers.
+};
+typedef struct image_job image_job_t;
+
+/**
+ * State for writing a PNG image.
+ */
+struct png_writer {
+#ifdef HAVE_ZLIB_H
+  z_stream      zs;                     ///< Compression state.
+  char8_t      *zbuf;                   ///< Compressed data buffer.
+#else
+  uint32_t      adler;                  ///< Adler-32 of uncompressed data.
+#endif /* HAVE_ZLIB_H */
+};
+typedef struct png_writer png_writer_t;
+
+////////// local functions ////////////////////////////////////////////////////
+
+/**
+ * Gets the color of a byte by its class: black for null; white for 0xFF; blue
+ * for printable ASCII; green for other ASCII; and red for other bytes.
+ *
+ * @param byte The byte to get the color of.
+ * @param rgb The color.
+ */
+static void byte_class_rgb( char8_t byte, unsigned rgb[static PIXEL_SIZE] ) {
+  static unsigned const RGB[][ PIXEL_SIZE ] = {
+    {   0,   0,   0 },                  // null
+    { 255, 255, 255 },                  // 0xFF
+    {  55, 126, 184 },                  // printable ASCII
+    {  77, 175,  74 },                  // other ASCII
+    { 228,  26,  28 },                  // other
+  };
+  unsigned const *c;
+  if ( byte == 0x00 )
+    c = RGB[0];
+  else if ( byte == 0xFF )
+    c = RGB[1];
+  else if ( ascii_is_print( STATIC_CAST( char, byte ) ) )
+    c = RGB[2];
+  else if ( byte < 0x80 )
+    c = RGB[3];
+  else
+    c = RGB[4];
+  rgb[0] = c[0];
+  rgb[1] = c[1];
+  rgb[2] = c[2];
+}
+
+/**
+ * Calculates the color of a pixel by the entropy of its bytes in the manner of
+ * **binvis**: low entropy is black; medium is blue; high is pink.
+ *
+ * @param buf The bytes.
+ * @param len The number of bytes.
+ * @param pixel The pixel to receive the color.
+ */
+static void entropy_pixel( char8_t const *buf, size_t len, char8_t *pixel ) {
+  assert( len > 0 );
+  unsigned counts[ 256 ];
+  memset( counts, 0, sizeof counts );
+  for ( size_t i = 0; i < len; ++i )
+    ++counts[ buf[i] ];
+
+  double entropy = 0;
+  for ( unsigned i = 0; i < 256; ++i ) {
+    if ( counts[i] > 0 ) {
+      double const p = STATIC_CAST( double, counts[i] ) /
+                       STATIC_CAST( double, len );
+      entropy -= p * log2( p );
+    }
+  } // for
+  double const max = log2( STATIC_CAST( double, len < 256 ? len : 256 ) );
+  double const e = max > 0 ? entropy / max : 0;
+
+  double r = 0;
+  if ( e > 0.5 ) {
+    double const x = e - 0.5;
+    r = 4 * x - 4 * x * x;
+    r = r * r * r * r;
+  }
+  pixel[0] = STATIC_CAST( char8_t, 255 * r + 0.5 );
+  pixel[1] = 0;
+  pixel[2] = STATIC_CAST( char8_t, 255 * e * e + 0.5 );
+}
+
+/**
+ * Reads exactly \a len bytes from the input at \a offset.
+ *
+ * @param buf The buffer to read into.
+ * @param len The number of bytes to read.
+ * @param offset The file offset to read from.
+ */
+static void image_read( char8_t *buf, size_t len, off_t offset ) {
+  while ( len > 0 ) {
+    ssize_t const bytes_read = input_pread( buf, len, offset );
+    if ( unlikely( bytes_read <= 0 ) ) {
+      fatal_error( EX_IOERR,
+        "\"%s\": read failed: %s\n", fin_path, STRERROR()
+      );
+    }
+    buf += bytes_read;
+    len -= STATIC_CAST( size_t, bytes_read );
+    offset += bytes_read;
+  } // while
+}
+
+/**
+ * Calculates the pixels of some rows of a band.
+ *
+ * @param data A pointer to the \ref image_job.
+ * @param task The task number: each task calculates \ref image_job::task_rows
+ * rows.
+ * @param worker The worker number.
+ */
+static void image_task( void *data, size_t task, unsigned worker ) {
+  image_job_t const *const job = data;
+  char8_t *const buf = job->bufs[ worker ];
+
+  size_t const first_row = task * job->task_rows;
+  size_t rows = job->band_rows - first_row;
+  if ( rows > job->task_rows )
+    rows = job->task_rows;
+  size_t const first_pixel = (job->band_row + first_row) * opt_image_width;
+  size_t const n_pixels = rows * opt_image_width;
+  char8_t *pixel = job->pixels + first_row * opt_image_width * PIXEL_SIZE;
+  memset( pixel, 0, n_pixels * PIXEL_SIZE );
+
+  off_t const offset =
+    job->begin + STATIC_CAST( off_t, first_pixel * job->block_size );
+  if ( offset >= job->end )
+    return;                             // entirely padding
+  size_t len = n_pixels * job->block_size + job->window - job->block_size;
+  if ( STATIC_CAST( off_t, len ) > job->end - offset )
+    len = STATIC_CAST( size_t, job->end - offset );
+  image_read( buf, len, offset );
+
+  for ( size_t i = 0; i < n_pixels; ++i, pixel += PIXEL_SIZE ) {
+    size_t const pos = i * job->block_size;
+    if ( pos >= len )
+      break;
+    size_t n = opt_image_entropy ? job->window : job->block_size;
+    if ( n > len - pos )
+      n = len - pos;
+    if ( opt_image_entropy ) {
+      entropy_pixel( buf + pos, n, pixel );
+      continue;
+    }
+    unsigned sum[ PIXEL_SIZE ] = { 0, 0, 0 };
+    for ( size_t j = 0; j < n; ++j ) {
+      unsigned rgb[ PIXEL_SIZE ];
+      byte_class_rgb( buf[ pos + j ], rgb );
+      sum[0] += rgb[0];
+      sum[1] += rgb[1];
+      sum[2] += rgb[2];
+    } // for
+    for ( unsigned c = 0; c < PIXEL_SIZE; ++c )
+      pixel[c] = STATIC_CAST( char8_t, (sum[c] + n / 2) / n );
+  } // for
+}
+
+/**
+ * Writes a 32-bit unsigned integer in big-endian byte order.
+ *
+ * @param n The integer to write.
+ */
+static void put_be32( uint32_t n ) {
+  PUTC( STATIC_CAST( int, (n >> 24) & 0xFF ) );
+  PUTC( STATIC_CAST( int, (n >> 16) & 0xFF ) );
+  PUTC( STATIC_CAST( int, (n >>  8) & 0xFF ) );
+  PUTC( STATIC_CAST( int,  n        & 0xFF ) );
+}
+
+/**
+ * Writes bytes to standard output.
+ *
+ * @param buf The bytes to write.
+ * @param len The number of bytes.
+ */
+static void put_bytes( void const *buf, size_t len ) {
+  PERROR_EXIT_IF( fwrite( buf, 1, len, fout ) < len, EX_IOERR );
+}
+
+#ifndef HAVE_ZLIB_H
+/**
+ * Updates a CRC-32 (as used by PNG) with bytes.
+ *
+ * @param crc The CRC so far; initially 0.
+ * @param buf The bytes.
+ * @param len The number of bytes.
+ * @return Returns the updated CRC.
+ */
+NODISCARD
+static uint32_t crc32( uint32_t crc, void const *buf, size_t len ) {
+  static uint32_t table[ 256 ];
+  if ( table[1] == 0 ) {
+    for ( uint32_t i = 0; i < 256; ++i ) {
+      uint32_t c = i;
+      for ( unsigned k = 0; k < 8; ++k )
+        c = (c & 1) != 0 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+      table[i] = c;
+    } // for
+  }
+  char8_t const *p = buf;
+  crc = ~crc;
+  while ( len-- > 0 )
+    crc = table[ (crc ^ *p++) & 0xFF ] ^ (crc >> 8);
+  return ~crc;
+}
+#endif /* HAVE_ZLIB_H */
+
+/**
+ * Writes a PNG chunk.
+ *
+ * @param type The 4-character chunk type.
+ * @param data The chunk data.
+ * @param len The number of bytes of \a data.
+ */
+static void png_chunk( char const type[static 4], void const *data,
+                       size_t len ) {
+  put_be32( STATIC_CAST( uint32_t, len ) );
+  put_bytes( type, 4 );
+  if ( len > 0 )
+    put_bytes( data, len );
+  uint32_t crc = STATIC_CAST( uint32_t,
+    crc32( 0, POINTER_CAST( char8_t const*, type ), 4 )
+  );
+  if ( len > 0 ) {
+    crc = STATIC_CAST( uint32_t,
+      crc32( crc, data, STATIC_CAST( unsigned, len ) )
+    );
+  }
+  put_be32( crc );
+}
+
+/**
+ * Begins writing a PNG image.
+ *
+ * @param png The \ref png_writer to use.
+ * @param height The height of the image in pixels.
+ */
+static void png_begin( png_writer_t *png, size_t height ) {
+  static char8_t const PNG_SIGNATURE[] = {
+    0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'
+  };
+  put_bytes( PNG_SIGNATURE, sizeof PNG_SIGNATURE );
+
+  char8_t ihdr[ 13 ] = {
+    0, 0, 0, 0,                         // width
+    0, 0, 0, 0,                         // height
+    8,                                  // bits per channel
+    2,                                  // color type: RGB
+    0, 0, 0                             // compression, filter, interlace
+  };
+  for ( unsigned i = 0; i < 4; ++i ) {
+    ihdr[ 3 - i ] = STATIC_CAST( char8_t, opt_image_width >> (i * 8) );
+    ihdr[ 7 - i ] = STATIC_CAST( char8_t, height >> (i * 8) );
+  } // for
+  png_chunk( "IHDR", ihdr, sizeof ihdr );
+
+#ifdef HAVE_ZLIB_H
+  png->zbuf = MALLOC( char8_t, PNG_ZBUF_SIZE );
+  png->zs = (z_stream){ .zalloc = Z_NULL };
+  if ( deflateInit( &png->zs, Z_DEFAULT_COMPRESSION ) != Z_OK )
+    fatal_error( EX_SOFTWARE, "deflateInit() failed\n" );
+  png->zs.next_out = png->zbuf;
+  png->zs.avail_out = PNG_ZBUF_SIZE;
+#else
+  //
+  // Without zlib, write the image data as "stored" (uncompressed) deflate
+  // blocks, one per row, that any PNG decoder can read.
+  //
+  static char8_t const ZLIB_HEADER[] = { 0x78, 0x01 };
+  png_chunk( "IDAT", ZLIB_HEADER, sizeof ZLIB_HEADER );
+  png->adler = 1;
+#endif /* HAVE_ZLIB_H */
+}
+
+#ifdef HAVE_ZLIB_H
+/**
+ * Compresses data and writes an IDAT chunk whenever the buffer fills.
+ *
+ * @param png The \ref png_writer to use.
+ * @param flush The zlib flush value.
+ */
+static void png_deflate( png_writer_t *png, int flush ) {
+  for (;;) {
+    int const rv = deflate( &png->zs, flush );
+    if ( unlikely( rv == Z_STREAM_ERROR ) )
+      fatal_error( EX_SOFTWARE, "deflate() failed\n" );
+    bool const done = flush == Z_FINISH ?
+      rv == Z_STREAM_END : png->zs.avail_in == 0 && png->zs.avail_out > 0;
+    if ( png->zs.avail_out == 0 || (done && flush == Z_FINISH) ) {
+      size_t const len = PNG_ZBUF_SIZE - png->zs.avail_out;
+      if ( len > 0 )
+        png_chunk( "IDAT", png->zbuf, len );
+      png->zs.next_out = png->zbuf;
+      png->zs.avail_out = PNG_ZBUF_SIZE;
+    }
+    if ( done )
+      break;
+  } // for
+}
+#endif /* HAVE_ZLIB_H */
+
+/**
+ * Writes a row of a PNG image.
+ *
+ * @param png The \ref png_writer to use.
+ * @param row The row of pixels.
+ */
+static void png_row( png_writer_t *png, char8_t const *row ) {
+  static char8_t const FILTER_NONE[] = { 0 };
+  size_t const row_len = opt_image_width * PIXEL_SIZE;
+#ifdef HAVE_ZLIB_H
+  png->zs.next_in = CONST_CAST( char8_t*, FILTER_NONE );
+  png->zs.avail_in = 1;
+  png_deflate( png, Z_NO_FLUSH );
+  png->zs.next_in = CONST_CAST( char8_t*, row );
+  png->zs.avail_in = STATIC_CAST( unsigned, row_len );
+  png_deflate( png, Z_NO_FLUSH );
+#else
+  size_t const len = 1 + row_len;       // filter byte + pixels
+  char8_t *const block = MALLOC( char8_t, 5 + len );
+  block[0] = 0;                         // not final; stored
+  block[1] = STATIC_CAST( char8_t, len );
+  block[2] = STATIC_CAST( char8_t, len >> 8 );
+  block[3] = STATIC_CAST( char8_t, ~block[1] );
+  block[4] = STATIC_CAST( char8_t, ~block[2] );
+  block[5] = FILTER_NONE[0];
+  memcpy( block + 6, row, row_len );
+
+  uint32_t a = png->adler & 0xFFFF, b = png->adler >> 16;
+  for ( size_t i = 5; i < 5 + len; ++i ) {
+    a = (a + block[i]) % 65521;
+    b = (b + a) % 65521;
+  } // for
+  png->adler = (b << 16) | a;
+
+  png_chunk( "IDAT", block, 5 + len );
+  free( block );
+#endif /* HAVE_ZLIB_H */
+}
+
+/**
+ * Ends writing a PNG image.
+ *
+ * @param png The \ref png_writer to use.
+ */
+static void png_end( png_writer_t *png ) {
+#ifdef HAVE_ZLIB_H
+  png_deflate( png, Z_FINISH );
+  deflateEnd( &png->zs );
+  free( png->zbuf );
+#else
+  char8_t const end[] = {
+    1, 0, 0, 0xFF, 0xFF,                // final, empty stored block
+    STATIC_CAST( char8_t, png->adler >> 24 ),
+    STATIC_CAST( char8_t, png->adler >> 16 ),
+    STATIC_CAST( char8_t, png->adler >>  8 ),
+    STATIC_CAST( char8_t, png->adler       )
+  };
+  png_chunk( "IDAT", end, sizeof end );
+#endif /* HAVE_ZLIB_H */
+  png_chunk( "IEND", NULL, 0 );
+}
+
+/////////// extern functions //////////////////////////////////////////////////
+
+/**
+ * Outputs a file as an image where each pixel represents either a byte or, for
+ * large files, a block of bytes.
+ */
+void image_file( void ) {
+  unsigned const jobs = par_jobs();
+  image_job_t job = {
+    .begin = FTELL_FN( fin ),
+    .end = input_size(),
+    .bufs = MALLOC( char8_t*, jobs )
+  };
+  if ( job.end < job.begin )
+    job.end = job.begin;
+  if ( STATIC_CAST( uint64_t, job.end - job.begin ) > opt_max_bytes )
+    job.end = job.begin + STATIC_CAST( off_t, opt_max_bytes );
+  size_t const n_bytes = STATIC_CAST( size_t, job.end - job.begin );
+
+  //
+  // Downsample large files so the image is at most IMAGE_HEIGHT_MAX rows by
+  // aggregating blocks of bytes into pixels.
+  //
+  size_t const pixels_max = STATIC_CAST( size_t, opt_image_width ) *
+                            IMAGE_HEIGHT_MAX;
+  job.block_size = (n_bytes + pixels_max - 1) / pixels_max;
+  if ( job.block_size == 0 )
+    job.block_size = 1;
+  job.window = job.block_size;
+  if ( opt_image_entropy && job.window < ENTROPY_WINDOW_MIN )
+    job.window = ENTROPY_WINDOW_MIN;
+
+  size_t const n_pixels = (n_bytes + job.block_size - 1) / job.block_size;
+  size_t const height = n_pixels == 0 ? 1 :
+    (n_pixels + opt_image_width - 1) / opt_image_width;
+
+  //
+  // Each task calculates enough rows to read about a chunk's worth of bytes;
+  // each band is enough rows for all jobs so only a band's pixels are ever in
+  // memory.
+  //
+  size_t const row_bytes_in = opt_image_width * job.block_size;
+  job.task_rows = par_chunk_size() / row_bytes_in;
+  if ( job.task_rows == 0 )
+    job.task_rows = 1;
+  size_t const band_rows_max = job.task_rows * jobs;
+  size_t const row_len = opt_image_width * PIXEL_SIZE;
+  job.pixels = MALLOC( char8_t, band_rows_max * row_len );
+  for ( unsigned w = 0; w < jobs; ++w ) {
+    job.bufs[w] = MALLOC( char8_t,
+      job.task_rows * row_bytes_in + job.window - job.block_size
+    );
+  } // for
+
+  png_writer_t png;
+  if ( opt_image == IMAGE_PNG )
+    png_begin( &png, height );
+  else
+    PRINTF( "P6\n%u %zu\n255\n", opt_image_width, height );
+
+  for ( job.band_row = 0; job.band_row < height;
+        job.band_row += job.band_rows ) {
+    job.band_rows = height - job.band_row;
+    if ( job.band_rows > band_rows_max )
+      job.band_rows = band_rows_max;
+    par_for(
+      (job.band_rows + job.task_rows - 1) / job.task_rows, &image_task, &job
+    );
+    for ( size_t r = 0; r < job.band_rows; ++r ) {
+      char8_t const *const row = job.pixels + r * row_len;
+      if ( opt_image == IMAGE_PNG )
+        png_row( &png, row );
+      else
+        put_bytes( row, row_len );
+    } // for
+  } // for
+
+  if ( opt_image == IMAGE_PNG )
+    png_end( &png );
+  FFLUSH( fout );
+
+  for ( unsigned w = 0; w < jobs; ++w )
+    free( job.bufs[w] );
+  free( job.bufs );
+  free( job.pixels );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/** @} */
+
+/* vim:set et sw=2 ts=2: */
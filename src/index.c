@@ -0,0 +1,828 @@
+/*
+**      ad -- ASCII dump
+**      src/index.c
+**
+**      Copyright (C) 2024  Paul J. Lucas
+**
+**      This program is free software: you can redistribute it and/or modify
+**      it under the terms of the GNU General Public License as published by
+**      the Free Software Foundation, either version 3 of the License, or
+**      (at your option) any later version.
+**
+**      This program is distributed in the hope that it will be useful,
+**      but WITHOUT ANY WARRANTY; without even the implied warranty of
+**      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**      GNU General Public License for more details.
+**
+**      You should have received a copy of the GNU General Public License
+**      along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * Defines types and functions for building and searching an index of which
+ * files of a corpus might contain a sequence of bytes.
+ */
+
+// local
+#include "pjl_config.h"                 /* must go first */
+#include "ad.h"
+#include "match.h"
+#include "options.h"
+#include "parallel.h"
+#include "util.h"
+
+/// @cond DOXYGEN_IGNORE
+
+// standard
+#include <assert.h>
+#include <ctype.h>                      /* for tolower() */
+#include <errno.h>
+#include <fcntl.h>                      /* for open(2) */
+#include <stdalign.h>                   /* for alignof */
+#include <stdbool.h>
+#include <stddef.h>                     /* for size_t */
+#include <stdint.h>                     /* for uint*_t */
+#include <stdio.h>
+#include <stdlib.h>                     /* for calloc(), free(), qsort() */
+#include <string.h>                     /* for memcpy(), strcmp() */
+#include <sys/mman.h>                   /* for mmap(2) */
+#include <sys/stat.h>                   /* for stat(2) */
+#include <sysexits.h>
+#include <unistd.h>                     /* for close(2), read(2) */
+
+/// @endcond
+
+/**
+ * @defgroup index-group Corpus Indexes
+ * Types and functions for building and searching an index of which files of a
+ * corpus might contain a sequence of bytes.
+ *
+ * @remarks An index contains, for each file, a Bloom filter of the
+ * case-folded byte trigrams (3-grams) it contains.  A search for a sequence of
+ * bytes checks every trigram of the sequence against each filter: only files
+ * whose filters contain all of them (or that changed since being indexed) are
+ * actually searched.
+ *
+ * An index file is laid out so it can be used via **mmap**(2) directly:
+ *
+ *  1. An \ref index_header.
+ *  2. The Bloom filters, each an array of `uint64_t`.  Files whose filters
+ *     would be larger than they are (e.g., compressed files) have none and
+ *     are always searched.
+ *  3. An array of \ref index_file, sorted by path.
+ *  4. The paths, each null-terminated.
+ *
+ * All integers are in host byte order.
+ * @{
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+
+#define INDEX_BATCH_FILES     4096u     /**< Files indexed per batch.       */
+#define INDEX_BLOOM_K         7u        /**< Bloom filter hash functions.   */
+#define INDEX_BYTE_ORDER      0x01020304u /**< Detects other byte orders.   */
+#define INDEX_MAGIC           "ADINDEX" /**< Index file magic number.       */
+#define INDEX_NGRAM_LOG2      24u       /**< Bits in a trigram.             */
+#define INDEX_READ_SIZE       (64 * 1024u) /**< Bytes read at a time.       */
+#define INDEX_TASK_FILES      64u       /**< Files searched per task.       */
+#define INDEX_VERSION         1u        /**< Index file format version.     */
+
+/**
+ * Bits per distinct trigram in a Bloom filter; about a 1% false-positive
+ * rate with #INDEX_BLOOM_K hash functions.
+ */
+#define INDEX_BLOOM_BITS_PER_NGRAM  10u
+
+/**
+ * The number of `uint64_t` words of a "Bloom filter" that is instead the exact
+ * set of a file's trigrams, one bit per possible trigram.
+ */
+#define INDEX_EXACT_WORDS     ((1u << INDEX_NGRAM_LOG2) / 64)
+
+/**
+ * The number of distinct trigrams beyond which a file's Bloom filter would be
+ * larger than the exact set of its trigrams.
+ */
+#define INDEX_NGRAMS_EXACT \
+  ((INDEX_EXACT_WORDS - 1) * 64 / INDEX_BLOOM_BITS_PER_NGRAM)
+
+/**
+ * An index file header.
+ */
+struct index_header {
+  char      magic[8];                   ///< #INDEX_MAGIC
+  uint32_t  version;                    ///< #INDEX_VERSION
+  uint32_t  byte_order;                 ///< #INDEX_BYTE_ORDER
+  uint64_t  files_len;                  ///< Number of files.
+  uint64_t  files_offset;               ///< Offset of \ref index_file array.
+  uint64_t  paths_offset;               ///< Offset of paths.
+  uint64_t  paths_len;                  ///< Total bytes of paths.
+};
+typedef struct index_header index_header_t;
+
+/**
+ * An index file entry for an indexed file.
+ */
+struct index_file {
+  uint64_t  path_offset;                ///< Offset of path within paths.
+  uint64_t  size;                       ///< Size of file when indexed.
+  int64_t   mtime;                      ///< Modification time when indexed.
+  uint64_t  bloom_offset;               ///< Offset of Bloom filter.
+  uint32_t  bloom_words;                ///< Words in Bloom filter or 0.
+  uint32_t  path_len;                   ///< Length of path.
+};
+typedef struct index_file index_file_t;
+
+/**
+ * A file being (re)indexed.
+ */
+struct index_entry {
+  char const     *path;                 ///< Path of file.
+  uint64_t        size;                 ///< Size of file.
+  int64_t         mtime;                ///< Modification time of file.
+  uint64_t const *old_bloom;            ///< Unchanged Bloom filter or NULL.
+  uint64_t       *bloom;                ///< New Bloom filter or NULL.
+  uint32_t        bloom_words;          ///< Words in Bloom filter.
+  bool            is_indexed;           ///< Indexed successfully?
+};
+typedef struct index_entry index_entry_t;
+
+/**
+ * A memory-mapped index file.
+ */
+struct index_map {
+  void const           *addr;           ///< Mapped address or NULL if none.
+  size_t                len;            ///< Mapped length.
+  index_header_t const *header;         ///< Header.
+  index_file_t const   *files;          ///< Files.
+  char const           *paths;          ///< Paths.
+};
+typedef struct index_map index_map_t;
+
+/**
+ * Per-worker state for building an index.
+ */
+struct index_worker {
+  uint64_t     *seen;                   ///< One bit per possible trigram or NULL.
+  uint32_t     *ngrams;                 ///< Distinct trigrams seen.
+  size_t        ngrams_len;             ///< Length of \ref ngrams.
+  size_t        ngrams_cap;             ///< Capacity of \ref ngrams.
+  char8_t      *buf;                    ///< Read buffer.
+};
+typedef struct index_worker index_worker_t;
+
+/**
+ * Data shared by all tasks of building an index.
+ */
+struct index_build_job {
+  index_entry_t  *entries;              ///< Entries of current batch.
+  index_worker_t *workers;              ///< Per-worker state.
+};
+typedef struct index_build_job index_build_job_t;
+
+/**
+ * Data shared by all tasks of searching an index.
+ */
+struct index_search_job {
+  index_map_t const  *map;              ///< Index being searched.
+  uint32_t           *ngrams;           ///< Trigrams of search bytes.
+  size_t              ngrams_len;       ///< Length of \ref ngrams.
+  size_t const       *kmps;             ///< KMP table for search bytes.
+  char8_t           **bufs;             ///< Per-worker read buffers.
+  bool               *matches;          ///< Which files match.
+};
+typedef struct index_search_job index_search_job_t;
+
+// local variables
+static char8_t  fold_table[ 256 ];      ///< Case-folded bytes.
+
+////////// inline functions ///////////////////////////////////////////////////
+
+/**
+ * Appends the case-folded \a byte to a rolling trigram.
+ *
+ * @param ngram The trigram so far.
+ * @param byte The byte to append.
+ * @return Returns the new trigram.
+ */
+NODISCARD
+static inline uint32_t ngram_push( uint32_t ngram, char8_t byte ) {
+  return ((ngram << 8) | fold_table[ byte ]) &
+         ((1u << INDEX_NGRAM_LOG2) - 1);
+}
+
+/**
+ * Gets the _i_th bit number of \a ngram in a Bloom filter.
+ *
+ * @param ngram The trigram.
+ * @param words The number of `uint64_t` words in the Bloom filter.
+ * @param i Which hash function in [0, #INDEX_BLOOM_K).
+ * @return Returns said bit number.
+ */
+NODISCARD
+static inline uint32_t bloom_bit( uint32_t ngram, uint32_t words, unsigned i ) {
+  if ( words == INDEX_EXACT_WORDS )     // exact set of trigrams
+    return ngram;
+  uint64_t h = (ngram + 1) * UINT64_C(0x9E3779B97F4A7C15);
+  h ^= h >> 31;
+  uint32_t const h1 = STATIC_CAST( uint32_t, h );
+  uint32_t const h2 = STATIC_CAST( uint32_t, h >> 32 ) | 1;
+  // Map the hash onto [0, bits) via multiply-shift rather than modulo.
+  return STATIC_CAST( uint32_t,
+    (STATIC_CAST( uint64_t, h1 + i * h2 ) * words * 64) >> 32
+  );
+}
+
+/**
+ * Gets the number of hash functions used for a Bloom filter.
+ *
+ * @param words The number of `uint64_t` words in the Bloom filter.
+ * @return Returns said number.
+ */
+NODISCARD
+static inline unsigned bloom_k( uint32_t words ) {
+  return words == INDEX_EXACT_WORDS ? 1 : INDEX_BLOOM_K;
+}
+
+////////// local functions ////////////////////////////////////////////////////
+
+/**
+ * Initializes \ref fold_table.
+ */
+static void fold_init( void ) {
+  for ( unsigned i = 0; i < 256; ++i )
+    fold_table[i] = STATIC_CAST( char8_t, tolower( STATIC_CAST( int, i ) ) );
+}
+
+/**
+ * Checks whether a Bloom filter might contain all of some trigrams.
+ *
+ * @param bloom The Bloom filter.
+ * @param words The number of `uint64_t` words in \a bloom or 0 for none.
+ * @param ngrams The trigrams.
+ * @param ngrams_len The number of \a ngrams.
+ * @return Returns `true` only if \a bloom might contain all \a ngrams.
+ */
+NODISCARD
+static bool bloom_has_all( uint64_t const *bloom, uint32_t words,
+                           uint32_t const *ngrams, size_t ngrams_len ) {
+  if ( words == 0 )
+    return true;
+  unsigned const k = bloom_k( words );
+  for ( size_t n = 0; n < ngrams_len; ++n ) {
+    for ( unsigned i = 0; i < k; ++i ) {
+      uint32_t const bit = bloom_bit( ngrams[n], words, i );
+      if ( (bloom[ bit >> 6 ] & (UINT64_C(1) << (bit & 63))) == 0 )
+        return false;
+    } // for
+  } // for
+  return true;
+}
+
+/**
+ * Maps an existing index file into memory and checks it.
+ *
+ * @param path The path of the index file.
+ * @param map The \ref index_map to initialize.
+ * @return Returns `true` only if the index file exists.
+ */
+NODISCARD
+static bool index_map( char const *path, index_map_t *map ) {
+  *map = (index_map_t){ .addr = NULL };
+  int const fd = open( path, O_RDONLY );
+  if ( fd == -1 ) {
+    if ( errno == ENOENT )
+      return false;
+    fatal_error( EX_NOINPUT, "\"%s\": %s\n", path, STRERROR() );
+  }
+  struct stat fd_stat;
+  FSTAT( fd, &fd_stat );
+  map->len = STATIC_CAST( size_t, fd_stat.st_size );
+  if ( map->len < sizeof( index_header_t ) )
+    goto invalid;
+  map->addr = mmap( NULL, map->len, PROT_READ, MAP_PRIVATE, fd, 0 );
+  if ( unlikely( map->addr == MAP_FAILED ) )
+    fatal_error( EX_IOERR, "\"%s\": can not mmap: %s\n", path, STRERROR() );
+  close( fd );
+
+  char const *const base = map->addr;
+  map->header = map->addr;
+  if ( memcmp( map->header->magic, INDEX_MAGIC, sizeof INDEX_MAGIC ) != 0 ||
+       map->header->version != INDEX_VERSION ||
+       map->header->byte_order != INDEX_BYTE_ORDER ||
+       map->header->files_offset > map->len ||
+       map->header->files_offset % alignof( index_file_t ) != 0 ||
+       map->header->files_len > (map->len - map->header->files_offset) /
+                                sizeof( index_file_t ) ||
+       map->header->paths_offset > map->len ||
+       map->header->paths_len > map->len - map->header->paths_offset ) {
+    goto invalid;
+  }
+  map->files = POINTER_CAST( index_file_t const*,
+    base + map->header->files_offset
+  );
+  map->paths = base + map->header->paths_offset;
+
+  for ( uint64_t i = 0; i < map->header->files_len; ++i ) {
+    index_file_t const *const file = &map->files[i];
+    if ( file->path_offset + file->path_len >= map->header->paths_len ||
+         map->paths[ file->path_offset + file->path_len ] != '\0' ||
+         file->bloom_words > INDEX_EXACT_WORDS ||
+         file->bloom_offset % sizeof( uint64_t ) != 0 ||
+         file->bloom_offset > map->len ||
+         file->bloom_words >
+          (map->len - file->bloom_offset) / sizeof( uint64_t ) ) {
+      goto invalid;
+    }
+  } // for
+  return true;
+
+invalid:
+  fatal_error( EX_DATAERR, "\"%s\": invalid index file\n", path );
+}
+
+/**
+ * Gets the Bloom filter of an indexed file.
+ *
+ * @param map The \ref index_map to use.
+ * @param file The \ref index_file to get the Bloom filter of.
+ * @return Returns said Bloom filter.
+ */
+NODISCARD
+static uint64_t const* index_map_bloom( index_map_t const *map,
+                                        index_file_t const *file ) {
+  return POINTER_CAST( uint64_t const*,
+    STATIC_CAST( char const*, map->addr ) + file->bloom_offset
+  );
+}
+
+/**
+ * Compares two \ref index_entry by path for **qsort**(3).
+ *
+ * @param i_data A pointer to the first \ref index_entry.
+ * @param j_data A pointer to the second \ref index_entry.
+ * @return Returns a number less than 0, 0, or greater than 0 if the first
+ * path is less than, equal to, or greater than the second, respectively.
+ */
+NODISCARD
+static int index_entry_cmp( void const *i_data, void const *j_data ) {
+  index_entry_t const *const i = i_data;
+  index_entry_t const *const j = j_data;
+  return strcmp( i->path, j->path );
+}
+
+/**
+ * Calculates the Bloom filter of one file.
+ *
+ * @param data A pointer to the \ref index_build_job.
+ * @param task The index of the \ref index_entry within the current batch.
+ * @param worker The worker number.
+ */
+static void index_build_task( void *data, size_t task, unsigned worker ) {
+  index_build_job_t const *const job = data;
+  index_entry_t *const entry = &job->entries[ task ];
+  index_worker_t *const w = &job->workers[ worker ];
+
+  if ( entry->old_bloom != NULL )
+    return;                             // unchanged since last indexed
+  int const fd = open( entry->path, O_RDONLY );
+  if ( unlikely( fd == -1 ) )
+    return;
+
+  size_t const seen_words = INDEX_EXACT_WORDS;
+  if ( w->seen == NULL ) {
+    //
+    // Allocate the bitset only when a worker first indexes a file and via
+    // calloc(3) so its pages are backed by memory only once touched: with
+    // many jobs, eagerly zeroing a bitset per worker would cost gigabytes.
+    //
+    w->seen = calloc( seen_words, sizeof( uint64_t ) );
+    PERROR_EXIT_IF( w->seen == NULL, EX_OSERR );
+  }
+  bool is_exact = false;
+  uint32_t ngram = 0;
+  uint64_t bytes = 0;
+  w->ngrams_len = 0;
+
+  for (;;) {
+    ssize_t const bytes_read = read( fd, w->buf, INDEX_READ_SIZE );
+    if ( bytes_read <= 0 ) {
+      if ( unlikely( bytes_read < 0 ) ) {
+        close( fd );
+        goto clear;
+      }
+      break;
+    }
+    for ( ssize_t i = 0; i < bytes_read; ++i ) {
+      ngram = ngram_push( ngram, w->buf[i] );
+      if ( ++bytes < 3 )
+        continue;
+      uint64_t *const word = &w->seen[ ngram >> 6 ];
+      uint64_t const mask = UINT64_C(1) << (ngram & 63);
+      if ( (*word & mask) != 0 )
+        continue;
+      *word |= mask;
+      if ( is_exact )
+        continue;
+      if ( w->ngrams_len == INDEX_NGRAMS_EXACT ) {
+        is_exact = true;
+        continue;
+      }
+      if ( w->ngrams_len == w->ngrams_cap ) {
+        w->ngrams_cap = w->ngrams_cap == 0 ? 4096 : w->ngrams_cap * 2;
+        REALLOC( w->ngrams, w->ngrams_cap );
+      }
+      w->ngrams[ w->ngrams_len++ ] = ngram;
+    } // for
+  } // for
+  close( fd );
+
+  uint32_t const words = is_exact ? INDEX_EXACT_WORDS : STATIC_CAST(
+    uint32_t, (w->ngrams_len * INDEX_BLOOM_BITS_PER_NGRAM + 63) / 64
+  );
+  if ( words * sizeof( uint64_t ) > bytes ) {
+    entry->bloom_words = 0;             // not worth it: always search
+  }
+  else if ( is_exact ) {
+    entry->bloom_words = words;
+    entry->bloom = MALLOC( uint64_t, seen_words );
+    memcpy( entry->bloom, w->seen, seen_words * sizeof( uint64_t ) );
+  }
+  else {
+    entry->bloom_words = words;
+    entry->bloom = MALLOC( uint64_t, words );
+    memset( entry->bloom, 0, words * sizeof( uint64_t ) );
+    unsigned const k = bloom_k( words );
+    for ( size_t n = 0; n < w->ngrams_len; ++n ) {
+      for ( unsigned i = 0; i < k; ++i ) {
+        uint32_t const bit = bloom_bit( w->ngrams[n], words, i );
+        entry->bloom[ bit >> 6 ] |= UINT64_C(1) << (bit & 63);
+      } // for
+    } // for
+  }
+  entry->is_indexed = true;
+
+clear:
+  if ( is_exact ) {
+    memset( w->seen, 0, seen_words * sizeof( uint64_t ) );
+  }
+  else {
+    for ( size_t n = 0; n < w->ngrams_len; ++n )
+      w->seen[ w->ngrams[n] >> 6 ] = 0;
+  }
+}
+
+/**
+ * Writes bytes to the index file being built.
+ *
+ * @param buf The bytes to write.
+ * @param len The number of bytes.
+ * @param file The index file.
+ * @param path The path of \a file.
+ */
+static void index_write( void const *buf, size_t len, FILE *file,
+                         char const *path ) {
+  if ( unlikely( len > 0 && fwrite( buf, 1, len, file ) < len ) )
+    fatal_error( EX_IOERR, "\"%s\": %s\n", path, STRERROR() );
+}
+
+/**
+ * Reads paths of files to index, one per line, from standard input.
+ *
+ * @param entries A pointer to the array of \ref index_entry to append to.
+ * @param entries_len A pointer to the length of \a *entries.
+ * @param entries_cap A pointer to the capacity of \a *entries.
+ */
+static void index_read_paths( index_entry_t **entries, size_t *entries_len,
+                              size_t *entries_cap ) {
+  for (;;) {
+    size_t line_len;
+    char const *const line = fgetln( fin, &line_len );
+    if ( line == NULL ) {
+      if ( unlikely( ferror( fin ) ) )
+        fatal_error( EX_IOERR, "can not read: %s\n", STRERROR() );
+      break;
+    }
+    if ( line_len > 0 && line[ line_len - 1 ] == '\n' )
+      --line_len;
+    if ( line_len == 0 )
+      continue;
+    char *const path = free_later( MALLOC( char, line_len + 1 ) );
+    memcpy( path, line, line_len );
+    path[ line_len ] = '\0';
+    if ( *entries_len == *entries_cap ) {
+      *entries_cap = *entries_cap == 0 ? 1024 : *entries_cap * 2;
+      REALLOC( *entries, *entries_cap );
+    }
+    (*entries)[ (*entries_len)++ ] = (index_entry_t){ .path = path };
+  } // for
+}
+
+/**
+ * Builds or incrementally updates an index.
+ *
+ * @remarks The files indexed are those already in the index, if any, plus
+ * those in \ref opt_index_files.  Files that no longer exist are dropped.
+ * Only files whose size or modification time changed are read again; files
+ * are read in parallel.  The new index is written to a temporary file that
+ * then replaces the old one.
+ */
+static void index_build( void ) {
+  index_map_t old;
+  bool const has_old = index_map( opt_index_path, &old );
+
+  size_t entries_len = 0;
+  size_t entries_cap = (has_old ? old.header->files_len : 0) +
+                       opt_index_files_len;
+  index_entry_t *entries = MALLOC( index_entry_t, entries_cap + 1 );
+
+  if ( has_old ) {
+    for ( uint64_t i = 0; i < old.header->files_len; ++i ) {
+      entries[ entries_len++ ] = (index_entry_t){
+        .path = old.paths + old.files[i].path_offset
+      };
+    } // for
+  }
+  for ( size_t i = 0; i < opt_index_files_len; ++i ) {
+    if ( strcmp( opt_index_files[i], "-" ) == 0 )
+      index_read_paths( &entries, &entries_len, &entries_cap );
+    else
+      entries[ entries_len++ ] = (index_entry_t){
+        .path = opt_index_files[i]
+      };
+  } // for
+
+  // sort by path and remove duplicates
+  qsort( entries, entries_len, sizeof( index_entry_t ), &index_entry_cmp );
+  size_t n = 0;
+  for ( size_t i = 0; i < entries_len; ++i ) {
+    if ( n > 0 && strcmp( entries[ n - 1 ].path, entries[i].path ) == 0 )
+      continue;
+    entries[ n++ ] = entries[i];
+  } // for
+  entries_len = n;
+
+  // find unchanged files whose Bloom filters can be reused
+  size_t old_i = 0;
+  for ( size_t i = 0; i < entries_len; ++i ) {
+    index_entry_t *const entry = &entries[i];
+    struct stat path_stat;
+    if ( stat( entry->path, &path_stat ) == -1 || !S_ISREG( path_stat.st_mode ) )
+      continue;                         // is_indexed remains false
+    entry->size = STATIC_CAST( uint64_t, path_stat.st_size );
+    entry->mtime = STATIC_CAST( int64_t, path_stat.st_mtime );
+    if ( !has_old )
+      continue;
+    int cmp = 1;
+    for ( ; old_i < old.header->files_len; ++old_i ) {
+      cmp = strcmp( old.paths + old.files[ old_i ].path_offset, entry->path );
+      if ( cmp >= 0 )
+        break;
+    } // for
+    if ( cmp == 0 ) {
+      index_file_t const *const file = &old.files[ old_i ];
+      if ( file->size == entry->size && file->mtime == entry->mtime ) {
+        entry->old_bloom = index_map_bloom( &old, file );
+        entry->bloom_words = file->bloom_words;
+        entry->is_indexed = true;
+      }
+    }
+  } // for
+
+  char *const tmp_path = free_later(
+    MALLOC( char, strlen( opt_index_path ) + sizeof ".tmp" )
+  );
+  strcpy( tmp_path, opt_index_path );
+  strcat( tmp_path, ".tmp" );
+  FILE *const tmp_file = fopen( tmp_path, "w" );
+  if ( unlikely( tmp_file == NULL ) )
+    fatal_error( EX_CANTCREAT, "\"%s\": %s\n", tmp_path, STRERROR() );
+
+  index_header_t header = {
+    .magic = INDEX_MAGIC,
+    .version = INDEX_VERSION,
+    .byte_order = INDEX_BYTE_ORDER
+  };
+  index_write( &header, sizeof header, tmp_file, tmp_path );
+  uint64_t offset = sizeof header;
+
+  unsigned const jobs = par_jobs();
+  index_worker_t *const workers = MALLOC( index_worker_t, jobs );
+  for ( unsigned w = 0; w < jobs; ++w ) {
+    workers[w] = (index_worker_t){
+      .buf = MALLOC( char8_t, INDEX_READ_SIZE )
+    };
+  } // for
+
+  index_file_t *const files = MALLOC( index_file_t, entries_len + 1 );
+  uint64_t files_len = 0;
+  uint64_t paths_len = 0;
+
+  fold_init();
+  for ( size_t b = 0; b < entries_len; b += INDEX_BATCH_FILES ) {
+    size_t batch_len = entries_len - b;
+    if ( batch_len > INDEX_BATCH_FILES )
+      batch_len = INDEX_BATCH_FILES;
+    index_build_job_t job = { .entries = entries + b, .workers = workers };
+    par_for( batch_len, &index_build_task, &job );
+
+    for ( size_t i = 0; i < batch_len; ++i ) {
+      index_entry_t *const entry = &job.entries[i];
+      if ( !entry->is_indexed ) {
+        EPRINTF( "%s: \"%s\": %s; skipped\n",
+          me, entry->path, "can not read file"
+        );
+        continue;
+      }
+      size_t const path_len = strlen( entry->path );
+      files[ files_len++ ] = (index_file_t){
+        .path_offset = paths_len,
+        .size = entry->size,
+        .mtime = entry->mtime,
+        .bloom_offset = offset,
+        .bloom_words = entry->bloom_words,
+        .path_len = STATIC_CAST( uint32_t, path_len )
+      };
+      paths_len += path_len + 1;
+      size_t const bloom_len = entry->bloom_words * sizeof( uint64_t );
+      index_write(
+        entry->bloom != NULL ? entry->bloom : entry->old_bloom, bloom_len,
+        tmp_file, tmp_path
+      );
+      offset += bloom_len;
+      free( entry->bloom );
+      entry->bloom = NULL;
+    } // for
+  } // for
+
+  header.files_len = files_len;
+  header.files_offset = offset;
+  index_write( files, files_len * sizeof( index_file_t ), tmp_file, tmp_path );
+  offset += files_len * sizeof( index_file_t );
+  header.paths_offset = offset;
+  header.paths_len = paths_len;
+  for ( uint64_t i = 0, e = 0; i < files_len; ++i, ++e ) {
+    while ( !entries[e].is_indexed )
+      ++e;
+    index_write( entries[e].path, files[i].path_len + 1, tmp_file, tmp_path );
+  } // for
+
+  if ( unlikely( fseek( tmp_file, 0, SEEK_SET ) != 0 ) )
+    fatal_error( EX_IOERR, "\"%s\": %s\n", tmp_path, STRERROR() );
+  index_write( &header, sizeof header, tmp_file, tmp_path );
+  if ( unlikely( fclose( tmp_file ) != 0 ) )
+    fatal_error( EX_IOERR, "\"%s\": %s\n", tmp_path, STRERROR() );
+  if ( unlikely( rename( tmp_path, opt_index_path ) != 0 ) ) {
+    fatal_error( EX_CANTCREAT,
+      "\"%s\": can not rename to \"%s\": %s\n",
+      tmp_path, opt_index_path, STRERROR()
+    );
+  }
+
+  for ( unsigned w = 0; w < jobs; ++w ) {
+    free( workers[w].seen );
+    free( workers[w].ngrams );
+    free( workers[w].buf );
+  } // for
+  free( workers );
+  free( files );
+  free( entries );
+  if ( has_old )
+    munmap( CONST_CAST( void*, old.addr ), old.len );
+}
+
+/**
+ * Checks whether each of some indexed files contains \ref opt_search_buf.
+ *
+ * @param data A pointer to the \ref index_search_job.
+ * @param task The task number: each task checks #INDEX_TASK_FILES files.
+ * @param worker The worker number.
+ */
+static void index_search_task( void *data, size_t task, unsigned worker ) {
+  index_search_job_t const *const job = data;
+  index_map_t const *const map = job->map;
+  char8_t *const buf = job->bufs[ worker ];
+
+  uint64_t const begin = task * INDEX_TASK_FILES;
+  uint64_t end = begin + INDEX_TASK_FILES;
+  if ( end > map->header->files_len )
+    end = map->header->files_len;
+
+  for ( uint64_t i = begin; i < end; ++i ) {
+    index_file_t const *const file = &map->files[i];
+    char const *const path = map->paths + file->path_offset;
+    struct stat path_stat;
+    if ( stat( path, &path_stat ) == -1 )
+      continue;
+    if ( opt_search_len == 0 ) {        // everything contains nothing
+      job->matches[i] = true;
+      continue;
+    }
+    bool const is_unchanged =
+      STATIC_CAST( uint64_t, path_stat.st_size ) == file->size &&
+      STATIC_CAST( int64_t, path_stat.st_mtime ) == file->mtime;
+    if ( is_unchanged &&
+         !bloom_has_all( index_map_bloom( map, file ), file->bloom_words,
+                         job->ngrams, job->ngrams_len ) ) {
+      continue;
+    }
+
+    int const fd = open( path, O_RDONLY );
+    if ( fd == -1 )
+      continue;
+    size_t kmp = 0;
+    for (;;) {
+      ssize_t const bytes_read = read( fd, buf, INDEX_READ_SIZE );
+      if ( bytes_read <= 0 )
+        break;
+      if ( match_block( buf, STATIC_CAST( size_t, bytes_read ), job->kmps,
+                        &kmp ) ) {
+        job->matches[i] = true;
+        break;
+      }
+    } // for
+    close( fd );
+  } // for
+}
+
+/**
+ * Prints the paths of indexed files that contain \ref opt_search_buf.
+ *
+ * @remarks Only files whose Bloom filters contain every trigram of \ref
+ * opt_search_buf, or that changed since they were indexed, are searched.
+ * Files are searched in parallel, but printed in index (path) order.
+ */
+static void index_search( void ) {
+  index_map_t map;
+  if ( !index_map( opt_index_path, &map ) )
+    fatal_error( EX_NOINPUT, "\"%s\": %s\n", opt_index_path, STRERROR() );
+
+  fold_init();
+  index_search_job_t job = { .map = &map };
+  if ( opt_search_len >= 3 ) {
+    job.ngrams = MALLOC( uint32_t, opt_search_len - 2 );
+    uint32_t ngram = 0;
+    for ( size_t i = 0; i < opt_search_len; ++i ) {
+      ngram = ngram_push(
+        ngram, STATIC_CAST( char8_t, opt_search_buf[i] )
+      );
+      if ( i >= 2 )
+        job.ngrams[ job.ngrams_len++ ] = ngram;
+    } // for
+  }
+
+  if ( opt_search_len > 0 )
+    job.kmps = kmp_new( opt_search_buf, opt_search_len );
+  unsigned const jobs = par_jobs();
+  job.bufs = MALLOC( char8_t*, jobs );
+  for ( unsigned w = 0; w < jobs; ++w )
+    job.bufs[w] = MALLOC( char8_t, INDEX_READ_SIZE );
+  size_t const files_len = STATIC_CAST( size_t, map.header->files_len );
+  job.matches = MALLOC( bool, files_len + 1 );
+  memset( job.matches, 0, files_len * sizeof( bool ) );
+
+  par_for(
+    (files_len + INDEX_TASK_FILES - 1) / INDEX_TASK_FILES,
+    &index_search_task, &job
+  );
+
+  for ( size_t i = 0; i < files_len; ++i ) {
+    if ( job.matches[i] ) {
+      PUTS( map.paths + map.files[i].path_offset );
+      PUTC( '\n' );
+      ++total_matches;
+    }
+  } // for
+  FFLUSH( fout );
+
+  for ( unsigned w = 0; w < jobs; ++w )
+    free( job.bufs[w] );
+  free( job.bufs );
+  free( job.matches );
+  free( job.ngrams );
+  FREE( job.kmps );
+  munmap( CONST_CAST( void*, map.addr ), map.len );
+
+  if ( total_matches == 0 )
+    exit( EX_NO_MATCHES );
+}
+
+/////////// extern functions //////////////////////////////////////////////////
+
+/**
+ * Builds or updates the index \ref opt_index_path or, if searching, prints
+ * the paths of indexed files that contain what's being searched for.
+ */
+void index_files( void ) {
+  if ( opt_search_buf != NULL )
+    index_search();
+  else
+    index_build();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/** @} */
+
+/* vim:set et sw=2 ts=2: */
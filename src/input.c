@@ -0,0 +1,337 @@
+/*
+**      ad -- ASCII dump
+**      src/input.c
+**
+**      Copyright (C) 2024  Paul J. Lucas
+**
+**      This program is free software: you can redistribute it and/or modify
+**      it under the terms of the GNU General Public License as published by
+**      the Free Software Foundation, either version 3 of the License, or
+**      (at your option) any later version.
+**
+**      This program is distributed in the hope that it will be useful,
+**      but WITHOUT ANY WARRANTY; without even the implied warranty of
+**      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**      GNU General Public License for more details.
+**
+**      You should have received a copy of the GNU General Public License
+**      along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * Defines functions for reading the input, possibly split into parts.
+ */
+
+// local
+#include "pjl_config.h"                 /* must go first */
+#include "ad.h"
+#include "input.h"
+#include "util.h"
+
+/// @cond DOXYGEN_IGNORE
+
+// standard
+#include <assert.h>
+#include <ctype.h>                      /* for isdigit() */
+#include <errno.h>
+#include <fcntl.h>                      /* for open(2) */
+#include <stdio.h>
+#include <stdlib.h>                     /* for strtoull() */
+#include <string.h>                     /* for strlen() */
+#include <sys/resource.h>               /* for getrlimit(2) */
+#include <sys/stat.h>                   /* for fstat(2) */
+#include <sysexits.h>
+#include <unistd.h>                     /* for lseek(2), pread(2) */
+
+/// @endcond
+
+/**
+ * @addtogroup input-group
+ * @{
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A part of a split input.
+ */
+struct input_part {
+  int   fd;                             ///< File descriptor.
+  off_t begin;                          ///< Offset of first byte in input.
+  off_t size;                           ///< Number of bytes.
+};
+typedef struct input_part input_part_t;
+
+/**
+ * A split input.
+ */
+struct input_split {
+  input_part_t *parts;                  ///< Parts in ascending offset order.
+  size_t        len;                    ///< Number of parts; 0 if not split.
+  off_t         size;                   ///< Sum of the sizes of all parts.
+  off_t         pos;                    ///< Offset of the stream.
+};
+typedef struct input_split input_split_t;
+
+// local variable definitions
+static input_split_t  split;            ///< The split input, if any.
+
+////////// local functions ////////////////////////////////////////////////////
+
+/**
+ * Gets the index of the part containing \a offset.
+ *
+ * @param offset The offset within the input; must be less than its size.
+ * @return Returns said index.
+ */
+NODISCARD
+static size_t input_part_index( off_t offset ) {
+  assert( offset < split.size );
+  size_t lo = 0, hi = split.len;
+  while ( hi - lo > 1 ) {
+    size_t const mid = lo + (hi - lo) / 2;
+    if ( split.parts[ mid ].begin <= offset )
+      lo = mid;
+    else
+      hi = mid;
+  } // while
+  return lo;
+}
+
+/**
+ * Raises the soft limit of open files to the hard limit so inputs split into
+ * thousands of parts can be opened.
+ *
+ * @return Returns `true` only if the limit was raised.
+ */
+NODISCARD
+static bool input_raise_fd_limit( void ) {
+  struct rlimit rl;
+  if ( getrlimit( RLIMIT_NOFILE, &rl ) != 0 || rl.rlim_cur == rl.rlim_max )
+    return false;
+  rl.rlim_cur = rl.rlim_max;
+  return setrlimit( RLIMIT_NOFILE, &rl ) == 0;
+}
+
+/**
+ * Reads from the split input like **read**(2).
+ *
+ * @param cookie Not used.
+ * @param buf The buffer to read into.
+ * @param buf_len The maximum number of bytes to read.
+ * @return Returns the number of bytes read or -1 on error.
+ */
+static ssize_t input_cookie_read( void *cookie, char *buf, size_t buf_len ) {
+  (void)cookie;
+  ssize_t const bytes_read = input_pread( buf, buf_len, split.pos );
+  if ( bytes_read > 0 )
+    split.pos += bytes_read;
+  return bytes_read;
+}
+
+/**
+ * Sets the offset of the split input like **lseek**(2).
+ *
+ * @param cookie Not used.
+ * @param poffset A pointer to the offset relative to \a whence; set to the new
+ * offset.
+ * @param whence One of `SEEK_CUR`, `SEEK_END`, or `SEEK_SET`.
+ * @return Returns 0 on success or -1 on error.
+ */
+static int input_cookie_seek( void *cookie, off_t *poffset, int whence ) {
+  (void)cookie;
+  off_t offset = *poffset;
+  switch ( whence ) {
+    case SEEK_CUR: offset += split.pos;  break;
+    case SEEK_END: offset += split.size; break;
+    case SEEK_SET:                       break;
+    default      : errno = EINVAL; return -1;
+  } // switch
+  if ( offset < 0 ) {
+    errno = EINVAL;
+    return -1;
+  }
+  *poffset = split.pos = offset;
+  return 0;
+}
+
+#if defined(HAVE_FOPENCOOKIE)
+/**
+ * Adapts input_cookie_seek() to the signature required by **fopencookie**(3).
+ *
+ * @param cookie Not used.
+ * @param poffset A pointer to the offset relative to \a whence.
+ * @param whence One of `SEEK_CUR`, `SEEK_END`, or `SEEK_SET`.
+ * @return Returns 0 on success or -1 on error.
+ */
+static int input_fopencookie_seek( void *cookie, off64_t *poffset,
+                                   int whence ) {
+  off_t offset = STATIC_CAST( off_t, *poffset );
+  int const rv = input_cookie_seek( cookie, &offset, whence );
+  *poffset = offset;
+  return rv;
+}
+#elif defined(HAVE_FUNOPEN)
+/**
+ * Adapts input_cookie_read() to the signature required by **funopen**(3).
+ *
+ * @param cookie Not used.
+ * @param buf The buffer to read into.
+ * @param buf_len The maximum number of bytes to read.
+ * @return Returns the number of bytes read or -1 on error.
+ */
+static int input_funopen_read( void *cookie, char *buf, int buf_len ) {
+  return STATIC_CAST( int,
+    input_cookie_read( cookie, buf, STATIC_CAST( size_t, buf_len ) )
+  );
+}
+
+/**
+ * Adapts input_cookie_seek() to the signature required by **funopen**(3).
+ *
+ * @param cookie Not used.
+ * @param offset The offset relative to \a whence.
+ * @param whence One of `SEEK_CUR`, `SEEK_END`, or `SEEK_SET`.
+ * @return Returns the new offset or -1 on error.
+ */
+static fpos_t input_funopen_seek( void *cookie, fpos_t offset, int whence ) {
+  off_t new_offset = STATIC_CAST( off_t, offset );
+  if ( input_cookie_seek( cookie, &new_offset, whence ) == -1 )
+    return -1;
+  return STATIC_CAST( fpos_t, new_offset );
+}
+#endif /* HAVE_FOPENCOOKIE */
+
+////////// extern functions ///////////////////////////////////////////////////
+
+bool input_is_file( void ) {
+  return split.len > 0 || fd_is_file( STDIN_FILENO );
+}
+
+ssize_t input_pread( void *buf, size_t len, off_t offset ) {
+  if ( split.len == 0 )
+    return pread( STDIN_FILENO, buf, len, offset );
+
+  char *p = buf;
+  if ( offset < split.size ) {
+    for ( size_t i = input_part_index( offset ); len > 0 && i < split.len;
+          ++i ) {
+      input_part_t const *const part = &split.parts[i];
+      off_t const part_left = part->size - (offset - part->begin);
+      size_t part_len = len;
+      if ( STATIC_CAST( off_t, part_len ) > part_left )
+        part_len = STATIC_CAST( size_t, part_left );
+      while ( part_len > 0 ) {
+        ssize_t const bytes_read =
+          pread( part->fd, p, part_len, offset - part->begin );
+        if ( bytes_read <= 0 ) {
+          if ( p > STATIC_CAST( char*, buf ) )
+            goto done;                  // return what was read
+          if ( bytes_read == 0 )        // part shrank since it was opened
+            errno = EIO;
+          return -1;
+        }
+        p += bytes_read;
+        offset += bytes_read;
+        len -= STATIC_CAST( size_t, bytes_read );
+        part_len -= STATIC_CAST( size_t, bytes_read );
+      } // while
+    } // for
+  }
+
+done:
+  return p - STATIC_CAST( char*, buf );
+}
+
+off_t input_size( void ) {
+  if ( split.len > 0 )
+    return split.size;
+  struct stat fin_stat;
+  FSTAT( STDIN_FILENO, &fin_stat );
+  if ( S_ISREG( fin_stat.st_mode ) )
+    return fin_stat.st_size;
+  if ( !S_ISBLK( fin_stat.st_mode ) )
+    return -1;
+  // Block devices report a size of 0, so seek to the end and back.
+  off_t const pos = lseek( STDIN_FILENO, 0, SEEK_CUR );
+  off_t const size = lseek( STDIN_FILENO, 0, SEEK_END );
+  if ( pos != -1 )
+    PJL_DISCARD_RV( lseek( STDIN_FILENO, pos, SEEK_SET ) );
+  return size;
+}
+
+void input_split_open( char const *path ) {
+  assert( path != NULL );
+  assert( split.len == 0 );
+
+  size_t const path_len = strlen( path );
+  size_t digits = 0;
+  while ( digits < path_len && isdigit( path[ path_len - digits - 1 ] ) )
+    ++digits;
+  if ( digits == 0 ) {
+    fatal_error( EX_USAGE,
+      "\"%s\": first part of split input must end in a number\n", path
+    );
+  }
+  size_t const prefix_len = path_len - digits;
+  unsigned long long number = strtoull( path + prefix_len, NULL, 10 );
+
+  char *const part_path = free_later( MALLOC( char, path_len + 32 ) );
+  strcpy( part_path, path );
+  size_t cap = 0;
+
+  for (;;) {
+    int const fd = open( part_path, O_RDONLY );
+    if ( fd == -1 ) {
+      if ( errno == ENOENT && split.len > 0 )
+        break;                          // no more parts
+      if ( errno == EMFILE && input_raise_fd_limit() )
+        continue;
+      fatal_error( EX_NOINPUT, "\"%s\": %s\n", part_path, STRERROR() );
+    }
+    struct stat part_stat;
+    FSTAT( fd, &part_stat );
+    if ( !S_ISREG( part_stat.st_mode ) ) {
+      fatal_error( EX_USAGE,
+        "\"%s\": part of split input must be a regular file\n", part_path
+      );
+    }
+    if ( split.len == cap ) {
+      cap = cap == 0 ? 64 : cap * 2;
+      REALLOC( split.parts, cap );
+    }
+    split.parts[ split.len++ ] = (input_part_t){
+      .fd = fd,
+      .begin = split.size,
+      .size = part_stat.st_size
+    };
+    split.size += part_stat.st_size;
+    sprintf( part_path + prefix_len, "%0*llu",
+      STATIC_CAST( int, digits ), ++number
+    );
+  } // for
+
+#if defined(HAVE_FOPENCOOKIE)
+  FILE *const split_fin = fopencookie( &split, "r", (cookie_io_functions_t){
+    .read = &input_cookie_read,
+    .seek = &input_fopencookie_seek
+  } );
+#elif defined(HAVE_FUNOPEN)
+  FILE *const split_fin = funopen(
+    &split, &input_funopen_read, NULL, &input_funopen_seek, NULL
+  );
+#else
+  FILE *const split_fin = NULL;
+  errno = ENOSYS;
+#endif /* HAVE_FOPENCOOKIE */
+  if ( split_fin == NULL )
+    fatal_error( EX_OSERR, "\"%s\": can not open: %s\n", path, STRERROR() );
+  fin = split_fin;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/** @} */
+
+/* vim:set et sw=2 ts=2: */
@@ -0,0 +1,99 @@
+/*
+**      ad -- ASCII dump
+**      src/input.h
+**
+**      Copyright (C) 2024  Paul J. Lucas
+**
+**      This program is free software: you can redistribute it and/or modify
+**      it under the terms of the GNU General Public License as published by
+**      the Free Software Foundation, either version 3 of the License, or
+**      (at your option) any later version.
+**
+**      This program is distributed in the hope that it will be useful,
+**      but WITHOUT ANY WARRANTY; without even the implied warranty of
+**      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**      GNU General Public License for more details.
+**
+**      You should have received a copy of the GNU General Public License
+**      along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ad_input_H
+#define ad_input_H
+
+/**
+ * @file
+ * Declares functions for reading the input, possibly split into parts.
+ */
+
+// local
+#include "pjl_config.h"                 /* must go first */
+
+/// @cond DOXYGEN_IGNORE
+
+// standard
+#include <stdbool.h>
+#include <stddef.h>                     /* for size_t */
+#include <sys/types.h>                  /* for off_t, ssize_t */
+
+/// @endcond
+
+/**
+ * @defgroup input-group Input
+ * Functions for reading the input, possibly split into parts.
+ *
+ * @remarks The input, \ref fin, is normally \c stdin.  When split, its parts
+ * are files named like `image.001`, `image.002`, etc., that are read as if
+ * they were concatenated: \ref fin is set to a stream that reads (and
+ * seeks) across parts and input_pread() reads at any offset of the whole, so
+ * modes that read in parallel work as they do for a single file.
+ * @{
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Checks whether the input is a regular file or split into parts.
+ *
+ * @return Returns `true` only if it is.
+ */
+NODISCARD
+bool input_is_file( void );
+
+/**
+ * Reads from the input at \a offset like **pread**(2), across parts if split.
+ *
+ * @param buf The buffer to read into.
+ * @param len The maximum number of bytes to read.
+ * @param offset The offset within the input to read from.
+ * @return Returns the number of bytes read (0 only at end of input) or -1 on
+ * error.
+ */
+NODISCARD
+ssize_t input_pread( void *buf, size_t len, off_t offset );
+
+/**
+ * Gets the size of the input.
+ *
+ * @return Returns the size of a regular file, block device, or all parts if
+ * split; otherwise -1.
+ */
+NODISCARD
+off_t input_size( void );
+
+/**
+ * Opens the parts of a split input starting with \a path and sets \ref fin
+ * to a stream that reads them as one.
+ *
+ * @param path The path of the first part.  It must end in a number; the paths
+ * of the remaining parts are those having the same number of digits for each
+ * successive number until one doesn't exist.
+ */
+void input_split_open( char const *path );
+
+///////////////////////////////////////////////////////////////////////////////
+
+/** @} */
+
+#endif /* ad_input_H */
+/* vim:set et sw=2 ts=2: */
@@ -0,0 +1,226 @@
+/*
+**      ad -- ASCII dump
+**      src/line_index.c
+**
+**      Copyright (C) 2024  Paul J. Lucas
+**
+**      This program is free software: you can redistribute it and/or modify
+**      it under the terms of the GNU General Public License as published by
+**      the Free Software Foundation, either version 3 of the License, or
+**      (at your option) any later version.
+**
+**      This program is distributed in the hope that it will be useful,
+**      but WITHOUT ANY WARRANTY; without even the implied warranty of
+**      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**      GNU General Public License for more details.
+**
+**      You should have received a copy of the GNU General Public License
+**      along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * Defines functions for the line index of a dump.
+ */
+
+// local
+#include "pjl_config.h"                 /* must go first */
+#include "line_index.h"
+#include "ad.h"
+#include "options.h"
+#include "util.h"
+
+/// @cond DOXYGEN_IGNORE
+
+// standard
+#include <assert.h>
+#include <stdint.h>                     /* for uint*_t */
+#include <stdio.h>
+#include <string.h>                     /* for memcmp() */
+#include <sysexits.h>
+
+/// @endcond
+
+/**
+ * @addtogroup line-index-group
+ * @{
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+
+#define LINE_INDEX_BYTE_ORDER 0x01020304u /**< Detects other byte orders.   */
+#define LINE_INDEX_MAGIC      "ADLINES" /**< Line index file magic number.  */
+#define LINE_INDEX_VERSION    1u        /**< Line index file format version.*/
+
+/**
+ * The header of a line index file.  It's followed by \ref entries_len \ref
+ * line_index_entry structures where entry _i_ is for the row containing input
+ * offset \ref start + _i_ &times; \ref step.
+ */
+struct line_index_header {
+  char      magic[8];                   ///< #LINE_INDEX_MAGIC
+  uint32_t  version;                    ///< #LINE_INDEX_VERSION
+  uint32_t  byte_order;                 ///< #LINE_INDEX_BYTE_ORDER
+  uint32_t  row_bytes;                  ///< Bytes per row of the dump.
+  uint32_t  reserved;                   ///< Reserved; must be 0.
+  uint64_t  start;                      ///< Input offset of first entry.
+  uint64_t  step;                       ///< Input bytes between entries.
+  uint64_t  entries_len;                ///< Number of entries.
+};
+typedef struct line_index_header line_index_header_t;
+
+/**
+ * A line index entry: the row at or before an input offset.  If the row for
+ * the offset itself wasn't printed (because it was elided), it's the last row
+ * printed before it; if no row was printed before it, it's the first row
+ * printed after it.
+ */
+struct line_index_entry {
+  uint64_t  offset;                     ///< Input offset of the row.
+  uint64_t  pos;                        ///< Position of the row in the dump.
+};
+typedef struct line_index_entry line_index_entry_t;
+
+/**
+ * State of writing a line index.
+ */
+struct line_index_writer {
+  FILE               *file;             ///< Line index file.
+  line_index_header_t header;           ///< Header to write last.
+  off_t               next_offset;      ///< Input offset of next entry.
+  line_index_entry_t  last;             ///< Most recently printed row.
+  bool                any_rows;         ///< Any rows printed yet?
+};
+typedef struct line_index_writer line_index_writer_t;
+
+static line_index_writer_t  writer;     ///< The one line index writer.
+
+////////// local functions ////////////////////////////////////////////////////
+
+/**
+ * Writes to the line index file.
+ *
+ * @param buf The bytes to write.
+ * @param buf_len The number of bytes to write.
+ */
+static void line_index_write( void const *buf, size_t buf_len ) {
+  if ( unlikely( fwrite( buf, 1, buf_len, writer.file ) < buf_len ) ) {
+    fatal_error( EX_IOERR,
+      "\"%s\": can not write: %s\n", opt_line_index_path, STRERROR()
+    );
+  }
+}
+
+/**
+ * Writes entries for all remaining entry offsets before \a offset using the
+ * most recently printed row.
+ *
+ * @param offset The input offset to write entries before.
+ */
+static void line_index_fill( off_t offset ) {
+  for ( ; writer.next_offset < offset;
+        writer.next_offset += STATIC_CAST( off_t, writer.header.step ) ) {
+    line_index_write( &writer.last, sizeof writer.last );
+    ++writer.header.entries_len;
+  } // for
+}
+
+////////// extern functions ///////////////////////////////////////////////////
+
+void line_index_begin( void ) {
+  assert( opt_line_index_path != NULL );
+  writer.file = fopen( opt_line_index_path, "w" );
+  if ( unlikely( writer.file == NULL ) ) {
+    fatal_error( EX_CANTCREAT,
+      "\"%s\": %s\n", opt_line_index_path, STRERROR()
+    );
+  }
+  writer.header = (line_index_header_t){
+    .magic = LINE_INDEX_MAGIC,
+    .version = LINE_INDEX_VERSION,
+    .byte_order = LINE_INDEX_BYTE_ORDER,
+    .row_bytes = row_bytes,
+    .start = STATIC_CAST( uint64_t, fin_offset ),
+    .step = STATIC_CAST( uint64_t, LINE_INDEX_ROWS ) * row_bytes
+  };
+  writer.next_offset = fin_offset;
+  line_index_write( &writer.header, sizeof writer.header );
+}
+
+void line_index_end( off_t end_offset ) {
+  if ( writer.file == NULL )
+    return;
+  if ( writer.any_rows )
+    line_index_fill( end_offset );
+  FSEEK( writer.file, 0, SEEK_SET );
+  line_index_write( &writer.header, sizeof writer.header );
+  if ( unlikely( fclose( writer.file ) != 0 ) ) {
+    fatal_error( EX_IOERR,
+      "\"%s\": can not write: %s\n", opt_line_index_path, STRERROR()
+    );
+  }
+  writer.file = NULL;
+}
+
+void line_index_row( off_t offset ) {
+  if ( writer.file == NULL )
+    return;
+  off_t const pos = FTELL_FN( fout );
+  PERROR_EXIT_IF( pos == -1, EX_IOERR );
+
+  line_index_entry_t const curr = {
+    .offset = STATIC_CAST( uint64_t, offset ),
+    .pos = STATIC_CAST( uint64_t, pos )
+  };
+  if ( !writer.any_rows ) {
+    writer.last = curr;
+    writer.any_rows = true;
+  }
+  line_index_fill( offset );
+  writer.last = curr;
+  if ( writer.next_offset == offset )
+    line_index_fill( offset + 1 );
+}
+
+off_t line_index_seek( off_t offset ) {
+  assert( opt_line_index_path != NULL );
+  FILE *const file = fopen( opt_line_index_path, "r" );
+  if ( unlikely( file == NULL ) )
+    fatal_error( EX_NOINPUT, "\"%s\": %s\n", opt_line_index_path, STRERROR() );
+
+  line_index_header_t header;
+  if ( fread( &header, sizeof header, 1, file ) != 1 ||
+       memcmp( header.magic, LINE_INDEX_MAGIC, sizeof LINE_INDEX_MAGIC ) != 0 ||
+       header.version != LINE_INDEX_VERSION ||
+       header.byte_order != LINE_INDEX_BYTE_ORDER ||
+       header.step == 0 ) {
+    fatal_error( EX_DATAERR,
+      "\"%s\": not a line index file\n", opt_line_index_path
+    );
+  }
+
+  line_index_entry_t entry = { 0, 0 };
+  if ( header.entries_len > 0 ) {
+    uint64_t i = STATIC_CAST( uint64_t, offset ) < header.start ? 0 :
+      (STATIC_CAST( uint64_t, offset ) - header.start) / header.step;
+    if ( i >= header.entries_len )
+      i = header.entries_len - 1;
+    FSEEK( file,
+      STATIC_CAST( off_t, sizeof header + i * sizeof entry ), SEEK_SET
+    );
+    if ( unlikely( fread( &entry, sizeof entry, 1, file ) != 1 ) ) {
+      fatal_error( EX_DATAERR,
+        "\"%s\": line index file truncated\n", opt_line_index_path
+      );
+    }
+    FSEEK( fin, STATIC_CAST( off_t, entry.pos ), SEEK_SET );
+  }
+  fclose( file );
+  return STATIC_CAST( off_t, entry.offset );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/** @} */
+
+/* vim:set et sw=2 ts=2: */
@@ -0,0 +1,98 @@
+/*
+**      ad -- ASCII dump
+**      src/line_index.h
+**
+**      Copyright (C) 2024  Paul J. Lucas
+**
+**      This program is free software: you can redistribute it and/or modify
+**      it under the terms of the GNU General Public License as published by
+**      the Free Software Foundation, either version 3 of the License, or
+**      (at your option) any later version.
+**
+**      This program is distributed in the hope that it will be useful,
+**      but WITHOUT ANY WARRANTY; without even the implied warranty of
+**      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**      GNU General Public License for more details.
+**
+**      You should have received a copy of the GNU General Public License
+**      along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ad_line_index_H
+#define ad_line_index_H
+
+/**
+ * @file
+ * Declares functions for the line index of a dump.
+ */
+
+// local
+#include "pjl_config.h"                 /* must go first */
+
+/// @cond DOXYGEN_IGNORE
+
+// standard
+#include <sys/types.h>                  /* for off_t */
+
+/// @endcond
+
+/**
+ * @defgroup line-index-group Line Index
+ * Functions for the line index of a dump.
+ *
+ * @remarks A line index is a sidecar file of a dump that maps input offsets to
+ * positions of rows within the dump every #LINE_INDEX_ROWS rows.  Because
+ * entries are at regular input offsets, the entry for any offset is found by
+ * division, so the row for any offset can be found by seeking to its entry's
+ * position and reading at most #LINE_INDEX_ROWS rows.
+ * @{
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+
+#define LINE_INDEX_ROWS     256u        /**< Rows per line index entry.     */
+
+/**
+ * Starts writing the line index \ref opt_line_index_path for a dump starting
+ * at \ref fin_offset.
+ *
+ * @sa line_index_end()
+ * @sa line_index_row()
+ */
+void line_index_begin( void );
+
+/**
+ * Finishes writing the line index.
+ *
+ * @param end_offset The offset of one past the last byte dumped.
+ *
+ * @sa line_index_begin()
+ */
+void line_index_end( off_t end_offset );
+
+/**
+ * Notes that the row for \a offset is about to be printed to standard output.
+ * Rows must be noted in ascending order.
+ *
+ * @param offset The offset of the row.
+ *
+ * @sa line_index_begin()
+ */
+void line_index_row( off_t offset );
+
+/**
+ * Using the line index \ref opt_line_index_path, positions standard input
+ * (a dump) at or before the row for \a offset.
+ *
+ * @param offset The offset to seek to.
+ * @return Returns the offset of the row standard input is now positioned at.
+ */
+NODISCARD
+off_t line_index_seek( off_t offset );
+
+///////////////////////////////////////////////////////////////////////////////
+
+/** @} */
+
+#endif /* ad_line_index_H */
+/* vim:set et sw=2 ts=2: */
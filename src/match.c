@@ -26,6 +26,7 @@
 // local
 #include "pjl_config.h"                 /* must go first */
 #include "ad.h"
+#include "input.h"
 #include "match.h"
 #include "options.h"
 #include "util.h"
@@ -35,8 +36,10 @@
 // standard
 #include <assert.h>
 #include <ctype.h>                      /* for tolower() */
+#include <math.h>                       /* for INFINITY, nextafterf() */
 #include <stdint.h>                     /* for SIZE_MAX */
 #include <stdlib.h>                     /* for exit() */
+#include <string.h>                     /* for memchr(), memmove() */
 #include <sysexits.h>
 
 /// @endcond
@@ -56,7 +59,13 @@ unsigned long       total_matches;
 
 /// @endcond
 
+/**
+ * Size of the blocks read backwards by match_last().
+ */
+#define LAST_BLOCK_SIZE           (64 * 1024u)
+
 // local variable definitions
+static size_t       last_pos;           ///< Position of match_last() match.
 static size_t       total_bytes_read;   ///< Total bytes read.
 
 // local functions
@@ -77,9 +86,9 @@ static bool get_byte( char8_t *pbyte ) {
   if ( unlikely( total_bytes_read == opt_max_bytes ) )
     return false;
 
-  int const c = getchar();
+  int const c = getc( fin );
   if ( unlikely( c == EOF ) ) {
-    if ( unlikely( ferror( stdin ) ) ) {
+    if ( unlikely( ferror( fin ) ) ) {
       fatal_error( EX_IOERR,
         "\"%s\": read byte failed: %s\n", fin_path, STRERROR()
       );
@@ -113,22 +122,8 @@ static bool get_byte( char8_t *pbyte ) {
 NODISCARD
 static bool is_match( char8_t input_byte, size_t buf_pos,
                       bool must_be_utf8_cont ) {
-  if ( opt_strings ) {
-    switch ( input_byte ) {
-      case '\f': return (opt_strings_opts & STRINGS_FORMFEED) != 0;
-      case '\n': return (opt_strings_opts & STRINGS_LINEFEED) != 0;
-      case '\r': return (opt_strings_opts & STRINGS_RETURN  ) != 0;
-      case ' ' : return (opt_strings_opts & STRINGS_SPACE   ) != 0;
-      case '\t': return (opt_strings_opts & STRINGS_TAB     ) != 0;
-      case '\v': return (opt_strings_opts & STRINGS_VTAB    ) != 0;
-      default  :
-        if ( opt_utf8 ) {
-          return must_be_utf8_cont ?
-            utf8_is_cont( input_byte ) : utf8_is_start( input_byte );
-        }
-        return ascii_is_graph( input_byte );
-    } // switch
-  }
+  if ( opt_strings )
+    return match_strings_byte( input_byte, must_be_utf8_cont );
 
   if ( opt_ignore_case )
     input_byte = STATIC_CAST( char8_t, tolower( input_byte ) );
@@ -335,8 +330,16 @@ static bool match_byte( char8_t *pbyte, bool *matches, size_t const *kmps,
           // to re-read them and re-compare them since they will match; hence,
           // go to S_MATCHING_CONTINUE.
           //
+          // The kmp bytes to keep are the last ones read, not the first ones
+          // in the buffer: they compare equal to the search buffer, but may
+          // differ in case when ignoring case.  Either way, reset kmp so a
+          // later full match doesn't continue from a stale partial match.
+          //
+          if ( kmp > 0 )
+            memmove( *pmatch_buf, *pmatch_buf + buf_drain, kmp );
           buf_pos = kmp;
-          GOTO_STATE( kmp > 0 ? S_MATCHING_CONTINUE : S_READING );
+          kmp = 0;
+          GOTO_STATE( buf_pos > 0 ? S_MATCHING_CONTINUE : S_READING );
         }
         *matches = state == S_MATCHED && buf_pos <= buf_matched;
         *pbyte = (*pmatch_buf)[ buf_pos++ ];
@@ -351,13 +354,363 @@ static bool match_byte( char8_t *pbyte, bool *matches, size_t const *kmps,
   } // for
 }
 
+/**
+ * Advances a Knuth-Morris-Pratt (KMP) matcher over \a byte.
+ *
+ * @param pattern The search pattern.
+ * @param pattern_len The length of \a pattern.
+ * @param kmps The partial-match table for \a pattern from kmp_new().
+ * @param pkmp A pointer to the number of bytes of \a pattern matched so far.
+ * @param byte The next input byte.
+ * @return Returns `true` only if \a byte completes a match of \a pattern.
+ */
+NODISCARD
+static bool kmp_step( char const *pattern, size_t pattern_len,
+                      size_t const *kmps, size_t *pkmp, char8_t byte ) {
+  assert( pattern != NULL );
+  assert( kmps != NULL );
+  assert( pkmp != NULL );
+
+  if ( opt_ignore_case )
+    byte = STATIC_CAST( char8_t, tolower( byte ) );
+  size_t kmp = *pkmp;
+  while ( kmp > 0 && STATIC_CAST( char8_t, pattern[ kmp ] ) != byte )
+    kmp = kmps[ kmp ];
+  if ( STATIC_CAST( char8_t, pattern[ kmp ] ) == byte )
+    ++kmp;
+  bool const matched = kmp == pattern_len;
+  if ( matched )
+    kmp = kmps[ kmp ];
+  *pkmp = kmp;
+  return matched;
+}
+
+/**
+ * Gets a byte and whether it's part of a proximity match, that is \ref
+ * opt_search_buf followed by \ref opt_followed_buf starting within \ref
+ * opt_within bytes after it.
+ *
+ * @remarks Both strings are matched in a single pass.  Bytes are read ahead
+ * into a sliding window that's kept only as long as either a pending match of
+ * the first string could still be followed by the second or the most recent
+ * bytes could still be the start of the second.  Hence the window is never
+ * larger than the lengths of both strings plus \ref opt_within.
+ *
+ * @param pbyte A pointer to receive the byte.
+ * @param matches A pointer to receive whether the byte matches.
+ * @return Returns `true` only if a byte was read successfully.
+ */
+NODISCARD
+static bool match_byte_near( char8_t *pbyte, bool *matches ) {
+  /**
+   * A match of \ref opt_search_buf not yet followed by \ref opt_followed_buf
+   * within \ref opt_within bytes (or already followed, but that could still be
+   * followed again).
+   */
+  struct near_hit {
+    size_t  pos;                        ///< Position of the match.
+    bool    counted;                    ///< Counted in \ref total_matches?
+  };
+  typedef struct near_hit near_hit_t;
+
+  static size_t       a_kmp, b_kmp;     // bytes partially matched
+  static size_t      *a_kmps, *b_kmps;  // KMP tables
+  static size_t       cap;              // capacity of all circular buffers
+  static size_t       emit_pos;         // position of next byte to return
+  static bool         eof;              // reached EOF?
+  static near_hit_t  *hits;             // circular buffer of pending hits
+  static size_t       hits_head, hits_len;
+  static bool        *match_flags;      // circular buffer of matches
+  static size_t       read_pos;         // position of next byte to read
+  static char8_t     *window;           // circular buffer of bytes
+
+  assert( pbyte != NULL );
+  assert( matches != NULL );
+
+  size_t const a_len = opt_search_len;
+  size_t const b_len = opt_followed_len;
+
+  if ( unlikely( window == NULL ) ) {
+    a_kmps = free_later( kmp_new( opt_search_buf, a_len ) );
+    b_kmps = free_later( kmp_new( opt_followed_buf, b_len ) );
+    cap = a_len + opt_within + b_len + 1;
+    hits = free_later( MALLOC( near_hit_t, cap ) );
+    match_flags = free_later( MALLOC( bool, cap ) );
+    window = free_later( MALLOC( char8_t, cap ) );
+  }
+
+  for (;;) {
+    //
+    // Return the oldest byte in the window if it can no longer become part of
+    // a match, i.e., it's before both the oldest pending hit and the last
+    // bytes that could still be the start of either string.
+    //
+    size_t hold_pos = read_pos;
+    if ( !eof ) {
+      size_t const hold_len = (a_len > b_len ? a_len : b_len) - 1;
+      hold_pos = hold_pos >= hold_len ? hold_pos - hold_len : 0;
+      if ( hits_len > 0 && hits[ hits_head ].pos < hold_pos )
+        hold_pos = hits[ hits_head ].pos;
+    }
+    if ( emit_pos < hold_pos ) {
+      *pbyte = window[ emit_pos % cap ];
+      *matches = match_flags[ emit_pos % cap ];
+      ++emit_pos;
+      return true;
+    }
+    if ( eof )
+      return false;
+
+    char8_t byte;
+    if ( unlikely( !get_byte( &byte ) ) ) {
+      eof = true;
+      hits_len = 0;
+      continue;
+    }
+
+    size_t const pos = read_pos++;
+    window[ pos % cap ] = byte;
+    match_flags[ pos % cap ] = false;
+
+    // Forget hits that can no longer be followed within opt_within bytes.
+    while ( hits_len > 0 &&
+            pos >= hits[ hits_head ].pos + a_len + opt_within + b_len ) {
+      hits_head = (hits_head + 1) % cap;
+      --hits_len;
+    } // while
+
+    if ( kmp_step( opt_followed_buf, b_len, b_kmps, &b_kmp, byte ) ) {
+      size_t const b_pos = pos + 1 - b_len;
+      bool any_followed = false;
+      for ( size_t i = 0; i < hits_len; ++i ) {
+        near_hit_t *const hit = &hits[ (hits_head + i) % cap ];
+        size_t const a_end = hit->pos + a_len;
+        if ( b_pos < a_end || b_pos - a_end > opt_within )
+          continue;
+        for ( size_t j = hit->pos; j < a_end; ++j )
+          match_flags[ j % cap ] = true;
+        if ( !hit->counted ) {
+          hit->counted = true;
+          ++total_matches;
+        }
+        any_followed = true;
+      } // for
+      if ( any_followed ) {
+        for ( size_t j = b_pos; j <= pos; ++j )
+          match_flags[ j % cap ] = true;
+      }
+    }
+
+    if ( kmp_step( opt_search_buf, a_len, a_kmps, &a_kmp, byte ) ) {
+      assert( hits_len < cap );
+      hits[ (hits_head + hits_len++) % cap ] =
+        (near_hit_t){ .pos = pos + 1 - a_len, .counted = false };
+    }
+  } // for
+}
+
+/**
+ * Maps the bits of an IEEE 754 floating-point number to an integer key such
+ * that keys compare the same as the numbers they're for, adjacent numbers have
+ * adjacent keys, and both zeros have the same key.
+ *
+ * @param bits The bits of the number.
+ * @param size The size of the number in bytes: either 4 or 8.
+ * @return Returns said key.
+ */
+NODISCARD
+static int64_t float_key( uint64_t bits, size_t size ) {
+  uint64_t const sign = 1ull << (size * 8 - 1);
+  int64_t const magnitude = STATIC_CAST( int64_t, bits & ~sign );
+  return (bits & sign) != 0 ? -magnitude : magnitude;
+}
+
+/**
+ * Gets the range of keys, as returned by float_key(), of the numbers of size
+ * \ref opt_search_len that match \ref opt_float_value within \ref
+ * opt_float_tolerance.
+ *
+ * @remarks Since the numbers within any tolerance form a contiguous range of
+ * keys, checking whether a number matches is then only two integer
+ * comparisons.  NaNs never match since their keys are outside the range of
+ * those of the infinities.
+ *
+ * @param pmin A pointer to receive the minimum key.
+ * @param pmax A pointer to receive the maximum key.
+ */
+static void float_key_range( int64_t *pmin, int64_t *pmax ) {
+  assert( pmin != NULL );
+  assert( pmax != NULL );
+
+  size_t const size = opt_search_len;
+  uint64_t inf_bits, min_bits, max_bits, value_bits;
+
+  if ( size == sizeof( float ) ) {
+    float const inf = INFINITY;
+    float const value = STATIC_CAST( float, opt_float_value );
+    // Center the range on the float nearest the value so it always matches.
+    double const min_value = STATIC_CAST( double, value ) - opt_float_tolerance;
+    double const max_value = STATIC_CAST( double, value ) + opt_float_tolerance;
+    float min = STATIC_CAST( float, min_value );
+    float max = STATIC_CAST( float, max_value );
+    // The conversions round to nearest, so they may be just out of range.
+    if ( min < min_value )
+      min = nextafterf( min, inf );
+    if ( max > max_value )
+      max = nextafterf( max, -inf );
+    uint32_t bits[4];
+    memcpy( &bits[0], &inf, sizeof bits[0] );
+    memcpy( &bits[1], &min, sizeof bits[1] );
+    memcpy( &bits[2], &max, sizeof bits[2] );
+    memcpy( &bits[3], &value, sizeof bits[3] );
+    inf_bits = bits[0];
+    min_bits = bits[1];
+    max_bits = bits[2];
+    value_bits = bits[3];
+  }
+  else {
+    double const inf = INFINITY;
+    double const min = opt_float_value - opt_float_tolerance;
+    double const max = opt_float_value + opt_float_tolerance;
+    memcpy( &inf_bits, &inf, sizeof inf_bits );
+    memcpy( &min_bits, &min, sizeof min_bits );
+    memcpy( &max_bits, &max, sizeof max_bits );
+    memcpy( &value_bits, &opt_float_value, sizeof value_bits );
+  }
+
+  int64_t const inf_key = float_key( inf_bits, size );
+  if ( !opt_float_ulps ) {
+    *pmin = float_key( min_bits, size );
+    *pmax = float_key( max_bits, size );
+    return;
+  }
+
+  //
+  // Clamp the range to the infinities using unsigned arithmetic since the
+  // distance between keys may not fit in an int64_t.
+  //
+  uint64_t const ulps = opt_float_tolerance >= 0x1p63 ?
+    UINT64_MAX : STATIC_CAST( uint64_t, opt_float_tolerance );
+  int64_t const key = float_key( value_bits, size );
+  uint64_t const below = STATIC_CAST( uint64_t, key ) +
+                         STATIC_CAST( uint64_t, inf_key );
+  uint64_t const above = STATIC_CAST( uint64_t, inf_key ) -
+                         STATIC_CAST( uint64_t, key );
+  *pmin = ulps >= below ? -inf_key : key - STATIC_CAST( int64_t, ulps );
+  *pmax = ulps >= above ?  inf_key : key + STATIC_CAST( int64_t, ulps );
+}
+
+/**
+ * Gets a byte and whether it's part of a floating-point match, that is a
+ * number of size \ref opt_search_len (in \ref opt_search_endian order) that
+ * matches \ref opt_float_value within \ref opt_float_tolerance.
+ *
+ * @remarks The bytes of the most recent \ref opt_search_len bytes read are
+ * kept as an integer that's shifted a byte at a time, so a number is decoded
+ * and compared at every position with only a few integer operations.  Bytes
+ * are read ahead so a byte is returned only once every number it could be
+ * part of has been checked.
+ *
+ * @param pbyte A pointer to receive the byte.
+ * @param matches A pointer to receive whether the byte matches.
+ * @return Returns `true` only if a byte was read successfully.
+ */
+NODISCARD
+static bool match_byte_float( char8_t *pbyte, bool *matches ) {
+  static off_t    begin_offset;         // offset of first byte read
+  static size_t   emit_pos;             // position of next byte to return
+  static bool     eof;                  // reached EOF?
+  static bool     initialized;
+  static int64_t  key_min, key_max;     // range of matching keys
+  static bool     match_flags[8];       // circular buffer of matches
+  static uint64_t number;               // most recent bytes read
+  static size_t   read_pos;             // position of next byte to read
+  static char8_t  window[8];            // circular buffer of bytes
+
+  assert( pbyte != NULL );
+  assert( matches != NULL );
+
+  size_t const size = opt_search_len;
+  assert( size == sizeof( float ) || size == sizeof( double ) );
+
+  if ( unlikely( !initialized ) ) {
+    float_key_range( &key_min, &key_max );
+    begin_offset = fin_offset;
+    initialized = true;
+  }
+
+  for (;;) {
+    if ( emit_pos < read_pos && (eof || read_pos - emit_pos == size) ) {
+      *pbyte = window[ emit_pos % size ];
+      *matches = match_flags[ emit_pos % size ];
+      ++emit_pos;
+      return true;
+    }
+    if ( eof )
+      return false;
+
+    char8_t byte;
+    if ( unlikely( !get_byte( &byte ) ) ) {
+      eof = true;
+      continue;
+    }
+
+    size_t const pos = read_pos++;
+    window[ pos % size ] = byte;
+    match_flags[ pos % size ] = false;
+
+    if ( opt_search_endian == ENDIAN_BIG ) {
+      number = (number << 8) | byte;
+      if ( size < sizeof number )
+        number &= (1ull << (size * 8)) - 1;
+    } else {
+      number = (number >> 8) |
+               (STATIC_CAST( uint64_t, byte ) << ((size - 1) * 8));
+    }
+
+    if ( read_pos < size )
+      continue;
+    if ( opt_float_aligned &&
+         (begin_offset + STATIC_CAST( off_t, read_pos - size )) %
+          STATIC_CAST( off_t, size ) != 0 ) {
+      continue;
+    }
+    int64_t const key = float_key( number, size );
+    if ( key >= key_min && key <= key_max ) {
+      // The match is exactly the bytes in the window.
+      for ( size_t i = 0; i < size; ++i )
+        match_flags[i] = true;
+      ++total_matches;
+    }
+  } // for
+}
+
+/**
+ * Gets a byte and whether it's part of the match found by match_last().
+ *
+ * @param pbyte A pointer to receive the byte.
+ * @param matches A pointer to receive whether the byte matches.
+ * @return Returns `true` only if a byte was read successfully.
+ */
+NODISCARD
+static bool match_byte_last( char8_t *pbyte, bool *matches ) {
+  assert( pbyte != NULL );
+  assert( matches != NULL );
+
+  size_t const pos = total_bytes_read;
+  if ( unlikely( !get_byte( pbyte ) ) )
+    return false;
+  *matches = pos >= last_pos && pos - last_pos < opt_search_len;
+  return true;
+}
+
 /**
  * Ungets the given byte.
  *
  * @param byte The byte to unget.
  */
 static void unget_byte( char8_t byte ) {
-  if ( unlikely( ungetc( byte, stdin ) == EOF ) ) {
+  if ( unlikely( ungetc( byte, fin ) == EOF ) ) {
     fatal_error( EX_IOERR,
       "\"%s\": unget byte failed: %s\n", fin_path, STRERROR()
     );
@@ -379,13 +732,121 @@ size_t* kmp_new( char const *pattern, size_t pattern_len ) {
     if ( pattern[i] == pattern[j] )
       kmps[++i] = ++j;
     else if ( j > 0 )
-      j = kmps[j-1];
+      j = kmps[j];
     else
       kmps[++i] = 0;
   } // for
   return kmps;
 }
 
+bool match_block( char8_t const *buf, size_t buf_len, size_t const *kmps,
+                  size_t *pkmp ) {
+  assert( buf != NULL || buf_len == 0 );
+  assert( opt_search_len > 0 );
+  return match_next( buf, buf + buf_len, kmps, pkmp ) != NULL;
+}
+
+size_t match_block_count( char8_t const *buf, size_t buf_len,
+                          size_t const *kmps, bool *flags ) {
+  assert( buf != NULL || buf_len == 0 );
+  assert( opt_search_len > 0 );
+
+  char8_t const *const end = buf + buf_len;
+  size_t kmp = 0;
+  size_t matches = 0;
+  for ( char8_t const *p = buf;
+        (p = match_next( p, end, kmps, &kmp )) != NULL; ++matches ) {
+    if ( flags != NULL ) {
+      size_t const match_end = STATIC_CAST( size_t, p - buf );
+      for ( size_t i = match_end - opt_search_len; i < match_end; ++i )
+        flags[i] = true;
+    }
+  } // for
+  return matches;
+}
+
+bool match_last( void ) {
+  assert( opt_search_len > 0 );
+
+  off_t const begin = FTELL_FN( fin );
+  off_t end = input_size();
+  if ( end - begin > 0 &&
+       STATIC_CAST( uint64_t, end - begin ) > opt_max_bytes ) {
+    end = begin + STATIC_CAST( off_t, opt_max_bytes );
+  }
+
+  //
+  // Match the reversed search buffer against the bytes read in reverse from
+  // the end: the first match is then the last match in the file.  Since KMP
+  // never has to back up, its state simply carries across blocks.
+  //
+  char *const rpattern = MALLOC( char, opt_search_len );
+  for ( size_t i = 0; i < opt_search_len; ++i )
+    rpattern[i] = opt_search_buf[ opt_search_len - 1 - i ];
+  size_t *const rkmps = kmp_new( rpattern, opt_search_len );
+  char8_t *const block = MALLOC( char8_t, LAST_BLOCK_SIZE );
+
+  off_t found = -1;
+  size_t kmp = 0;
+  for ( off_t block_end = end; found == -1 && block_end > begin; ) {
+    size_t block_len = LAST_BLOCK_SIZE;
+    if ( STATIC_CAST( off_t, block_len ) > block_end - begin )
+      block_len = STATIC_CAST( size_t, block_end - begin );
+    off_t const block_begin = block_end - STATIC_CAST( off_t, block_len );
+
+    ssize_t const bytes_read = input_pread( block, block_len, block_begin );
+    if ( unlikely( bytes_read != STATIC_CAST( ssize_t, block_len ) ) ) {
+      fatal_error( EX_IOERR,
+        "\"%s\": read failed: %s\n", fin_path, STRERROR()
+      );
+    }
+
+    for ( size_t i = block_len; i-- > 0; ) {
+      if ( kmp_step( rpattern, opt_search_len, rkmps, &kmp, block[i] ) ) {
+        found = block_begin + STATIC_CAST( off_t, i );
+        break;
+      }
+    } // for
+    block_end = block_begin;
+  } // for
+
+  free( block );
+  free( rkmps );
+  free( rpattern );
+
+  if ( found == -1 )
+    return false;
+
+  ++total_matches;
+  last_pos = STATIC_CAST( size_t, found - begin );
+
+  // Reposition to the start of the row containing the match.
+  size_t const skip = last_pos - last_pos % row_bytes;
+  FSEEK( fin, begin + STATIC_CAST( off_t, skip ), SEEK_SET );
+  total_bytes_read = skip;
+  fin_offset += STATIC_CAST( off_t, skip );
+  return true;
+}
+
+char8_t const* match_next( char8_t const *p, char8_t const *end,
+                           size_t const *kmps, size_t *pkmp ) {
+  assert( p != NULL );
+  assert( p <= end );
+  assert( opt_search_len > 0 );
+
+  while ( p < end ) {
+    if ( *pkmp == 0 && !opt_ignore_case ) {
+      // No partial match is pending, so skip ahead to the first byte.
+      p = memchr( p, opt_search_buf[0], STATIC_CAST( size_t, end - p ) );
+      if ( p == NULL )
+        return NULL;
+    }
+    if ( kmp_step( opt_search_buf, opt_search_len, kmps, pkmp, *p++ ) )
+      return p;
+  } // while
+  return NULL;
+}
+
 size_t match_row( char8_t *row_buf, size_t row_len, match_bits_t *match_bits,
                   size_t const *kmps, char8_t **pmatch_buf,
                   size_t *pmatch_len ) {
@@ -397,16 +858,45 @@ size_t match_row( char8_t *row_buf, size_t row_len, match_bits_t *match_bits,
   size_t buf_len;
   for ( buf_len = 0; buf_len < row_len; ++buf_len ) {
     bool matches;
-    if ( !match_byte( row_buf + buf_len, &matches, kmps,
-                      pmatch_buf, pmatch_len ) ) {
+    if ( opt_float ) {
+      if ( !match_byte_float( row_buf + buf_len, &matches ) )
+        break;
+    }
+    else if ( opt_followed_buf != NULL ) {
+      if ( !match_byte_near( row_buf + buf_len, &matches ) )
+        break;
+    }
+    else if ( opt_last ) {
+      if ( !match_byte_last( row_buf + buf_len, &matches ) )
+        break;
+    }
+    else if ( !match_byte( row_buf + buf_len, &matches, kmps,
+                           pmatch_buf, pmatch_len ) ) {
       break;
     }
     if ( matches )
-      *match_bits |= 1u << buf_len;
+      *match_bits |= STATIC_CAST( match_bits_t, 1 ) << buf_len;
   } // for
   return buf_len;
 }
 
+bool match_strings_byte( char8_t byte, bool must_be_utf8_cont ) {
+  if ( opt_utf8 && must_be_utf8_cont )
+    return utf8_is_cont( byte );
+  switch ( byte ) {
+    case '\f': return (opt_strings_opts & STRINGS_FORMFEED) != 0;
+    case '\n': return (opt_strings_opts & STRINGS_LINEFEED) != 0;
+    case '\r': return (opt_strings_opts & STRINGS_RETURN  ) != 0;
+    case ' ' : return (opt_strings_opts & STRINGS_SPACE   ) != 0;
+    case '\t': return (opt_strings_opts & STRINGS_TAB     ) != 0;
+    case '\v': return (opt_strings_opts & STRINGS_VTAB    ) != 0;
+    default  :
+      if ( opt_utf8 && byte >= 0x80 )
+        return utf8_is_start( byte );
+      return ascii_is_graph( byte );
+  } // switch
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 /** @} */
@@ -46,7 +46,7 @@
 
 ///////////////////////////////////////////////////////////////////////////////
 
-typedef uint32_t  match_bits_t;         ///< Bit _i_ means byte _i_ matches.
+typedef uint64_t  match_bits_t;         ///< Bit _i_ means byte _i_ matches.
 
 // extern variables
 extern unsigned long total_matches;     ///< Total number of matches.
@@ -69,6 +69,72 @@ extern unsigned long total_matches;     ///< Total number of matches.
 NODISCARD
 size_t* kmp_new( char const *pattern, size_t pattern_len );
 
+/**
+ * Checks whether a block of bytes contains a match of \ref opt_search_buf.
+ *
+ * @remarks This function is thread-safe, so it can be used to search many
+ * files in parallel.
+ *
+ * @param buf The bytes to search.
+ * @param buf_len The number of bytes in \a buf.
+ * @param kmps The KMP table for \ref opt_search_buf as returned by kmp_new().
+ * @param pkmp A pointer to the KMP state; it must be 0 initially and is
+ * updated so that matches spanning consecutive blocks are found.
+ * @return Returns `true` only if a match ends within \a buf.
+ */
+NODISCARD
+bool match_block( char8_t const *buf, size_t buf_len, size_t const *kmps,
+                  size_t *pkmp );
+
+/**
+ * Counts the matches of \ref opt_search_buf wholly within a block of bytes.
+ *
+ * @remarks This function is thread-safe.
+ *
+ * @param buf The bytes to search.
+ * @param buf_len The number of bytes in \a buf.
+ * @param kmps The KMP table for \ref opt_search_buf as returned by kmp_new().
+ * @param flags If not NULL, an array of \a buf_len flags where those of bytes
+ * that are part of a match are set to `true`.
+ * @return Returns the number of matches.
+ */
+NODISCARD
+size_t match_block_count( char8_t const *buf, size_t buf_len,
+                          size_t const *kmps, bool *flags );
+
+/**
+ * Searches backwards from the end of the input for the last match of \ref
+ * opt_search_buf.
+ *
+ * @remarks The input must be a regular file.  Blocks are read backwards from
+ * the end (or from the current position plus \ref opt_max_bytes, if less) and
+ * matched against the reversed search buffer, so the search stops at the first
+ * match from the end.  If found, the input is repositioned to the start of the
+ * row containing the match, \ref fin_offset is adjusted accordingly, and
+ * match_row() subsequently highlights only that match.
+ *
+ * @return Returns `true` only if a match was found.
+ */
+NODISCARD
+bool match_last( void );
+
+/**
+ * Finds the next match of \ref opt_search_buf.
+ *
+ * @remarks This function is thread-safe.
+ *
+ * @param p A pointer to the first byte to search.
+ * @param end A pointer to one past the last byte to search.
+ * @param kmps The KMP table for \ref opt_search_buf as returned by kmp_new().
+ * @param pkmp A pointer to the KMP state; it must be 0 initially and is
+ * updated so that matches spanning consecutive calls are found.
+ * @return Returns a pointer to one past the last byte of the match or NULL if
+ * none.
+ */
+NODISCARD
+char8_t const* match_next( char8_t const *p, char8_t const *end,
+                           size_t const *kmps, size_t *pkmp );
+
 /**
  * Gets a row of bytes and whether each byte matches bytes in the search
  * buffer.
@@ -91,6 +157,19 @@ size_t match_row( char8_t *row_buf, size_t row_len,
                   match_bits_t *match_bits, size_t const *kmps,
                   char8_t **pmatch_buf, size_t *pmatch_len );
 
+/**
+ * Checks whether \a byte can be part of a string for **strings**(1)-like
+ * searches according to \ref opt_strings_opts and \ref opt_utf8.
+ *
+ * @param byte The byte to check.
+ * @param must_be_utf8_cont If `true` (and \ref opt_utf8 is `true`), \a byte
+ * _must_ be a UTF-8 continuation byte; if `false`, it must be an allowed
+ * whitespace, graphic ASCII, or UTF-8 start byte.
+ * @return Returns `true` only if \a byte can be part of a string.
+ */
+NODISCARD
+bool match_strings_byte( char8_t byte, bool must_be_utf8_cont );
+
 ///////////////////////////////////////////////////////////////////////////////
 
 /** @} */
@@ -0,0 +1,575 @@
+/*
+**      ad -- ASCII dump
+**      src/narrow.c
+**
+**      Copyright (C) 2024  Paul J. Lucas
+**
+**      This program is free software: you can redistribute it and/or modify
+**      it under the terms of the GNU General Public License as published by
+**      the Free Software Foundation, either version 3 of the License, or
+**      (at your option) any later version.
+**
+**      This program is distributed in the hope that it will be useful,
+**      but WITHOUT ANY WARRANTY; without even the implied warranty of
+**      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**      GNU General Public License for more details.
+**
+**      You should have received a copy of the GNU General Public License
+**      along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * Defines functions for narrowing the offsets of a changing number.
+ */
+
+// local
+#include "pjl_config.h"                 /* must go first */
+#include "ad.h"
+#include "color.h"
+#include "input.h"
+#include "match.h"
+#include "options.h"
+#include "parallel.h"
+#include "util.h"
+
+/// @cond DOXYGEN_IGNORE
+
+// standard
+#include <assert.h>
+#include <errno.h>
+#include <inttypes.h>                   /* for PRIX64 */
+#include <stdint.h>                     /* for uint*_t */
+#include <stdio.h>
+#include <stdlib.h>                     /* for exit() */
+#include <string.h>                     /* for memchr(), memcmp() */
+#include <sysexits.h>
+#include <unistd.h>                     /* for sysconf() */
+
+/// @endcond
+
+/**
+ * @defgroup narrow-group Narrowing
+ * Functions for narrowing the offsets of a changing number.
+ *
+ * @remarks To find where, e.g., a program keeps a counter, one first scans the
+ * whole input for the counter's current value; every offset where it's found
+ * is a _candidate_.  After the counter changes, only the candidates are read
+ * again (via **pread**(2)) and kept only if they now satisfy a condition,
+ * e.g., equal the new value or increased.  Repeating this narrows the
+ * candidates to the counter's offset.
+ *
+ * Candidates are saved between runs in a file comprising a header followed by
+ * one record per candidate in ascending offset order: the difference from the
+ * previous candidate's offset as an unsigned LEB128 number followed by the
+ * candidate's value as read.
+ * @{
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+
+#define NARROW_BATCH        4096u       /**< Candidates read per task.      */
+#define NARROW_BYTE_ORDER   0x01020304u /**< Detects other byte orders.     */
+#define NARROW_MAGIC        "ADNARROW"  /**< Candidates file magic number.  */
+#define NARROW_SCAN_TASKS   4096u       /**< Chunks scanned per batch.      */
+#define NARROW_VERSION      1u          /**< Candidates file format version.*/
+
+/**
+ * The header of a candidates file.
+ */
+struct narrow_header {
+  char      magic[8];                   ///< #NARROW_MAGIC
+  uint32_t  version;                    ///< #NARROW_VERSION
+  uint32_t  byte_order;                 ///< #NARROW_BYTE_ORDER
+  uint32_t  width;                      ///< Bytes per value: 1-8.
+  uint32_t  endian;                     ///< Value \ref endian.
+  uint64_t  count;                      ///< Number of candidates.
+};
+typedef struct narrow_header narrow_header_t;
+
+/**
+ * A set of candidates.
+ */
+struct narrow_set {
+  uint64_t *offsets;                    ///< Ascending candidate offsets.
+  char8_t  *values;                     ///< \ref width bytes per candidate.
+  size_t    len;                        ///< Number of candidates.
+  size_t    cap;                        ///< Capacity of both arrays.
+  size_t    width;                      ///< Bytes per value.
+  endian_t  endian;                     ///< Value endianness.
+};
+typedef struct narrow_set narrow_set_t;
+
+/**
+ * Data for scanning the input for a value in parallel.
+ */
+struct narrow_scan_job {
+  off_t         begin;                  ///< Offset to start at.
+  off_t         end;                    ///< Offset to end at.
+  size_t        chunk_size;             ///< Bytes per task.
+  size_t        page_size;              ///< Bytes per unreadable page.
+  char8_t     **bufs;                   ///< Per-worker read buffers.
+  narrow_set_t *sets;                   ///< Per-task candidates.
+};
+typedef struct narrow_scan_job narrow_scan_job_t;
+
+/**
+ * Data for reading the current values of candidates in parallel.
+ */
+struct narrow_read_job {
+  narrow_set_t const *set;              ///< Candidates to read.
+  char8_t            *values;           ///< Current values of candidates.
+  bool               *is_read;          ///< Was the candidate readable?
+};
+typedef struct narrow_read_job narrow_read_job_t;
+
+// local variable definitions
+static uint64_t narrow_value;           ///< Value for \ref NARROW_EQUAL.
+
+////////// local functions ////////////////////////////////////////////////////
+
+/**
+ * Adds a candidate to a set.
+ *
+ * @param set The set to add to.
+ * @param offset The offset of the candidate; must be greater than that of the
+ * last candidate.
+ * @param value The value of the candidate.
+ */
+static void narrow_add( narrow_set_t *set, uint64_t offset,
+                        char8_t const *value ) {
+  if ( set->len == set->cap ) {
+    set->cap = set->cap == 0 ? 64 : set->cap * 2;
+    REALLOC( set->offsets, set->cap );
+    REALLOC( set->values, set->cap * set->width );
+  }
+  set->offsets[ set->len ] = offset;
+  memcpy( set->values + set->len * set->width, value, set->width );
+  ++set->len;
+}
+
+/**
+ * Decodes a value.
+ *
+ * @param value A pointer to the bytes of the value.
+ * @param width The number of bytes.
+ * @param endian The endianness of the bytes.
+ * @return Returns said value.
+ */
+NODISCARD
+static uint64_t narrow_decode( char8_t const *value, size_t width,
+                               endian_t endian ) {
+  uint64_t n = 0;
+  for ( size_t i = 0; i < width; ++i )
+    n = n << 8 | value[ endian == ENDIAN_BIG ? i : width - 1 - i ];
+  return n;
+}
+
+/**
+ * Checks whether a candidate should be kept.
+ *
+ * @param set The candidates.
+ * @param old_value The candidate's previous value.
+ * @param new_value The candidate's current value.
+ * @return Returns `true` only if the candidate should be kept.
+ */
+NODISCARD
+static bool narrow_keep( narrow_set_t const *set, char8_t const *old_value,
+                         char8_t const *new_value ) {
+  uint64_t const o = narrow_decode( old_value, set->width, set->endian );
+  uint64_t const n = narrow_decode( new_value, set->width, set->endian );
+  switch ( opt_narrow ) {
+    case NARROW_NONE:
+      break;
+    case NARROW_CHANGED:
+      return n != o;
+    case NARROW_DECREASED:
+      return n < o;
+    case NARROW_EQUAL:
+      return n == narrow_value;
+    case NARROW_INCREASED:
+      return n > o;
+    case NARROW_UNCHANGED:
+      return n == o;
+  } // switch
+  UNEXPECTED_INT_VALUE( opt_narrow );
+}
+
+/**
+ * Reads a candidates file.
+ *
+ * @param file The file to read from.
+ * @param set The set to read into.
+ */
+static void narrow_load( FILE *file, narrow_set_t *set ) {
+  narrow_header_t header;
+  if ( fread( &header, sizeof header, 1, file ) != 1 ||
+       memcmp( header.magic, NARROW_MAGIC, sizeof header.magic ) != 0 ||
+       header.version != NARROW_VERSION ||
+       header.byte_order != NARROW_BYTE_ORDER ||
+       header.width < 1 || header.width > 8 ||
+       (header.endian != ENDIAN_LITTLE && header.endian != ENDIAN_BIG) ) {
+    fatal_error( EX_DATAERR,
+      "\"%s\": not a candidates file\n", opt_narrow_path
+    );
+  }
+  set->width = header.width;
+  set->endian = STATIC_CAST( endian_t, header.endian );
+
+  uint64_t offset = 0;
+  char8_t value[8];
+  for ( uint64_t i = 0; i < header.count; ++i ) {
+    uint64_t delta = 0;
+    for ( unsigned shift = 0; ; shift += 7 ) {
+      int const c = getc( file );
+      if ( c == EOF || shift > 63 )
+        goto truncated;
+      delta |= STATIC_CAST( uint64_t, c & 0x7F ) << shift;
+      if ( (c & 0x80) == 0 )
+        break;
+    } // for
+    offset += delta;
+    if ( fread( value, set->width, 1, file ) != 1 )
+      goto truncated;
+    narrow_add( set, offset, value );
+  } // for
+  return;
+
+truncated:
+  fatal_error( EX_DATAERR,
+    "\"%s\": candidates file truncated\n", opt_narrow_path
+  );
+}
+
+/**
+ * Reads the current values of one batch of candidates.
+ *
+ * @param data A pointer to a \ref narrow_read_job.
+ * @param task The batch number.
+ * @param worker The worker number (unused).
+ */
+static void narrow_read_task( void *data, size_t task, unsigned worker ) {
+  narrow_read_job_t const *const job = data;
+  narrow_set_t const *const set = job->set;
+  (void)worker;
+
+  size_t end = (task + 1) * NARROW_BATCH;
+  if ( end > set->len )
+    end = set->len;
+  for ( size_t i = task * NARROW_BATCH; i < end; ++i ) {
+    ssize_t const n = input_pread(
+      job->values + i * set->width, set->width,
+      STATIC_CAST( off_t, set->offsets[i] )
+    );
+    // Unreadable candidates (e.g., past EOF or unmapped memory) are dropped.
+    job->is_read[i] = n == STATIC_CAST( ssize_t, set->width );
+  } // for
+}
+
+/**
+ * Writes the candidates file.
+ *
+ * @param set The candidates to write.
+ */
+static void narrow_save( narrow_set_t const *set ) {
+  char *const tmp_path = free_later(
+    MALLOC( char, strlen( opt_narrow_path ) + sizeof ".tmp" )
+  );
+  strcpy( tmp_path, opt_narrow_path );
+  strcat( tmp_path, ".tmp" );
+  FILE *const file = fopen( tmp_path, "w" );
+  if ( unlikely( file == NULL ) )
+    fatal_error( EX_CANTCREAT, "\"%s\": %s\n", tmp_path, STRERROR() );
+
+  narrow_header_t const header = {
+    .magic = NARROW_MAGIC,
+    .version = NARROW_VERSION,
+    .byte_order = NARROW_BYTE_ORDER,
+    .width = STATIC_CAST( uint32_t, set->width ),
+    .endian = set->endian,
+    .count = set->len
+  };
+  PERROR_EXIT_IF( fwrite( &header, sizeof header, 1, file ) < 1, EX_IOERR );
+  uint64_t prev = 0;
+  for ( size_t i = 0; i < set->len; ++i ) {
+    uint64_t delta = set->offsets[i] - prev;
+    prev = set->offsets[i];
+    do {
+      char8_t const c = STATIC_CAST( char8_t, delta & 0x7F );
+      delta >>= 7;
+      FPUTC( delta != 0 ? c | 0x80 : c, file );
+    } while ( delta != 0 );
+    PERROR_EXIT_IF(
+      fwrite( set->values + i * set->width, 1, set->width, file ) < set->width,
+      EX_IOERR
+    );
+  } // for
+
+  if ( unlikely( fclose( file ) != 0 ) )
+    fatal_error( EX_IOERR, "\"%s\": %s\n", tmp_path, STRERROR() );
+  if ( unlikely( rename( tmp_path, opt_narrow_path ) != 0 ) ) {
+    fatal_error( EX_CANTCREAT,
+      "\"%s\": can not rename to \"%s\": %s\n",
+      tmp_path, opt_narrow_path, STRERROR()
+    );
+  }
+}
+
+/**
+ * Adds every occurrence of \ref opt_search_buf in \a buf starting before \a
+ * starts_end to \a set.
+ *
+ * @param set The set to add candidates to.
+ * @param buf The bytes to search.
+ * @param bytes The number of bytes in \a buf.
+ * @param pos The offset of \a buf.
+ * @param starts_end The offset before which occurrences must start.
+ */
+static void narrow_scan_buf( narrow_set_t *set, char8_t const *buf,
+                             size_t bytes, off_t pos, off_t starts_end ) {
+  size_t starts = bytes;
+  if ( STATIC_CAST( off_t, starts ) > starts_end - pos )
+    starts = STATIC_CAST( size_t, starts_end - pos );
+  char8_t const first = STATIC_CAST( char8_t, opt_search_buf[0] );
+  for ( char8_t const *p = buf; p < buf + starts; ++p ) {
+    p = memchr( p, first, STATIC_CAST( size_t, buf + starts - p ) );
+    if ( p == NULL )
+      break;
+    size_t const i = STATIC_CAST( size_t, p - buf );
+    if ( i + opt_search_len <= bytes &&
+         memcmp( p, opt_search_buf, opt_search_len ) == 0 ) {
+      narrow_add( set, STATIC_CAST( uint64_t, pos ) + i, p );
+    }
+  } // for
+}
+
+/**
+ * Scans one chunk of the input for \ref opt_search_buf.
+ *
+ * @remarks Process memory via <code>/proc/</code><i>pid</i><code>/mem</code>
+ * is sparse: reading an unmapped page fails with `EIO` and reading up to one
+ * returns fewer bytes.  Hence, the bytes that could be read are scanned and
+ * reading resumes at the next page.
+ *
+ * @param data A pointer to a \ref narrow_scan_job.
+ * @param task The chunk number.
+ * @param worker The worker number.
+ */
+static void narrow_scan_task( void *data, size_t task, unsigned worker ) {
+  narrow_scan_job_t const *const job = data;
+  narrow_set_t *const set = &job->sets[ task ];
+  char8_t *const buf = job->bufs[ worker ];
+
+  off_t const begin =
+    job->begin + STATIC_CAST( off_t, task * job->chunk_size );
+  off_t starts_end = begin + STATIC_CAST( off_t, job->chunk_size );
+  if ( starts_end > job->end )
+    starts_end = job->end;
+  // Read width-1 bytes more so values spanning chunks are found.
+  off_t read_end = starts_end + STATIC_CAST( off_t, opt_search_len - 1 );
+  if ( read_end > job->end )
+    read_end = job->end;
+
+  for ( off_t pos = begin; pos < starts_end; ) {
+    size_t const len = STATIC_CAST( size_t, read_end - pos );
+    size_t bytes = 0;
+    ssize_t n = 0;
+    while ( bytes < len ) {
+      n = input_pread(
+        buf + bytes, len - bytes, pos + STATIC_CAST( off_t, bytes )
+      );
+      if ( n <= 0 )
+        break;
+      bytes += STATIC_CAST( size_t, n );
+    } // while
+    if ( n == -1 && errno != EIO )
+      fatal_error( EX_IOERR, "\"%s\": %s\n", fin_path, STRERROR() );
+
+    narrow_scan_buf( set, buf, bytes, pos, starts_end );
+    if ( n != -1 )                      // read all or reached EOF
+      break;
+
+    // Skip the unreadable page, e.g., unmapped process memory.
+    off_t const page_size = STATIC_CAST( off_t, job->page_size );
+    pos = (pos + STATIC_CAST( off_t, bytes )) / page_size * page_size +
+          page_size;
+  } // for
+}
+
+/**
+ * Scans the input for \ref opt_search_buf to find the initial candidates.
+ *
+ * @param set The set to add candidates to.
+ */
+static void narrow_scan( narrow_set_t *set ) {
+  unsigned const jobs = par_jobs();
+  long const page_size = sysconf( _SC_PAGESIZE );
+  narrow_scan_job_t job = {
+    .begin = fin_offset,
+    .chunk_size = par_chunk_size(),
+    .page_size = page_size > 0 ? STATIC_CAST( size_t, page_size ) : 4096,
+    .bufs = MALLOC( char8_t*, jobs )
+  };
+
+  job.end = input_size();
+  if ( opt_max_bytes != SIZE_MAX &&
+       (job.end <= 0 ||
+        STATIC_CAST( uint64_t, job.end - job.begin ) > opt_max_bytes) ) {
+    job.end = job.begin + STATIC_CAST( off_t, opt_max_bytes );
+  }
+  else if ( job.end <= 0 ) {
+    char opt1_buf[ OPT_BUF_SIZE ];
+    char opt2_buf[ OPT_BUF_SIZE ];
+    fatal_error( EX_USAGE,
+      "\"%s\": size unknown: %s requires %s\n",
+      fin_path,
+      opt_format( COPT(NARROW), opt1_buf, sizeof opt1_buf ),
+      opt_format( COPT(MAX_BYTES), opt2_buf, sizeof opt2_buf )
+    );
+  }
+
+  for ( unsigned w = 0; w < jobs; ++w )
+    job.bufs[w] = MALLOC( char8_t, job.chunk_size + opt_search_len - 1 );
+
+  //
+  // Chunks are scanned in batches so the per-task candidates needn't be
+  // allocated for the whole input at once, e.g., for a large address space.
+  //
+  size_t const batch_size = NARROW_SCAN_TASKS * job.chunk_size;
+  job.sets = MALLOC( narrow_set_t, NARROW_SCAN_TASKS );
+  for ( ; job.begin < job.end;
+        job.begin += STATIC_CAST( off_t, batch_size ) ) {
+    uint64_t const left = STATIC_CAST( uint64_t, job.end - job.begin );
+    size_t const n_tasks = left < batch_size ?
+      STATIC_CAST( size_t, (left + job.chunk_size - 1) / job.chunk_size ) :
+      NARROW_SCAN_TASKS;
+    for ( size_t t = 0; t < n_tasks; ++t )
+      job.sets[t] = (narrow_set_t){ .width = set->width };
+    par_for( n_tasks, &narrow_scan_task, &job );
+
+    // Merge the per-task candidates in task (hence offset) order.
+    for ( size_t t = 0; t < n_tasks; ++t ) {
+      narrow_set_t *const s = &job.sets[t];
+      for ( size_t i = 0; i < s->len; ++i )
+        narrow_add( set, s->offsets[i], s->values + i * s->width );
+      free( s->offsets );
+      free( s->values );
+    } // for
+  } // for
+  free( job.sets );
+
+  for ( unsigned w = 0; w < jobs; ++w )
+    free( job.bufs[w] );
+  free( job.bufs );
+}
+
+/**
+ * Prints the candidates.
+ *
+ * @param set The candidates to print.
+ */
+static void narrow_print( narrow_set_t const *set ) {
+  char const *const offset_format = get_offsets_format();
+  for ( size_t i = 0; i < set->len; ++i ) {
+    if ( opt_offsets != OFFSETS_NONE ) {
+      color_start( fout, sgr_offset );
+      PRINTF( offset_format, set->offsets[i] );
+      color_end( fout, sgr_offset );
+      color_start( fout, sgr_sep );
+      PUTC( ':' );
+      color_end( fout, sgr_sep );
+      PUTC( ' ' );
+    }
+    uint64_t const value =
+      narrow_decode( set->values + i * set->width, set->width, set->endian );
+    color_start( fout, sgr_hex_match );
+    PRINTF( "%0*" PRIX64, STATIC_CAST( int, set->width * 2 ), value );
+    color_end( fout, sgr_hex_match );
+    PRINTF( " %" PRIu64 "\n", value );
+  } // for
+}
+
+////////// extern functions ///////////////////////////////////////////////////
+
+/**
+ * Narrows the candidates in \ref opt_narrow_path, if it exists, by \ref
+ * opt_narrow; otherwise scans the input for \ref opt_search_buf to find them.
+ * Either way, saves and prints the resulting candidates.
+ */
+void narrow_file( void ) {
+  narrow_set_t set = { .width = opt_search_len, .endian = opt_search_endian };
+
+  FILE *const file = fopen( opt_narrow_path, "r" );
+  if ( file == NULL ) {
+    if ( errno != ENOENT ) {
+      fatal_error( EX_NOINPUT, "\"%s\": %s\n", opt_narrow_path, STRERROR() );
+    }
+    if ( opt_narrow != NARROW_EQUAL ) {
+      fatal_error( EX_USAGE,
+        "\"%s\": no candidates to narrow; first scan for a number\n",
+        opt_narrow_path
+      );
+    }
+    narrow_scan( &set );
+  }
+  else {
+    narrow_load( file, &set );
+    fclose( file );
+    if ( opt_narrow == NARROW_EQUAL ) {
+      // The number is compared by value, so its size needn't match.
+      narrow_value = narrow_decode(
+        POINTER_CAST( char8_t const*, opt_search_buf ), opt_search_len,
+        opt_search_endian
+      );
+      if ( set.width < 8 && narrow_value >> (set.width * 8) != 0 ) {
+        fatal_error( EX_USAGE,
+          "%" PRIu64 ": number too big for candidates in \"%s\": %zu bytes\n",
+          narrow_value, opt_narrow_path, set.width
+        );
+      }
+    }
+
+    narrow_read_job_t job = {
+      .set = &set,
+      .values = MALLOC( char8_t, set.len * set.width + 1 ),
+      .is_read = MALLOC( bool, set.len + 1 )
+    };
+    par_for( (set.len + NARROW_BATCH - 1) / NARROW_BATCH,
+             &narrow_read_task, &job );
+
+    size_t kept = 0;
+    for ( size_t i = 0; i < set.len; ++i ) {
+      char8_t const *const new_value = job.values + i * set.width;
+      if ( !job.is_read[i] ||
+           !narrow_keep( &set, set.values + i * set.width, new_value ) ) {
+        continue;
+      }
+      set.offsets[ kept ] = set.offsets[i];
+      memcpy( set.values + kept * set.width, new_value, set.width );
+      ++kept;
+    } // for
+    set.len = kept;
+    free( job.values );
+    free( job.is_read );
+  }
+
+  narrow_save( &set );
+  total_matches = set.len;
+  if ( opt_matches != MATCHES_ONLY_PRINT )
+    narrow_print( &set );
+  if ( opt_matches != MATCHES_NO_PRINT ) {
+    FFLUSH( fout );
+    EPRINTF( "%lu\n", total_matches );
+  }
+
+  free( set.offsets );
+  free( set.values );
+  if ( total_matches == 0 )
+    exit( EX_NO_MATCHES );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/** @} */
+
+/* vim:set et sw=2 ts=2: */
@@ -26,7 +26,9 @@
 // local
 #include "pjl_config.h"                 /* must go first */
 #include "ad.h"
+#include "address_map.h"
 #include "color.h"
+#include "input.h"
 #include "options.h"
 #include "unicode.h"
 
@@ -41,13 +43,20 @@
 #ifdef HAVE_LANGINFO_H
 #include <langinfo.h>
 #endif /* HAVE_LANGINFO_H */
+#ifdef HAVE_LINUX_FS_H
+#include <linux/fs.h>                   /* for FICLONE */
+#endif /* HAVE_LINUX_FS_H */
 #ifdef HAVE_LOCALE_H
 #include <locale.h>
 #endif /* HAVE_LOCALE_H */
+#include <math.h>                       /* for floor(), isnan() */
 #include <stddef.h>                     /* for size_t */
 #include <stdio.h>                      /* for fdopen() */
 #include <stdlib.h>                     /* for exit() */
 #include <string.h>                     /* for str...() */
+#ifdef HAVE_SYS_IOCTL_H
+#include <sys/ioctl.h>                  /* for ioctl(2) */
+#endif /* HAVE_SYS_IOCTL_H */
 #include <sys/stat.h>                   /* for fstat() */
 #include <sys/types.h>
 #include <sysexits.h>
@@ -62,42 +71,6 @@
 # undef LITTLE_ENDIAN
 #endif /* LITTLE_ENDIAN */
 
-// in ascending option character ASCII order; sort using: sort -bdfk3
-#define OPT_NO_ASCII            A
-#define OPT_BITS                b
-#define OPT_BYTES               B
-#define OPT_COLOR               c
-#define OPT_C_ARRAY             C
-#define OPT_DECIMAL             d
-#define OPT_BIG_ENDIAN          E
-#define OPT_LITTLE_ENDIAN       e
-#define OPT_GROUP_BY            g
-#define OPT_HELP                h
-#define OPT_HOST_ENDIAN         H
-#define OPT_IGNORE_CASE         i
-#define OPT_SKIP_BYTES          j
-#define OPT_MAX_LINES           L
-#define OPT_MATCHING_ONLY       m
-#define OPT_STRINGS             n
-#define OPT_MAX_BYTES           N
-#define OPT_NO_OFFSETS          O
-#define OPT_OCTAL               o
-#define OPT_PRINTING_ONLY       p
-#define OPT_PLAIN               P
-#define OPT_REVERSE             r
-#define OPT_STRING              s
-#define OPT_STRINGS_OPTS        S
-#define OPT_TOTAL_MATCHES       t
-#define OPT_TOTAL_MATCHES_ONLY  T
-#define OPT_UTF8                u
-#define OPT_UTF8_PADDING        U
-#define OPT_VERSION             v
-#define OPT_VERBOSE             V
-#define OPT_HEXADECIMAL         x
-
-/// Command-line option character as a character literal.
-#define COPT(X)                   CHARIFY(OPT_##X)
-
 /// Command-line option character as a single-character string literal.
 #define SOPT(X)                   STRINGIFY(OPT_##X)
 
@@ -123,8 +96,6 @@
  */
 #define NF(N)                     (~0ull >> ((sizeof(long long)*2 - (N)) * 4))
 
-#define OPT_BUF_SIZE        32          /**< Maximum size for an option. */
-
 ///////////////////////////////////////////////////////////////////////////////
 
 /**
@@ -137,24 +108,63 @@ enum utf8_when {
 };
 typedef enum utf8_when utf8_when_t;
 
+// extern function declarations
+void profile_load( void );
+
 /// @cond DOXYGEN_IGNORE
 /// Otherwise Doxygen generates two entries.
 
 // option extern variable definitions
+char const     *opt_address_map_path;
+ad_aggregate_t  opt_aggregate;
+bool            opt_bit_errors;
+size_t          opt_bit_errors_block = BIT_ERRORS_BLOCK_DEFAULT;
+char8_t const  *opt_bit_errors_fill;
+size_t          opt_bit_errors_fill_len;
+char const     *opt_bit_errors_path;
 ad_c_array_t    opt_c_array;
+ad_cache_t      opt_cache;
+char const     *opt_calibrate_dir;
 color_when_t    opt_color_when = COLOR_WHEN_DEFAULT;
 bool            opt_dump_ascii = true;
+bool            opt_float;
+bool            opt_float_aligned;
+double          opt_float_tolerance;
+bool            opt_float_ulps;
+double          opt_float_value;
+char           *opt_followed_buf;
+size_t          opt_followed_len;
 unsigned        opt_group_by = GROUP_BY_DEFAULT;
 bool            opt_ignore_case;
+ad_image_t      opt_image;
+char const     *opt_index_path;
+char const *const *opt_index_files;
+size_t          opt_index_files_len;
+bool            opt_image_entropy;
+unsigned        opt_image_width = IMAGE_WIDTH_DEFAULT;
+unsigned        opt_jobs;
+bool            opt_jobs_pin;
+bool            opt_last;
+char const     *opt_line_index_path;
 size_t          opt_max_bytes = SIZE_MAX;
 ad_matches_t    opt_matches;
+ad_narrow_t     opt_narrow;
+char const     *opt_narrow_path;
 ad_offsets_t    opt_offsets = OFFSETS_HEX;
 bool            opt_only_matching;
 bool            opt_only_printing;
+unsigned        opt_output_compress;
+ad_record_t     opt_record;
+char const     *opt_replace_buf;
+bool            opt_replace_in_place;
 bool            opt_reverse;
+double          opt_sample;
+bool            opt_sample_random;
 char           *opt_search_buf;
 endian_t        opt_search_endian;
 size_t          opt_search_len;
+bool            opt_snapshot;
+bool            opt_split;
 bool            opt_strings;
 ad_strings_t    opt_strings_opts = STRINGS_LINEFEED
                                  | STRINGS_NULL
@@ -163,6 +173,8 @@ ad_strings_t    opt_strings_opts = STRINGS_LINEFEED
 bool            opt_utf8;
 char8_t const  *opt_utf8_pad = UTF8_STR( "\xE2\x96\xA1" ); // 25A1 white square
 bool            opt_verbose;
+char const     *opt_verify_path;
+size_t          opt_within;
 
 /// @endcond
 
@@ -172,29 +184,48 @@ bool            opt_verbose;
  * @sa OPTIONS_HELP
  */
 static struct option const OPTIONS[] = {
+  { "address-map",        required_argument,  NULL, COPT(ADDRESS_MAP)         },
+  { "aggregate",          optional_argument,  NULL, COPT(AGGREGATE)           },
+  { "bit-errors",         required_argument,  NULL, COPT(BIT_ERRORS)          },
   { "bits",               required_argument,  NULL, COPT(BITS)                },
   { "bytes",              required_argument,  NULL, COPT(BYTES)               },
+  { "cache",              optional_argument,  NULL, COPT(CACHE)               },
+  { "calibrate",          optional_argument,  NULL, COPT(CALIBRATE)           },
   { "color",              required_argument,  NULL, COPT(COLOR)               },
   { "c-array",            optional_argument,  NULL, COPT(C_ARRAY)             },
   { "decimal",            no_argument,        NULL, COPT(DECIMAL)             },
+  { "detect-record",      optional_argument,  NULL, COPT(DETECT_RECORD)       },
   { "little-endian",      required_argument,  NULL, COPT(LITTLE_ENDIAN)       },
   { "big-endian",         required_argument,  NULL, COPT(BIG_ENDIAN)          },
+  { "float",              required_argument,  NULL, COPT(FLOAT)               },
+  { "followed-by",        required_argument,  NULL, COPT(FOLLOWED_BY)         },
   { "group-by",           required_argument,  NULL, COPT(GROUP_BY)            },
   { "help",               no_argument,        NULL, COPT(HELP)                },
   { "hexadecimal",        no_argument,        NULL, COPT(HEXADECIMAL)         },
   { "host-endian",        required_argument,  NULL, COPT(HOST_ENDIAN)         },
   { "ignore-case",        no_argument,        NULL, COPT(IGNORE_CASE)         },
+  { "image",              optional_argument,  NULL, COPT(IMAGE)               },
+  { "index",              required_argument,  NULL, COPT(INDEX)               },
   { "skip-bytes",         required_argument,  NULL, COPT(SKIP_BYTES)          },
+  { "jobs",               required_argument,  NULL, COPT(JOBS)                },
+  { "last",               no_argument,        NULL, COPT(LAST)                },
+  { "line-index",         required_argument,  NULL, COPT(LINE_INDEX)          },
   { "max-lines",          required_argument,  NULL, COPT(MAX_LINES)           },
   { "matching-only",      no_argument,        NULL, COPT(MATCHING_ONLY)       },
   { "max-bytes",          required_argument,  NULL, COPT(MAX_BYTES)           },
+  { "narrow",             required_argument,  NULL, COPT(NARROW)              },
   { "no-ascii",           no_argument,        NULL, COPT(NO_ASCII)            },
   { "no-offsets",         no_argument,        NULL, COPT(NO_OFFSETS)          },
   { "octal",              no_argument,        NULL, COPT(OCTAL)               },
+  { "output-compress",    optional_argument,  NULL, COPT(OUTPUT_COMPRESS)     },
   { "printable-only",     no_argument,        NULL, COPT(PRINTING_ONLY)       },
   { "plain",              no_argument,        NULL, COPT(PLAIN)               },
+  { "replace",            required_argument,  NULL, COPT(REPLACE)             },
   { "reverse",            no_argument,        NULL, COPT(REVERSE)             },
   { "revert",             no_argument,        NULL, COPT(REVERSE)             },
+  { "sample",             required_argument,  NULL, COPT(SAMPLE)              },
+  { "snapshot",           no_argument,        NULL, COPT(SNAPSHOT)            },
+  { "split",              no_argument,        NULL, COPT(SPLIT)               },
   { "string",             required_argument,  NULL, COPT(STRING)              },
   { "strings",            optional_argument,  NULL, COPT(STRINGS)             },
   { "strings-opts",       required_argument,  NULL, COPT(STRINGS_OPTS)        },
@@ -203,7 +234,9 @@ static struct option const OPTIONS[] = {
   { "utf8",               required_argument,  NULL, COPT(UTF8)                },
   { "utf8-padding",       required_argument,  NULL, COPT(UTF8_PADDING)        },
   { "verbose",            no_argument,        NULL, COPT(VERBOSE)             },
+  { "verify",             required_argument,  NULL, COPT(VERIFY)              },
   { "version",            no_argument,        NULL, COPT(VERSION)             },
+  { "within",             required_argument,  NULL, COPT(WITHIN)              },
   { NULL,                 0,                  NULL, 0                         }
 };
 
@@ -216,28 +249,47 @@ static struct option const OPTIONS[] = {
  * @sa opt_help()
  */
 static char const *const OPTIONS_HELP[] = {
+  [ COPT(ADDRESS_MAP) ] = "Show addresses per ELF, PE, or text segment map",
+  [ COPT(AGGREGATE) ] = "Report unique strings sorted by count/offset [default: count]",
   [ COPT(BIG_ENDIAN) ] = "Highlight big-endian number",
+  [ COPT(BIT_ERRORS) ] = "Report flipped bits vs. file or fill: ref[:block]",
   [ COPT(BITS) ] = "Number size in bits: 8-64 [default: auto]",
   [ COPT(BYTES) ] = "Number size in bytes: 1-8 [default: auto]",
   [ COPT(C_ARRAY) ] = "Dump bytes as a C array",
+  [ COPT(CACHE) ] = "Cache results keyed by infile's stat/content [default: stat]",
+  [ COPT(CALIBRATE) ] = "Calibrate to host using scratch file in directory",
   [ COPT(COLOR) ] = "When to colorize output [default: not_file]",
   [ COPT(DECIMAL) ] = "Print offsets in decimal",
+  [ COPT(DETECT_RECORD) ] = "Report or dump by record length [default: report]",
+  [ COPT(FLOAT) ] = "Highlight float: n[~tol[u]][a][b|l]",
+  [ COPT(FOLLOWED_BY) ] = "Highlight --string only if followed by string",
   [ COPT(GROUP_BY) ] = "Group bytes by 1/2/4/8/16/32 [default: " STRINGIFY(GROUP_BY_DEFAULT) "]",
   [ COPT(HELP) ] = "Print this help and exit",
   [ COPT(HEXADECIMAL) ] = "Print offsets in hexadecimal [default]",
   [ COPT(HOST_ENDIAN) ] = "Highlight host-endian number",
   [ COPT(IGNORE_CASE) ] = "Ignore case for --string matches",
+  [ COPT(IMAGE) ] = "Output byte map image: [width][e][p] [default: " STRINGIFY(IMAGE_WIDTH_DEFAULT) "]",
+  [ COPT(INDEX) ] = "Build/update corpus index or search files in it",
+  [ COPT(JOBS) ] = "Jobs to run in parallel; append p to pin [default: auto]",
+  [ COPT(LAST) ] = "Search backwards from the end for the last match only",
+  [ COPT(LINE_INDEX) ] = "Write line index of dump or use it with -r",
   [ COPT(LITTLE_ENDIAN) ] = "Highlight little-endian number",
   [ COPT(MATCHING_ONLY) ] = "Only dump rows having matches",
   [ COPT(MAX_BYTES) ] = "Dump max number of bytes [default: unlimited]",
   [ COPT(MAX_LINES) ] = "Dump max number of lines [default: unlimited]",
+  [ COPT(NARROW) ] = "Narrow offsets of number saved in file: [how:]file",
   [ COPT(NO_ASCII) ] = "Suppress printing the ASCII part",
   [ COPT(NO_OFFSETS) ] = "Suppress printing offsets",
   [ COPT(OCTAL) ] = "Print offsets in octal",
+  [ COPT(OUTPUT_COMPRESS) ] = "Compress output as seekable gzip: [1-9] [default: " STRINGIFY(OUTPUT_COMPRESS_DEFAULT) "]",
   [ COPT(PLAIN) ] = "Dump in plain format; same as: -AOg32",
   [ COPT(PRINTING_ONLY) ] = "Only dump rows having printable characters",
+  [ COPT(REPLACE) ] = "Replace matches with equal-length bytes",
   [ COPT(REVERSE) ] = "Reverse from dump back to binary",
+  [ COPT(SAMPLE) ] = "Dump and estimate from percent of blocks: n[r]",
   [ COPT(SKIP_BYTES) ] = "Jump to offset before dumping [default: 0]",
+  [ COPT(SNAPSHOT) ] = "Dump a copy-on-write clone of infile",
+  [ COPT(SPLIT) ] = "Read infile and its following numbered parts as one",
   [ COPT(STRING) ] = "Highlight string",
   [ COPT(STRINGS) ] = "Highlight strings at least length ARG [default: " STRINGIFY(STRINGS_LEN_DEFAULT) "]",
   [ COPT(STRINGS_OPTS) ] = "Options for --strings matches [default: 0nst]",
@@ -246,11 +298,14 @@ static char const *const OPTIONS_HELP[] = {
   [ COPT(UTF8) ] = "When to dump in UTF-8 [default: never]",
   [ COPT(UTF8_PADDING) ] = "Set UTF-8 padding character [default: U+2581]",
   [ COPT(VERBOSE) ] = "Dump repeated rows also",
+  [ COPT(VERIFY) ] = "Verify dump against file (with -r)",
   [ COPT(VERSION) ] = "Print version and exit",
+  [ COPT(WITHIN) ] = "Max bytes between --string and --followed-by",
 };
 
 // local variable definitions
 static bool         opts_given[ 128 ];  ///< Table of options that were given.
+static char const  *opts_arg[ 128 ];    ///< Last argument of each option.
 
 /**
  * The number to search for, if any.
@@ -260,11 +315,18 @@ static bool         opts_given[ 128 ];  ///< Table of options that were given.
  */
 static uint64_t     search_number;
 
+/**
+ * The number to replace \ref search_number with, if any.
+ *
+ * @remarks The bytes comprising the number are rearranged according to \ref
+ * opt_search_endian.
+ */
+static uint64_t     replace_number;
+
 // local functions
 static void         set_all_or_none( char const**, char const* );
 NODISCARD
-static char const*  opt_format( char, char[const], size_t ),
-                 *  opt_get_long( char );
+static char const*  opt_get_long( char );
 
 /////////// local functions ///////////////////////////////////////////////////
 
@@ -441,26 +503,6 @@ static void opt_check_required( char const *opts, char const *req_opts ) {
   } // for
 }
 
-/**
- * Formats an option as <code>[--%s/]-%c</code> where \c %s is the long option
- * (if any) and %c is the short option.
- *
- * @param short_opt The short option (along with its corresponding long option,
- * if any) to format.
- * @param buf The buffer to use.
- * @param size The size of \a buf.
- * @return Returns \a buf.
- */
-NODISCARD
-static char const* opt_format( char short_opt, char buf[const], size_t size ) {
-  char const *const long_opt = opt_get_long( short_opt );
-  snprintf(
-    buf, size, "%s%s%s-%c",
-    *long_opt ? "--" : "", long_opt, *long_opt ? "/" : "", short_opt
-  );
-  return buf;
-}
-
 /**
  * Gets the corresponding name of the long option for the given short option.
  *
@@ -490,6 +532,46 @@ static char const* opt_help( int opt ) {
   return help;
 }
 
+/**
+ * Parses the option for \c --aggregate/-a.
+ *
+ * @param s The NULL-terminated string to parse or NULL for the default.
+ * @return Returns the corresponding \ref ad_aggregate or prints an error
+ * message and exits if \a s is invalid.
+ */
+NODISCARD
+static ad_aggregate_t parse_aggregate( char const *s ) {
+  if ( s == NULL || strcasecmp( s, "count" ) == 0 )
+    return AGGREGATE_COUNT;
+  if ( strcasecmp( s, "offset" ) == 0 )
+    return AGGREGATE_OFFSET;
+  char opt_buf[ OPT_BUF_SIZE ];
+  fatal_error( EX_USAGE,
+    "\"%s\": invalid value for %s; must be one of:\n\tcount, offset\n",
+    s, opt_format( COPT(AGGREGATE), opt_buf, sizeof opt_buf )
+  );
+}
+
+/**
+ * Parses the option for \c --cache/-Y.
+ *
+ * @param s The NULL-terminated string to parse or NULL for the default.
+ * @return Returns the corresponding \ref ad_cache or prints an error message
+ * and exits if \a s is invalid.
+ */
+NODISCARD
+static ad_cache_t parse_cache( char const *s ) {
+  if ( s == NULL || strcasecmp( s, "stat" ) == 0 )
+    return CACHE_STAT;
+  if ( strcasecmp( s, "content" ) == 0 )
+    return CACHE_CONTENT;
+  char opt_buf[ OPT_BUF_SIZE ];
+  fatal_error( EX_USAGE,
+    "\"%s\": invalid value for %s; must be one of:\n\tstat, content\n",
+    s, opt_format( COPT(CACHE), opt_buf, sizeof opt_buf )
+  );
+}
+
 /**
  * Parses a C array format value.
  *
@@ -625,6 +707,78 @@ static color_when_t parse_color_when( char const *when ) {
   );
 }
 
+/**
+ * Parses the option for \c --float/-f.
+ *
+ * @param s The NULL-terminated string to parse.  It is of the form
+ * <i>n</i><code>[~</code><i>t</i><code>[u]][a][b|l]</code> where _n_ is the
+ * value, _t_ is the absolute tolerance (or, if followed by `u`, the tolerance
+ * in units in the last place), `a` means match only at offsets that are a
+ * multiple of the number size, and `b` or `l` means big- or little-endian
+ * rather than host-endian.
+ * @return Returns the value
+ * or prints an error message and exits if the value is invalid.
+ */
+NODISCARD
+static double parse_float( char const *s ) {
+  assert( s != NULL );
+  char const *const s0 = s;
+  char *end;
+
+  SKIP_WS( s );
+  errno = 0;
+  double const value = strtod( s, &end );
+  if ( unlikely( errno != 0 || end == s || isnan( value ) ) )
+    goto error;
+  s = end;
+  if ( *s == '~' ) {
+    ++s;
+    if ( !isdigit( *s ) && *s != '.' )
+      goto error;
+    errno = 0;
+    opt_float_tolerance = strtod( s, &end );
+    if ( unlikely( errno != 0 || end == s || !isfinite( opt_float_tolerance ) ) )
+      goto error;
+    s = end;
+    if ( *s == 'u' ) {
+      if ( floor( opt_float_tolerance ) < opt_float_tolerance )
+        goto error;
+      opt_float_ulps = true;
+      ++s;
+    }
+  }
+  if ( *s == 'a' ) {
+    opt_float_aligned = true;
+    ++s;
+  }
+  switch ( *s ) {
+    case 'b':
+      opt_search_endian = ENDIAN_BIG;
+      ++s;
+      break;
+    case 'l':
+      opt_search_endian = ENDIAN_LITTLE;
+      ++s;
+      break;
+    default:
+#ifdef WORDS_BIGENDIAN
+      opt_search_endian = ENDIAN_BIG;
+#else
+      opt_search_endian = ENDIAN_LITTLE;
+#endif /* WORDS_BIGENDIAN */
+  } // switch
+  if ( likely( *s == '\0' ) )
+    return value;
+
+error:
+  NO_OP;
+  char opt_buf[ OPT_BUF_SIZE ];
+  fatal_error( EX_USAGE,
+    "\"%s\": invalid value for %s; must be n[~t[u]][a][b|l]\n",
+    s0, opt_format( COPT(FLOAT), opt_buf, sizeof opt_buf )
+  );
+}
+
 /**
  * Parses the option for \c --group-by/-g.
  *
@@ -652,6 +806,94 @@ static unsigned parse_group_by( char const *s ) {
   );
 }
 
+/**
+ * Parses the option for \c --image/-G.
+ *
+ * @param s The NULL-terminated string to parse or NULL for the default.  It is
+ * of the form <code>[</code><i>n</i><code>][e][p]</code> where _n_ is the
+ * width in pixels (0 or omitted means the default), `e` means color pixels by
+ * entropy rather than by byte class, and `p` means PNG rather than PPM.
+ * @return Returns the image format
+ * or prints an error message and exits if the value is invalid.
+ */
+NODISCARD
+static ad_image_t parse_image( char const *s ) {
+  if ( s == NULL )
+    return IMAGE_PPM;
+  char const *const s0 = s;
+  ad_image_t image = IMAGE_PPM;
+
+  SKIP_WS( s );
+  if ( isdigit( *s ) ) {
+    char *end;
+    errno = 0;
+    unsigned long long const width = strtoull( s, &end, 10 );
+    if ( unlikely( errno != 0 || width > IMAGE_WIDTH_MAX ) )
+      goto error;
+    if ( width > 0 )
+      opt_image_width = STATIC_CAST( unsigned, width );
+    s = end;
+  }
+  if ( *s == 'e' ) {
+    opt_image_entropy = true;
+    ++s;
+  }
+  if ( *s == 'p' ) {
+    image = IMAGE_PNG;
+    ++s;
+  }
+  if ( likely( *s == '\0' && s > s0 ) )
+    return image;
+
+error:
+  NO_OP;
+  char opt_buf[ OPT_BUF_SIZE ];
+  fatal_error( EX_USAGE,
+    "\"%s\": invalid value for %s; must be [n][e][p] where n is 0-%u\n",
+    s0, opt_format( COPT(IMAGE), opt_buf, sizeof opt_buf ), IMAGE_WIDTH_MAX
+  );
+}
+
+/**
+ * Parses the option for \c --jobs/-J.
+ *
+ * @param s The NULL-terminated string to parse.  It is of the form
+ * <code>[</code><i>n</i><code>][p]</code> where _n_ is the number of jobs (0
+ * or omitted means automatic) and `p` means pin each job to a CPU.
+ * @return Returns the number of jobs
+ * or prints an error message and exits if the value is invalid.
+ */
+NODISCARD
+static unsigned parse_jobs( char const *s ) {
+  assert( s != NULL );
+  char const *const s0 = s;
+  unsigned long long jobs = 0;
+
+  SKIP_WS( s );
+  if ( isdigit( *s ) ) {
+    char *end;
+    errno = 0;
+    jobs = strtoull( s, &end, 10 );
+    if ( unlikely( errno != 0 || jobs > JOBS_MAX ) )
+      goto error;
+    s = end;
+  }
+  if ( *s == 'p' ) {
+    opt_jobs_pin = true;
+    ++s;
+  }
+  if ( likely( *s == '\0' && s > s0 ) )
+    return STATIC_CAST( unsigned, jobs );
+
+error:
+  NO_OP;
+  char opt_buf[ OPT_BUF_SIZE ];
+  fatal_error( EX_USAGE,
+    "\"%s\": invalid value for %s; must be [n][p] where n is 0-%u\n",
+    s0, opt_format( COPT(JOBS), opt_buf, sizeof opt_buf ), JOBS_MAX
+  );
+}
+
 /**
  * Parses a string into an offset.
  * Unlike **strtoull(3)**:
@@ -692,6 +934,181 @@ error:
   fatal_error( EX_USAGE, "\"%s\": invalid offset\n", s );
 }
 
+/**
+ * Parses the option for \c --bit-errors/-y and sets \ref opt_bit_errors and
+ * related options.
+ *
+ * @param s The NULL-terminated string to parse.  It is either a reference
+ * file or a fill pattern of hexadecimal bytes like `0xFF` or `0xAA55`,
+ * optionally followed by `:` and a block size.
+ */
+static void parse_bit_errors( char const *s ) {
+  assert( s != NULL );
+  opt_bit_errors = true;
+
+  size_t ref_len = strlen( s );
+  char const *const colon = strrchr( s, ':' );
+  if ( colon != NULL && isdigit( colon[1] ) ) {
+    opt_bit_errors_block = STATIC_CAST( size_t, parse_offset( colon + 1 ) );
+    if ( opt_bit_errors_block == 0 ) {
+      char opt_buf[ OPT_BUF_SIZE ];
+      fatal_error( EX_USAGE,
+        "\"%s\": invalid block size for %s; must be > 0\n",
+        colon + 1, opt_format( COPT(BIT_ERRORS), opt_buf, sizeof opt_buf )
+      );
+    }
+    ref_len = STATIC_CAST( size_t, colon - s );
+  }
+
+  char *const ref = free_later( MALLOC( char, ref_len + 1 ) );
+  strncpy( ref, s, ref_len )[ ref_len ] = '\0';
+
+  size_t const digits = ref_len - 2;
+  if ( ref_len > 2 && ref[0] == '0' && (ref[1] == 'x' || ref[1] == 'X') &&
+       strspn( ref + 2, "0123456789ABCDEFabcdef" ) == digits ) {
+    // A fill pattern: every 2 digits (after a leading 1 if odd) is a byte.
+    char8_t *const fill =
+      free_later( MALLOC( char8_t, (digits + 1) / 2 ) );
+    char const *d = ref + 2;
+    for ( size_t i = 0; i < (digits + 1) / 2; ++i ) {
+      unsigned byte = 0;
+      for ( size_t n = i == 0 && digits % 2 != 0 ? 1 : 2; n > 0; --n, ++d ) {
+        byte = byte << 4 | STATIC_CAST( unsigned,
+          isdigit( *d ) ? *d - '0' : toupper( *d ) - 'A' + 0xA
+        );
+      } // for
+      fill[i] = STATIC_CAST( char8_t, byte );
+    } // for
+    opt_bit_errors_fill = fill;
+    opt_bit_errors_fill_len = (digits + 1) / 2;
+  }
+  else {
+    opt_bit_errors_path = ref;
+  }
+}
+
+/**
+ * Parses the option for \c --narrow/-q.
+ *
+ * @param s The NULL-terminated string to parse.  It is a file optionally
+ * preceded by one of `changed`, `decreased`, `increased`, or `unchanged`
+ * followed by `:`.
+ * @return Returns the corresponding \ref ad_narrow.  Also sets \ref
+ * opt_narrow_path.
+ */
+NODISCARD
+static ad_narrow_t parse_narrow( char const *s ) {
+  struct narrow_map {
+    char const   *map_how;
+    ad_narrow_t   map_narrow;
+  };
+  typedef struct narrow_map narrow_map_t;
+
+  static narrow_map_t const NARROW_MAP[] = {
+    { "changed",   NARROW_CHANGED   },
+    { "decreased", NARROW_DECREASED },
+    { "increased", NARROW_INCREASED },
+    { "unchanged", NARROW_UNCHANGED },
+  };
+
+  assert( s != NULL );
+  char const *const colon = strchr( s, ':' );
+  if ( colon != NULL ) {
+    size_t const how_len = STATIC_CAST( size_t, colon - s );
+    FOREACH_ARRAY_ELEMENT( narrow_map_t, m, NARROW_MAP ) {
+      if ( strncasecmp( s, m->map_how, how_len ) == 0 &&
+           m->map_how[ how_len ] == '\0' ) {
+        opt_narrow_path = colon + 1;
+        return m->map_narrow;
+      }
+    } // for
+  }
+  // Otherwise the entire value is the file, e.g., "a:b".
+  opt_narrow_path = s;
+  return NARROW_EQUAL;
+}
+
+/**
+ * Parses the option for \c --output-compress/-Z.
+ *
+ * @param s The NULL-terminated string to parse or NULL for the default.  It is
+ * a compression level in the range 1-9.
+ * @return Returns the compression level
+ * or prints an error message and exits if the value is invalid.
+ */
+NODISCARD
+static unsigned parse_output_compress( char const *s ) {
+  if ( s == NULL )
+    return OUTPUT_COMPRESS_DEFAULT;
+  if ( s[0] >= '1' && s[0] <= '9' && s[1] == '\0' )
+    return STATIC_CAST( unsigned, s[0] - '0' );
+  char opt_buf[ OPT_BUF_SIZE ];
+  fatal_error( EX_USAGE,
+    "\"%s\": invalid value for %s; must be in 1-9\n",
+    s, opt_format( COPT(OUTPUT_COMPRESS), opt_buf, sizeof opt_buf )
+  );
+}
+
+/**
+ * Parses the option for \c --sample/-Q.
+ *
+ * @param s The NULL-terminated string to parse.  It is of the form
+ * <i>n</i><code>[r]</code> where _n_ is the percent (greater than 0 and at
+ * most 100) of blocks to sample and `r` means to sample a random block from
+ * each stride rather than the first.
+ * @return Returns said percent
+ * or prints an error message and exits if the value is invalid.
+ */
+NODISCARD
+static double parse_sample( char const *s ) {
+  assert( s != NULL );
+  char const *const s0 = s;
+
+  SKIP_WS( s );
+  if ( !isdigit( *s ) && *s != '.' )
+    goto error;
+  char *end;
+  errno = 0;
+  double const percent = strtod( s, &end );
+  if ( unlikely( errno != 0 || !(percent > 0 && percent <= 100) ) )
+    goto error;
+  s = end;
+  if ( *s == 'r' ) {
+    opt_sample_random = true;
+    ++s;
+  }
+  if ( likely( *s == '\0' ) )
+    return percent;
+
+error:
+  NO_OP;
+  char opt_buf[ OPT_BUF_SIZE ];
+  fatal_error( EX_USAGE,
+    "\"%s\": invalid value for %s; must be n[r] where n is in (0,100]\n",
+    s0, opt_format( COPT(SAMPLE), opt_buf, sizeof opt_buf )
+  );
+}
+
+/**
+ * Parses the option for \c --detect-record/-w.
+ *
+ * @param s The NULL-terminated string to parse or NULL for the default.
+ * @return Returns the corresponding \ref ad_record or prints an error message
+ * and exits if \a s is invalid.
+ */
+NODISCARD
+static ad_record_t parse_record( char const *s ) {
+  if ( s == NULL || strcasecmp( s, "report" ) == 0 )
+    return RECORD_REPORT;
+  if ( strcasecmp( s, "dump" ) == 0 )
+    return RECORD_DUMP;
+  char opt_buf[ OPT_BUF_SIZE ];
+  fatal_error( EX_USAGE,
+    "\"%s\": invalid value for %s; must be one of:\n\tdump, report\n",
+    s, opt_format( COPT(DETECT_RECORD), opt_buf, sizeof opt_buf )
+  );
+}
+
 /**
  * Parses a `--strings-opts` value.
  *
@@ -857,45 +1274,95 @@ static void print_usage( int status ) {
       longest_opt_len = opt_len;
   } // for
 
-  FILE *const fout = status == EX_OK ? stdout : stderr;
+  FILE *const out = status == EX_OK ? fout : stderr;
 
-  FPRINTF( fout,
+  FPRINTF( out,
 "usage: %s [options] [+offset] [infile [outfile]]\n"
 "       %s --reverse [-" SOPT(DECIMAL) SOPT(OCTAL) SOPT(HEXADECIMAL) "] [infile [outfile]]\n"
+"       %s --calibrate[=dir]\n"
 "       %s --help\n"
 "       %s --version\n"
 "options:\n",
-    me, me, me, me
+    me, me, me, me, me
   );
 
   for ( struct option const *opt = OPTIONS; opt->name != NULL; ++opt ) {
-    FPRINTF( fout, "  --%s", opt->name );
+    FPRINTF( out, "  --%s", opt->name );
     size_t opt_len = strlen( opt->name );
     switch ( opt->has_arg ) {
       case no_argument:
         break;
       case optional_argument:
-        opt_len += STATIC_CAST( size_t, fprintf( fout, "[=ARG]" ) );
+        opt_len += STATIC_CAST( size_t, fprintf( out, "[=ARG]" ) );
         break;
       case required_argument:
-        opt_len += STATIC_CAST( size_t, fprintf( fout, "=ARG" ) );
+        opt_len += STATIC_CAST( size_t, fprintf( out, "=ARG" ) );
         break;
     } // switch
     assert( opt_len <= longest_opt_len );
-    FPUTNSP( longest_opt_len - opt_len, fout );
-    FPRINTF( fout, " (-%c) %s.\n", opt->val, opt_help( opt->val ) );
+    FPUTNSP( longest_opt_len - opt_len, out );
+    FPRINTF( out, " (-%c) %s.\n", opt->val, opt_help( opt->val ) );
   } // for
 
   FPUTS(
     "\n"
     PACKAGE_NAME " home page: " PACKAGE_URL "\n"
     "Report bugs to: " PACKAGE_BUGREPORT "\n",
-    fout
+    out
   );
 
   exit( status );
 }
 
+/**
+ * Replaces standard input, a regular file, with a copy-on-write clone of it
+ * so the input doesn't change while it's being dumped even if it's being
+ * written to.  Since a clone shares all the input's blocks, making it costs
+ * almost no I/O.  If the input can't be cloned (e.g., it's not a regular file
+ * or its file system doesn't support clones), prints a warning and continues
+ * with the input itself.
+ */
+static void snapshot_stdin( void ) {
+  char const *error = "not supported";
+#if defined(HAVE_LINUX_FS_H) && defined(HAVE_SYS_IOCTL_H) && defined(FICLONE)
+  if ( !fd_is_file( STDIN_FILENO ) ) {
+    error = "not a regular file";
+    goto warn;
+  }
+
+  // A clone must be on the same file system, so create it next to the input.
+  char const *const slash = strcmp( fin_path, "-" ) != 0 ?
+    strrchr( fin_path, '/' ) : NULL;
+  size_t const dir_len = slash == NULL ? 1 :
+    slash == fin_path ? 1 : STATIC_CAST( size_t, slash - fin_path );
+  char *const path =
+    free_later( MALLOC( char, dir_len + sizeof "/.ad-snapshot-XXXXXX" ) );
+  memcpy( path, slash == NULL ? "." : fin_path, dir_len );
+  strcpy( path + dir_len, "/.ad-snapshot-XXXXXX" );
+
+  int const fd = mkstemp( path );
+  if ( fd == -1 ) {
+    error = STRERROR();
+    goto warn;
+  }
+  PJL_DISCARD_RV( unlink( path ) );     // removed however we exit
+  if ( ioctl( fd, FICLONE, STDIN_FILENO ) != 0 ) {
+    error = STRERROR();
+    close( fd );
+    goto warn;
+  }
+  DUP2( fd, STDIN_FILENO );
+  close( fd );
+  FSEEK( stdin, 0, SEEK_SET );          // resynchronize with the new fd
+  return;
+
+warn:
+#endif /* HAVE_LINUX_FS_H && HAVE_SYS_IOCTL_H && FICLONE */
+  EPRINTF( "%s: \"%s\": can not snapshot: %s; reading directly\n",
+    me, fin_path, error
+  );
+}
+
 ////////// extern functions ///////////////////////////////////////////////////
 
 char const* gets_offsets_english( void ) {
@@ -935,6 +1402,15 @@ unsigned get_offsets_width( void ) {
       OFFSET_WIDTH_MIN : OFFSET_WIDTH_MAX;
 }
 
+char const* opt_format( char short_opt, char buf[const], size_t size ) {
+  char const *const long_opt = opt_get_long( short_opt );
+  snprintf(
+    buf, size, "%s%s%s-%c",
+    *long_opt ? "--" : "", long_opt, *long_opt ? "/" : "", short_opt
+  );
+  return buf;
+}
+
 void options_init( int argc, char const *argv[] ) {
   ASSERT_RUN_ONCE();
 
@@ -957,16 +1433,31 @@ void options_init( int argc, char const *argv[] ) {
     if ( opt == -1 )
       break;
     switch ( opt ) {
+      case COPT(ADDRESS_MAP):
+        opt_address_map_path = optarg;
+        break;
+      case COPT(AGGREGATE):
+        opt_aggregate = parse_aggregate( optarg );
+        break;
       case COPT(BIG_ENDIAN):
         search_number = STATIC_CAST( uint64_t, parse_ull( optarg ) );
         opt_search_endian = ENDIAN_BIG;
         break;
+      case COPT(BIT_ERRORS):
+        parse_bit_errors( optarg );
+        break;
       case COPT(BITS):
         size_in_bits = STATIC_CAST( size_t, parse_ull( optarg ) );
         break;
       case COPT(BYTES):
         size_in_bytes = STATIC_CAST( size_t, parse_ull( optarg ) );
         break;
+      case COPT(CACHE):
+        opt_cache = parse_cache( optarg );
+        break;
+      case COPT(CALIBRATE):
+        opt_calibrate_dir = optarg != NULL ? optarg : ".";
+        break;
       case COPT(C_ARRAY):
         opt_c_array = parse_c_array( optarg );
         break;
@@ -976,6 +1467,16 @@ void options_init( int argc, char const *argv[] ) {
       case COPT(DECIMAL):
         opt_offsets = OFFSETS_DEC;
         break;
+      case COPT(DETECT_RECORD):
+        opt_record = parse_record( optarg );
+        break;
+      case COPT(FLOAT):
+        opt_float_value = parse_float( optarg );
+        opt_float = true;
+        break;
+      case COPT(FOLLOWED_BY):
+        opt_followed_buf = free_later( check_strdup( optarg ) );
+        break;
       case COPT(GROUP_BY):
         opt_group_by = parse_group_by( optarg );
         break;
@@ -996,6 +1497,21 @@ void options_init( int argc, char const *argv[] ) {
       case COPT(IGNORE_CASE):
         opt_ignore_case = true;
         break;
+      case COPT(IMAGE):
+        opt_image = parse_image( optarg );
+        break;
+      case COPT(INDEX):
+        opt_index_path = optarg;
+        break;
+      case COPT(JOBS):
+        opt_jobs = parse_jobs( optarg );
+        break;
+      case COPT(LAST):
+        opt_last = true;
+        break;
+      case COPT(LINE_INDEX):
+        opt_line_index_path = optarg;
+        break;
       case COPT(LITTLE_ENDIAN):
         search_number = STATIC_CAST( uint64_t, parse_ull( optarg ) );
         opt_search_endian = ENDIAN_LITTLE;
@@ -1009,6 +1525,9 @@ void options_init( int argc, char const *argv[] ) {
       case COPT(MAX_LINES):
         max_lines = STATIC_CAST( size_t, parse_ull( optarg ) );
         break;
+      case COPT(NARROW):
+        opt_narrow = parse_narrow( optarg );
+        break;
       case COPT(NO_ASCII):
         opt_dump_ascii = false;
         break;
@@ -1018,20 +1537,35 @@ void options_init( int argc, char const *argv[] ) {
       case COPT(OCTAL):
         opt_offsets = OFFSETS_OCT;
         break;
+      case COPT(OUTPUT_COMPRESS):
+        opt_output_compress = parse_output_compress( optarg );
+        break;
       case COPT(PLAIN):
-        opt_group_by = ROW_BYTES_MAX;
+        opt_group_by = ROW_BYTES_PLAIN;
         opt_offsets = OFFSETS_NONE;
         opt_dump_ascii = false;
         break;
       case COPT(PRINTING_ONLY):
         opt_only_printing = true;
         break;
+      case COPT(REPLACE):
+        opt_replace_buf = optarg;
+        break;
       case COPT(REVERSE):
         opt_reverse = true;
         break;
+      case COPT(SAMPLE):
+        opt_sample = parse_sample( optarg );
+        break;
       case COPT(SKIP_BYTES):
         fin_offset += STATIC_CAST( off_t, parse_offset( optarg ) );
         break;
+      case COPT(SNAPSHOT):
+        opt_snapshot = true;
+        break;
+      case COPT(SPLIT):
+        opt_split = true;
+        break;
       case COPT(STRING):
         opt_search_buf = free_later( check_strdup( optarg ) );
         break;
@@ -1061,9 +1595,15 @@ void options_init( int argc, char const *argv[] ) {
       case COPT(VERBOSE):
         opt_verbose = true;
         break;
+      case COPT(VERIFY):
+        opt_verify_path = optarg;
+        break;
       case COPT(VERSION):
         opt_version = true;
         break;
+      case COPT(WITHIN):
+        opt_within = STATIC_CAST( size_t, parse_offset( optarg ) );
+        break;
 
       case ':':
         goto missing_arg;
@@ -1080,6 +1620,7 @@ void options_init( int argc, char const *argv[] ) {
         );
     } // switch
     opts_given[ opt ] = true;
+    opts_arg[ opt ] = optarg;
   } // for
 
   FREE( short_opts );
@@ -1088,23 +1629,234 @@ void options_init( int argc, char const *argv[] ) {
   argv += optind - 1;
 
   // handle special case of +offset option
-  if ( argc > 0 && *argv[1] == '+' ) {
+  bool const skip_offset_given = argc > 0 && *argv[1] == '+';
+  if ( skip_offset_given ) {
     fin_offset += STATIC_CAST( off_t, parse_offset( argv[1] ) );
     --argc;
     ++argv;
   }
 
   // check for exclusive options
+  opt_check_exclusive( COPT(CALIBRATE) );
   opt_check_exclusive( COPT(HELP) );
   opt_check_exclusive( COPT(VERSION) );
 
   // check for mutually exclusive options
+  opt_check_mutually_exclusive( SOPT(AGGREGATE),
+    SOPT(GROUP_BY)
+    SOPT(MATCHING_ONLY)
+    SOPT(NO_ASCII)
+    SOPT(PLAIN)
+    SOPT(PRINTING_ONLY)
+    SOPT(UTF8_PADDING)
+    SOPT(VERBOSE)
+  );
+  opt_check_mutually_exclusive( SOPT(ADDRESS_MAP),
+    SOPT(AGGREGATE)
+    SOPT(C_ARRAY)
+    SOPT(DETECT_RECORD)
+    SOPT(IMAGE)
+    SOPT(INDEX)
+    SOPT(LINE_INDEX)
+    SOPT(REPLACE)
+    SOPT(REVERSE)
+    SOPT(SAMPLE)
+    SOPT(VERIFY)
+  );
+  opt_check_mutually_exclusive( SOPT(BIT_ERRORS),
+    SOPT(ADDRESS_MAP)
+    SOPT(AGGREGATE)
+    SOPT(BIG_ENDIAN)
+    SOPT(C_ARRAY)
+    SOPT(DETECT_RECORD)
+    SOPT(FLOAT)
+    SOPT(FOLLOWED_BY)
+    SOPT(HOST_ENDIAN)
+    SOPT(IGNORE_CASE)
+    SOPT(IMAGE)
+    SOPT(INDEX)
+    SOPT(LAST)
+    SOPT(LINE_INDEX)
+    SOPT(LITTLE_ENDIAN)
+    SOPT(NARROW)
+    SOPT(PRINTING_ONLY)
+    SOPT(REPLACE)
+    SOPT(REVERSE)
+    SOPT(SAMPLE)
+    SOPT(STRING)
+    SOPT(STRINGS)
+    SOPT(STRINGS_OPTS)
+    SOPT(TOTAL_MATCHES)
+    SOPT(TOTAL_MATCHES_ONLY)
+    SOPT(VERIFY)
+  );
   opt_check_mutually_exclusive( SOPT(BITS), SOPT(BYTES) );
+  opt_check_mutually_exclusive( SOPT(CACHE),
+    SOPT(INDEX)
+    SOPT(LINE_INDEX)
+    SOPT(NARROW)
+    SOPT(REPLACE)
+    SOPT(SNAPSHOT)
+  );
+  opt_check_mutually_exclusive( SOPT(NARROW),
+    SOPT(ADDRESS_MAP)
+    SOPT(AGGREGATE)
+    SOPT(C_ARRAY)
+    SOPT(DETECT_RECORD)
+    SOPT(FLOAT)
+    SOPT(FOLLOWED_BY)
+    SOPT(GROUP_BY)
+    SOPT(IGNORE_CASE)
+    SOPT(IMAGE)
+    SOPT(INDEX)
+    SOPT(LAST)
+    SOPT(LINE_INDEX)
+    SOPT(MATCHING_ONLY)
+    SOPT(NO_ASCII)
+    SOPT(OUTPUT_COMPRESS)
+    SOPT(PLAIN)
+    SOPT(PRINTING_ONLY)
+    SOPT(REPLACE)
+    SOPT(REVERSE)
+    SOPT(SAMPLE)
+    SOPT(STRING)
+    SOPT(STRINGS)
+    SOPT(STRINGS_OPTS)
+    SOPT(UTF8)
+    SOPT(UTF8_PADDING)
+    SOPT(VERBOSE)
+    SOPT(VERIFY)
+  );
+  opt_check_mutually_exclusive( SOPT(SNAPSHOT),
+    SOPT(INDEX)
+    SOPT(REPLACE)
+  );
+  opt_check_mutually_exclusive( SOPT(SPLIT),
+    SOPT(INDEX)
+    SOPT(REPLACE)
+    SOPT(REVERSE)
+    SOPT(SNAPSHOT)
+    SOPT(VERIFY)
+  );
+  opt_check_mutually_exclusive( SOPT(IMAGE),
+    SOPT(AGGREGATE)
+    SOPT(BIG_ENDIAN)
+    SOPT(COLOR)
+    SOPT(C_ARRAY)
+    SOPT(DECIMAL)
+    SOPT(FOLLOWED_BY)
+    SOPT(GROUP_BY)
+    SOPT(HEXADECIMAL)
+    SOPT(HOST_ENDIAN)
+    SOPT(IGNORE_CASE)
+    SOPT(LAST)
+    SOPT(LITTLE_ENDIAN)
+    SOPT(MATCHING_ONLY)
+    SOPT(NO_ASCII)
+    SOPT(NO_OFFSETS)
+    SOPT(OCTAL)
+    SOPT(PLAIN)
+    SOPT(PRINTING_ONLY)
+    SOPT(REVERSE)
+    SOPT(STRING)
+    SOPT(STRINGS)
+    SOPT(STRINGS_OPTS)
+    SOPT(TOTAL_MATCHES)
+    SOPT(TOTAL_MATCHES_ONLY)
+    SOPT(UTF8)
+    SOPT(UTF8_PADDING)
+    SOPT(VERBOSE)
+  );
+  opt_check_mutually_exclusive( SOPT(INDEX),
+    SOPT(AGGREGATE)
+    SOPT(COLOR)
+    SOPT(C_ARRAY)
+    SOPT(DECIMAL)
+    SOPT(FOLLOWED_BY)
+    SOPT(GROUP_BY)
+    SOPT(HEXADECIMAL)
+    SOPT(IMAGE)
+    SOPT(LAST)
+    SOPT(MATCHING_ONLY)
+    SOPT(MAX_BYTES)
+    SOPT(MAX_LINES)
+    SOPT(NO_ASCII)
+    SOPT(NO_OFFSETS)
+    SOPT(OCTAL)
+    SOPT(PLAIN)
+    SOPT(PRINTING_ONLY)
+    SOPT(REVERSE)
+    SOPT(SKIP_BYTES)
+    SOPT(STRINGS)
+    SOPT(STRINGS_OPTS)
+    SOPT(TOTAL_MATCHES)
+    SOPT(TOTAL_MATCHES_ONLY)
+    SOPT(UTF8)
+    SOPT(UTF8_PADDING)
+    SOPT(VERBOSE)
+    SOPT(VERIFY)
+  );
+  opt_check_mutually_exclusive( SOPT(REPLACE),
+    SOPT(AGGREGATE)
+    SOPT(COLOR)
+    SOPT(C_ARRAY)
+    SOPT(DECIMAL)
+    SOPT(FOLLOWED_BY)
+    SOPT(GROUP_BY)
+    SOPT(HEXADECIMAL)
+    SOPT(IMAGE)
+    SOPT(INDEX)
+    SOPT(LAST)
+    SOPT(MATCHING_ONLY)
+    SOPT(MAX_BYTES)
+    SOPT(MAX_LINES)
+    SOPT(NO_ASCII)
+    SOPT(NO_OFFSETS)
+    SOPT(OCTAL)
+    SOPT(PLAIN)
+    SOPT(PRINTING_ONLY)
+    SOPT(REVERSE)
+    SOPT(SAMPLE)
+    SOPT(SKIP_BYTES)
+    SOPT(STRINGS)
+    SOPT(STRINGS_OPTS)
+    SOPT(TOTAL_MATCHES)
+    SOPT(TOTAL_MATCHES_ONLY)
+    SOPT(UTF8)
+    SOPT(UTF8_PADDING)
+    SOPT(VERBOSE)
+    SOPT(VERIFY)
+  );
+  opt_check_mutually_exclusive( SOPT(OUTPUT_COMPRESS),
+    SOPT(INDEX)
+    SOPT(REPLACE)
+    SOPT(REVERSE)
+    SOPT(VERIFY)
+  );
+  opt_check_mutually_exclusive( SOPT(SAMPLE),
+    SOPT(AGGREGATE)
+    SOPT(C_ARRAY)
+    SOPT(FOLLOWED_BY)
+    SOPT(IMAGE)
+    SOPT(INDEX)
+    SOPT(LAST)
+    SOPT(MAX_BYTES)
+    SOPT(MAX_LINES)
+    SOPT(REVERSE)
+    SOPT(STRINGS)
+    SOPT(STRINGS_OPTS)
+    SOPT(TOTAL_MATCHES)
+    SOPT(TOTAL_MATCHES_ONLY)
+    SOPT(VERIFY)
+  );
   opt_check_mutually_exclusive( SOPT(C_ARRAY),
+    SOPT(AGGREGATE)
     SOPT(BIG_ENDIAN)
     SOPT(COLOR)
+    SOPT(FOLLOWED_BY)
     SOPT(GROUP_BY)
     SOPT(IGNORE_CASE)
+    SOPT(LAST)
     SOPT(LITTLE_ENDIAN)
     SOPT(MATCHING_ONLY)
     SOPT(PRINTING_ONLY)
@@ -1146,17 +1898,18 @@ void options_init( int argc, char const *argv[] ) {
   );
   opt_check_mutually_exclusive( SOPT(OCTAL), SOPT(DECIMAL) SOPT(HEXADECIMAL) );
   opt_check_mutually_exclusive( SOPT(REVERSE),
+    SOPT(AGGREGATE)
     SOPT(BIG_ENDIAN)
     SOPT(BITS)
     SOPT(BYTES)
     SOPT(COLOR)
     SOPT(C_ARRAY)
+    SOPT(FOLLOWED_BY)
     SOPT(GROUP_BY)
     SOPT(IGNORE_CASE)
+    SOPT(LAST)
     SOPT(LITTLE_ENDIAN)
     SOPT(MATCHING_ONLY)
-    SOPT(MAX_BYTES)
-    SOPT(MAX_LINES)
     SOPT(NO_ASCII)
     SOPT(NO_OFFSETS)
     SOPT(PLAIN)
@@ -1168,7 +1921,23 @@ void options_init( int argc, char const *argv[] ) {
     SOPT(TOTAL_MATCHES_ONLY)
     SOPT(UTF8)
     SOPT(UTF8_PADDING)
-    SOPT(VERBOSE)
+  );
+  if ( !opts_given[ COPT(VERIFY) ] )    // -V means all mismatches for -X
+    opt_check_mutually_exclusive( SOPT(REVERSE), SOPT(VERBOSE) );
+  if ( !opts_given[ COPT(LINE_INDEX) ] )// -D means -N limits what's reversed
+    opt_check_mutually_exclusive( SOPT(REVERSE),
+      SOPT(MAX_BYTES) SOPT(MAX_LINES)
+    );
+  opt_check_mutually_exclusive( SOPT(LINE_INDEX),
+    SOPT(AGGREGATE)
+    SOPT(C_ARRAY)
+    SOPT(IMAGE)
+    SOPT(INDEX)
+    SOPT(OUTPUT_COMPRESS)
+    SOPT(REPLACE)
+    SOPT(SAMPLE)
+    SOPT(TOTAL_MATCHES_ONLY)
+    SOPT(VERIFY)
   );
   opt_check_mutually_exclusive( SOPT(TOTAL_MATCHES), SOPT(TOTAL_MATCHES_ONLY) );
   opt_check_mutually_exclusive( SOPT(STRINGS),
@@ -1176,20 +1945,92 @@ void options_init( int argc, char const *argv[] ) {
     SOPT(IGNORE_CASE)
     SOPT(STRING)
   );
+  opt_check_mutually_exclusive( SOPT(FOLLOWED_BY),
+    SOPT(LITTLE_ENDIAN) SOPT(BIG_ENDIAN) SOPT(HOST_ENDIAN)
+    SOPT(STRINGS) SOPT(STRINGS_OPTS)
+  );
+  opt_check_mutually_exclusive( SOPT(DETECT_RECORD),
+    SOPT(AGGREGATE)
+    SOPT(C_ARRAY)
+    SOPT(IMAGE)
+    SOPT(INDEX)
+    SOPT(MAX_LINES)
+    SOPT(REPLACE)
+    SOPT(REVERSE)
+    SOPT(SAMPLE)
+    SOPT(VERIFY)
+  );
+  if ( opt_record == RECORD_REPORT )    // only a dump can search
+    opt_check_mutually_exclusive( SOPT(DETECT_RECORD),
+      SOPT(BIG_ENDIAN)
+      SOPT(FLOAT)
+      SOPT(FOLLOWED_BY)
+      SOPT(HOST_ENDIAN)
+      SOPT(LAST)
+      SOPT(LINE_INDEX)
+      SOPT(LITTLE_ENDIAN)
+      SOPT(MATCHING_ONLY)
+      SOPT(STRING)
+      SOPT(STRINGS)
+      SOPT(TOTAL_MATCHES)
+      SOPT(TOTAL_MATCHES_ONLY)
+    );
+  opt_check_mutually_exclusive( SOPT(FLOAT),
+    SOPT(AGGREGATE)
+    SOPT(BIG_ENDIAN)
+    SOPT(C_ARRAY)
+    SOPT(FOLLOWED_BY)
+    SOPT(HOST_ENDIAN)
+    SOPT(IGNORE_CASE)
+    SOPT(IMAGE)
+    SOPT(INDEX)
+    SOPT(LAST)
+    SOPT(LITTLE_ENDIAN)
+    SOPT(REPLACE)
+    SOPT(REVERSE)
+    SOPT(SAMPLE)
+    SOPT(STRING)
+    SOPT(STRINGS)
+    SOPT(STRINGS_OPTS)
+  );
+  opt_check_mutually_exclusive( SOPT(LAST),
+    SOPT(FOLLOWED_BY)
+    SOPT(STRINGS) SOPT(STRINGS_OPTS)
+  );
 
   // check for options that require other options
+  opt_check_required( SOPT(AGGREGATE), SOPT(STRINGS) );
   opt_check_required( SOPT(BITS) SOPT(BYTES),
-    SOPT(BIG_ENDIAN) SOPT(LITTLE_ENDIAN)
+    SOPT(BIG_ENDIAN) SOPT(FLOAT) SOPT(LITTLE_ENDIAN)
   );
+  opt_check_required( SOPT(FOLLOWED_BY), SOPT(STRING) );
+  opt_check_required( SOPT(FOLLOWED_BY), SOPT(WITHIN) );
   opt_check_required( SOPT(IGNORE_CASE), SOPT(STRING) );
+  opt_check_required( SOPT(LAST),
+    SOPT(BIG_ENDIAN)
+    SOPT(HOST_ENDIAN)
+    SOPT(LITTLE_ENDIAN)
+    SOPT(STRING)
+  );
   opt_check_required(
     SOPT(MATCHING_ONLY) SOPT(TOTAL_MATCHES) SOPT(TOTAL_MATCHES_ONLY),
     SOPT(BIG_ENDIAN)
+    SOPT(BIT_ERRORS)
+    SOPT(FLOAT)
     SOPT(LITTLE_ENDIAN)
+    SOPT(NARROW)
     SOPT(STRING)
     SOPT(STRINGS)
   );
+  opt_check_required( SOPT(REPLACE),
+    SOPT(BIG_ENDIAN)
+    SOPT(HOST_ENDIAN)
+    SOPT(LITTLE_ENDIAN)
+    SOPT(STRING)
+  );
   opt_check_required( SOPT(UTF8_PADDING), SOPT(UTF8) );
+  opt_check_required( SOPT(VERIFY), SOPT(REVERSE) );
+  opt_check_required( SOPT(WITHIN), SOPT(FOLLOWED_BY) );
 
   if ( opt_help )
     print_usage( argc > 0 ? EX_USAGE : EX_OK );
@@ -1210,7 +2051,7 @@ void options_init( int argc, char const *argv[] ) {
         " must be a multiple of 8 in 8-64\n",
         size_in_bits, opt_format( COPT(BITS), opt_buf, sizeof opt_buf )
       );
-    opt_search_len = size_in_bits * 8;
+    opt_search_len = size_in_bits / 8;
     check_number_size(
       size_in_bits, int_len( search_number ) * 8, COPT(BITS)
     );
@@ -1228,8 +2069,20 @@ void options_init( int argc, char const *argv[] ) {
     );
   }
 
-  if ( opt_ignore_case )
+  if ( opt_followed_buf != NULL ) {
+    opt_followed_len = strlen( opt_followed_buf );
+    if ( opt_followed_len == 0 )
+      fatal_error( EX_USAGE,
+        "value for %s must not be empty\n",
+        opt_format( COPT(FOLLOWED_BY), opt_buf, sizeof opt_buf )
+      );
+  }
+
+  if ( opt_ignore_case ) {
     tolower_s( opt_search_buf );
+    if ( opt_followed_buf != NULL )
+      tolower_s( opt_followed_buf );
+  }
 
   if ( opt_group_by > row_bytes )
     row_bytes = opt_group_by;
@@ -1237,18 +2090,90 @@ void options_init( int argc, char const *argv[] ) {
   if ( max_lines > 0 )
     opt_max_bytes = max_lines * row_bytes;
 
+  if ( opt_address_map_path != NULL ) {
+    address_map_load();
+    off_t begin, end;
+    address_map_range( &begin, &end );
+    // With an address map, offsets to skip to are addresses.
+    if ( opts_given[ COPT(SKIP_BYTES) ] || skip_offset_given )
+      fin_offset = address_map_offset( STATIC_CAST( uint64_t, fin_offset ) );
+    else if ( fin_offset < begin )
+      fin_offset = begin;
+    size_t const mapped = fin_offset < end ?
+      STATIC_CAST( size_t, end - fin_offset ) : 0;
+    if ( mapped < opt_max_bytes )
+      opt_max_bytes = mapped;
+  }
+
+  if ( opt_calibrate_dir != NULL && argc > 0 ) {
+    fatal_error( EX_USAGE,
+      "\"%s\": files can not be given with %s\n",
+      argv[1], opt_format( COPT(CALIBRATE), opt_buf, sizeof opt_buf )
+    );
+  }
+
+  if ( opt_index_path != NULL ) {
+    // ad -I index [file...] builds; ad -I index -s string searches.
+    if ( argc > 0 &&
+         (opt_search_buf != NULL || opt_search_endian != ENDIAN_NONE) ) {
+      fatal_error( EX_USAGE,
+        "\"%s\": files can not be given when searching with %s\n",
+        argv[1], opt_format( COPT(INDEX), opt_buf, sizeof opt_buf )
+      );
+    }
+    opt_index_files = argv + 1;
+    opt_index_files_len = STATIC_CAST( size_t, argc );
+    argc = 0;
+  }
+
+  if ( opt_split && (argc == 0 || strcmp( argv[1], "-" ) == 0) ) {
+    fatal_error( EX_USAGE,
+      "%s requires the first part of infile be given\n",
+      opt_format( COPT(SPLIT), opt_buf, sizeof opt_buf )
+    );
+  }
+
   switch ( argc ) {
     case 2:                             // infile & outfile
-      if ( strcmp( argv[2], "-" ) != 0 ) {
+      if ( opt_verify_path != NULL ) {
+        fatal_error( EX_USAGE,
+          "\"%s\": outfile can not be given with %s\n",
+          argv[2], opt_format( COPT(VERIFY), opt_buf, sizeof opt_buf )
+        );
+      }
+      if ( opt_replace_buf != NULL && strcmp( argv[1], "-" ) != 0 ) {
+        struct stat in_stat, out_stat;
+        if ( stat( argv[1], &in_stat ) == 0 &&
+             stat( argv[2], &out_stat ) == 0 &&
+             in_stat.st_dev == out_stat.st_dev &&
+             in_stat.st_ino == out_stat.st_ino ) {
+          if ( !S_ISREG( in_stat.st_mode ) ) {
+            fatal_error( EX_USAGE,
+              "\"%s\": %s in place requires a regular file\n",
+              argv[1], opt_format( COPT(REPLACE), opt_buf, sizeof opt_buf )
+            );
+          }
+          opt_replace_in_place = true;  // infile & outfile are the same file
+        }
+      }
+      // When replacing in place, the input file itself is written to.
+      if ( !opt_replace_in_place && strcmp( argv[2], "-" ) != 0 ) {
         //
         // We can't use fopen(3) because there's no mode that specifies opening
         // a file for writing and NOT truncating it to zero length if it
         // exists.
         //
         // Hence we have to use open(2) so we can specify only O_WRONLY and
-        // O_CREAT but not O_TRUNC.
+        // O_CREAT but not O_TRUNC -- except when replacing since the output
+        // is then an entire patched copy of the input; or when compressing
+        // since a compressed stream can never be patched in place and any
+        // old bytes past its end would be trailing garbage.
         //
-        int const fd = open( argv[2], O_WRONLY | O_CREAT, 0644 );
+        bool const is_trunc =
+          opt_replace_buf != NULL || opt_output_compress > 0;
+        int const fd = open( argv[2],
+          O_WRONLY | O_CREAT | (is_trunc ? O_TRUNC : 0), 0644
+        );
         if ( fd == -1 )
           fatal_error( EX_CANTCREAT, "\"%s\": %s\n", argv[2], STRERROR() );
         DUP2( fd, STDOUT_FILENO );
@@ -1258,12 +2183,64 @@ void options_init( int argc, char const *argv[] ) {
 
     case 1:                             // infile only
       fin_path = argv[1];
-      if ( strcmp( fin_path, "-" ) != 0 && !freopen( fin_path, "r", stdin ) )
+      if ( opt_split )
+        input_split_open( fin_path );
+      else if ( strcmp( fin_path, "-" ) != 0 &&
+                !freopen( fin_path, "r", stdin ) ) {
         fatal_error( EX_NOINPUT, "\"%s\": %s\n", fin_path, STRERROR() );
+      }
       FALLTHROUGH;
 
     case 0:
-      fskip( fin_offset, stdin );
+      //
+      // The profile may set the number of jobs that later initializations
+      // size arrays by and the buffer size of fin, so load it before those
+      // and before any I/O on fin.
+      //
+      if ( opt_calibrate_dir == NULL )
+        profile_load();
+      if ( opt_snapshot )
+        snapshot_stdin();
+      if ( (opt_last || opt_image != IMAGE_NONE) && !input_is_file() ) {
+        fatal_error( EX_USAGE,
+          "\"%s\": %s requires a regular file\n",
+          fin_path,
+          opt_format(
+            opt_last ? COPT(LAST) : COPT(IMAGE), opt_buf, sizeof opt_buf
+          )
+        );
+      }
+      if ( opt_narrow != NARROW_NONE && !input_is_file() &&
+           lseek( STDIN_FILENO, 0, SEEK_CUR ) == -1 ) {
+        // Candidates are read again at their offsets via pread(2).
+        fatal_error( EX_USAGE,
+          "\"%s\": %s requires a seekable file\n",
+          fin_path, opt_format( COPT(NARROW), opt_buf, sizeof opt_buf )
+        );
+      }
+      if ( opt_line_index_path != NULL ) {
+        int const fd = opt_reverse ? STDIN_FILENO : STDOUT_FILENO;
+        if ( !fd_is_file( fd ) ) {
+          fatal_error( EX_USAGE,
+            "%s requires the dump be a regular file\n",
+            opt_format( COPT(LINE_INDEX), opt_buf, sizeof opt_buf )
+          );
+        }
+        // When reversing, the line index is used to seek to fin_offset.
+        if ( opt_reverse )
+          break;
+      }
+      if ( opt_sample > 0 ) {
+        // Sampled blocks are read via pread(2) so there's nothing to skip.
+        if ( input_size() == -1 ) {
+          fatal_error( EX_USAGE,
+            "\"%s\": %s requires a regular file or block device\n",
+            fin_path, opt_format( COPT(SAMPLE), opt_buf, sizeof opt_buf )
+          );
+        }
+        break;
+      }
+      fskip( fin_offset, fin );
       break;
 
     default:
@@ -1275,6 +2252,28 @@ void options_init( int argc, char const *argv[] ) {
       // searching for a string
       opt_search_len = strlen( opt_search_buf );
     }
+    else if ( opt_float ) {
+      // searching for a floating-point number
+      if ( opt_search_len == 0 )
+        opt_search_len = sizeof( double );
+      if ( opt_search_len == sizeof( float ) ) {
+        float const f = STATIC_CAST( float, opt_float_value );
+        uint32_t bits;
+        memcpy( &bits, &f, sizeof bits );
+        search_number = bits;
+      }
+      else if ( opt_search_len == sizeof( double ) ) {
+        memcpy( &search_number, &opt_float_value, sizeof search_number );
+      }
+      else {
+        fatal_error( EX_USAGE,
+          "%zu: invalid number size for %s; must be 4 or 8 bytes\n",
+          opt_search_len, opt_format( COPT(FLOAT), opt_buf, sizeof opt_buf )
+        );
+      }
+      int_rearrange_bytes( &search_number, opt_search_len, opt_search_endian );
+      opt_search_buf = POINTER_CAST( char*, &search_number );
+    }
     else if ( opt_search_endian != ENDIAN_NONE ) {
       // searching for a number
       if ( opt_search_len == 0 )        // default to smallest possible size
@@ -1284,6 +2283,74 @@ void options_init( int argc, char const *argv[] ) {
     }
   }
 
+  if ( opt_narrow == NARROW_EQUAL && opt_search_endian == ENDIAN_NONE ) {
+    fatal_error( EX_USAGE,
+      "%s requires a number to narrow by\n",
+      opt_format( COPT(NARROW), opt_buf, sizeof opt_buf )
+    );
+  }
+  if ( opt_narrow > NARROW_EQUAL && opt_search_endian != ENDIAN_NONE ) {
+    fatal_error( EX_USAGE,
+      "\"%s\": number can not be given with how for %s\n",
+      opt_narrow_path, opt_format( COPT(NARROW), opt_buf, sizeof opt_buf )
+    );
+  }
+
+  if ( opt_output_compress > 0 ) {
+#if defined(HAVE_ZLIB_H) && (defined(HAVE_FOPENCOOKIE) || defined(HAVE_FUNOPEN))
+    if ( isatty( STDOUT_FILENO ) ) {
+      fatal_error( EX_USAGE,
+        "compressed output can not be written to a terminal for %s\n",
+        opt_format( COPT(OUTPUT_COMPRESS), opt_buf, sizeof opt_buf )
+      );
+    }
+#else
+    fatal_error( EX_UNAVAILABLE,
+      "%s is not supported on this platform\n",
+      opt_format( COPT(OUTPUT_COMPRESS), opt_buf, sizeof opt_buf )
+    );
+#endif
+  }
+
+  if ( opt_replace_buf != NULL ) {
+    if ( opt_search_len == 0 ) {
+      fatal_error( EX_USAGE,
+        "value for %s must not be empty\n",
+        opt_format( COPT(STRING), opt_buf, sizeof opt_buf )
+      );
+    }
+    if ( fin_offset != 0 ) {
+      fatal_error( EX_USAGE,
+        "offset can not be given with %s\n",
+        opt_format( COPT(REPLACE), opt_buf, sizeof opt_buf )
+      );
+    }
+    if ( opt_search_endian != ENDIAN_NONE ) {
+      replace_number = STATIC_CAST( uint64_t, parse_ull( opt_replace_buf ) );
+      if ( int_len( replace_number ) > opt_search_len ) {
+        fatal_error( EX_USAGE,
+          "\"%s\": value for %s must fit in %zu bytes\n",
+          opt_replace_buf,
+          opt_format( COPT(REPLACE), opt_buf, sizeof opt_buf ),
+          opt_search_len
+        );
+      }
+      int_rearrange_bytes(
+        &replace_number, opt_search_len, opt_search_endian
+      );
+      opt_replace_buf = POINTER_CAST( char const*, &replace_number );
+    }
+    else if ( strlen( opt_replace_buf ) != opt_search_len ) {
+      fatal_error( EX_USAGE,
+        "\"%s\": value for %s must be %zu bytes long like the search"
+        " string\n",
+        opt_replace_buf,
+        opt_format( COPT(REPLACE), opt_buf, sizeof opt_buf ),
+        opt_search_len
+      );
+    }
+  }
+
   if ( opt_max_bytes == 0 )             // degenerate case
     exit( opt_search_len > 0 ? EX_NO_MATCHES : EX_OK );
 
@@ -1318,6 +2385,40 @@ missing_arg:
   );
 }
 
+char const* options_normalized( size_t *plen ) {
+  assert( plen != NULL );
+  // Options that affect only how, not what, is output.
+  static char const NOT_NORMALIZED[] = SOPT(CACHE) SOPT(JOBS);
+
+  char *normalized = NULL;
+  size_t len = 0;
+  for ( int pass = 1; pass <= 2; ++pass ) {
+    len = 0;
+    for ( unsigned opt = 0; opt < ARRAY_SIZE( opts_given ); ++opt ) {
+      if ( !opts_given[ opt ] ||
+           strchr( NOT_NORMALIZED, STATIC_CAST( int, opt ) ) != NULL ) {
+        continue;
+      }
+      if ( normalized != NULL ) {
+        normalized[ len     ] = STATIC_CAST( char, opt );
+        normalized[ len + 1 ] = '\0';
+      }
+      len += 2;
+      if ( opts_arg[ opt ] != NULL ) {
+        size_t const arg_size = strlen( opts_arg[ opt ] ) + 1;
+        if ( normalized != NULL )
+          memcpy( normalized + len, opts_arg[ opt ], arg_size );
+        len += arg_size;
+      }
+    } // for
+    if ( normalized == NULL )
+      normalized = free_later( MALLOC( char, len + 1 ) );
+  } // for
+
+  *plen = len;
+  return normalized;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 /** @} */
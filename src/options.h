@@ -39,6 +39,63 @@
 #include <stddef.h>                     /* for size_t */
 #include <stdint.h>                     /* for uint64_t */
 
+// in ascending option character ASCII order; sort using: sort -bdfk3
+#define OPT_AGGREGATE           a
+#define OPT_NO_ASCII            A
+#define OPT_BITS                b
+#define OPT_BYTES               B
+#define OPT_CACHE               Y
+#define OPT_COLOR               c
+#define OPT_C_ARRAY             C
+#define OPT_DECIMAL             d
+#define OPT_LINE_INDEX          D
+#define OPT_DETECT_RECORD       w
+#define OPT_BIG_ENDIAN          E
+#define OPT_LITTLE_ENDIAN       e
+#define OPT_FLOAT               f
+#define OPT_FOLLOWED_BY         F
+#define OPT_IMAGE               G
+#define OPT_GROUP_BY            g
+#define OPT_HELP                h
+#define OPT_HOST_ENDIAN         H
+#define OPT_IGNORE_CASE         i
+#define OPT_INDEX               I
+#define OPT_SKIP_BYTES          j
+#define OPT_JOBS                J
+#define OPT_SNAPSHOT            k
+#define OPT_CALIBRATE           K
+#define OPT_LAST                l
+#define OPT_MAX_LINES           L
+#define OPT_MATCHING_ONLY       m
+#define OPT_ADDRESS_MAP         M
+#define OPT_STRINGS             n
+#define OPT_MAX_BYTES           N
+#define OPT_NO_OFFSETS          O
+#define OPT_OCTAL               o
+#define OPT_PRINTING_ONLY       p
+#define OPT_PLAIN               P
+#define OPT_NARROW              q
+#define OPT_SAMPLE              Q
+#define OPT_REVERSE             r
+#define OPT_REPLACE             R
+#define OPT_STRING              s
+#define OPT_STRINGS_OPTS        S
+#define OPT_TOTAL_MATCHES       t
+#define OPT_TOTAL_MATCHES_ONLY  T
+#define OPT_UTF8                u
+#define OPT_UTF8_PADDING        U
+#define OPT_VERSION             v
+#define OPT_VERBOSE             V
+#define OPT_WITHIN              W
+#define OPT_VERIFY              X
+#define OPT_HEXADECIMAL         x
+#define OPT_BIT_ERRORS          y
+#define OPT_SPLIT               z
+#define OPT_OUTPUT_COMPRESS     Z
+
+/// Command-line option character as a character literal.
+#define COPT(X)                   CHARIFY(OPT_##X)
+
 /// @endcond
 
 /**
@@ -49,6 +106,28 @@
 
 ///////////////////////////////////////////////////////////////////////////////
 
+#define OPT_BUF_SIZE        32          /**< Maximum size for an option. */
+
+/**
+ * Unique strings report sort orders.
+ */
+enum ad_aggregate {
+  AGGREGATE_NONE,                       ///< Don't aggregate strings.
+  AGGREGATE_COUNT,                      ///< Sort by descending count.
+  AGGREGATE_OFFSET                      ///< Sort by ascending first offset.
+};
+typedef enum ad_aggregate ad_aggregate_t;
+
+/**
+ * What to key cached results by for \c --cache.
+ */
+enum ad_cache {
+  CACHE_NONE,                           ///< Don't cache.
+  CACHE_STAT,                           ///< Key by device, inode, size, mtime.
+  CACHE_CONTENT                         ///< Key by a hash of the content.
+};
+typedef enum ad_cache ad_cache_t;
+
 /**
  * C array dump formats.
  */
@@ -82,6 +161,16 @@ typedef enum ad_c_array ad_c_array_t;
 #define C_ARRAY_LEN_ANY_INT       ( C_ARRAY_LEN_INT | C_ARRAY_LEN_LONG \
                                   | C_ARRAY_LEN_UNSIGNED )
 
+/**
+ * Image formats for \c --image.
+ */
+enum ad_image {
+  IMAGE_NONE,                           ///< No image.
+  IMAGE_PPM,                            ///< Netpbm PPM image.
+  IMAGE_PNG                             ///< PNG image.
+};
+typedef enum ad_image ad_image_t;
+
 /**
  * Whether to print the total number of matches.
  */
@@ -92,6 +181,19 @@ enum ad_matches {
 };
 typedef enum ad_matches ad_matches_t;
 
+/**
+ * How to narrow candidates for \c --narrow.
+ */
+enum ad_narrow {
+  NARROW_NONE,                          ///< Don't narrow.
+  NARROW_EQUAL,                         ///< Keep those equal to the number.
+  NARROW_CHANGED,                       ///< Keep those that changed.
+  NARROW_UNCHANGED,                     ///< Keep those that didn't change.
+  NARROW_INCREASED,                     ///< Keep those that increased.
+  NARROW_DECREASED                      ///< Keep those that decreased.
+};
+typedef enum ad_narrow ad_narrow_t;
+
 /**
  * Offset formats.
  */
@@ -103,6 +205,16 @@ enum ad_offsets {
 };
 typedef enum ad_offsets ad_offsets_t;
 
+/**
+ * What to do with the detected record length for \c --detect-record.
+ */
+enum ad_record {
+  RECORD_NONE,                          ///< Don't detect record length.
+  RECORD_REPORT,                        ///< Report likely record lengths.
+  RECORD_DUMP                           ///< Dump using the record length.
+};
+typedef enum ad_record ad_record_t;
+
 /**
  * Options for **strings**(1)-like searches.
  */
@@ -120,17 +232,91 @@ typedef enum ad_strings ad_strings_t;
 
 ////////// extern variables ///////////////////////////////////////////////////
 
+extern char const    *opt_address_map_path; ///< Address map file, if any.
+extern ad_aggregate_t opt_aggregate;    ///< Aggregate strings sorted by this.
+extern bool           opt_bit_errors;   ///< Report bit errors?
+extern size_t         opt_bit_errors_block; ///< Bytes per bit-error block.
+
+/**
+ * The fill pattern to count bit errors against, if any; it repeats from
+ * offset 0 of the input.
+ *
+ * @sa opt_bit_errors_fill_len
+ * @sa opt_bit_errors_path
+ */
+extern char8_t const *opt_bit_errors_fill;
+
+extern size_t         opt_bit_errors_fill_len; ///< Bytes in fill pattern.
+extern char const    *opt_bit_errors_path;  ///< Reference file, if any.
 extern ad_c_array_t   opt_c_array;      ///< Dump as C array in this format.
+extern ad_cache_t     opt_cache;        ///< What to key cached results by.
+extern char const    *opt_calibrate_dir; ///< Calibrate in this directory.
 extern color_when_t   opt_color_when;   ///< When to colorize output.
 extern bool           opt_dump_ascii;   ///< Dump ASCII part?
+extern bool           opt_float;        ///< Floating-point search?
+extern bool           opt_float_aligned;///< Match floats only when aligned?
+
+/**
+ * The tolerance of a floating-point search: either an absolute difference from
+ * \ref opt_float_value or, if \ref opt_float_ulps, a number of units in the
+ * last place.
+ */
+extern double         opt_float_tolerance;
+
+extern bool           opt_float_ulps;   ///< Tolerance is in ULPs?
+extern double         opt_float_value;  ///< Floating-point value to search for.
+
+/**
+ * The string that must follow \ref opt_search_buf within \ref opt_within
+ * bytes for a proximity search, if any.
+ *
+ * @sa opt_followed_len
+ */
+extern char          *opt_followed_buf;
+
+extern size_t         opt_followed_len; ///< Bytes in \ref opt_followed_buf.
 extern unsigned       opt_group_by;     ///< Group by this number of bytes.
 extern bool           opt_ignore_case;  ///< Case-insensitive matching?
+extern ad_image_t     opt_image;        ///< Image format to output, if any.
+extern bool           opt_image_entropy;///< Color image pixels by entropy?
+extern unsigned       opt_image_width;  ///< Image width in pixels.
+
+/**
+ * The files to add to the index \ref opt_index_path, if any.  A path of `-`
+ * means to read paths, one per line, from standard input.
+ *
+ * @sa opt_index_files_len
+ */
+extern char const *const *opt_index_files;
+
+extern size_t         opt_index_files_len;  ///< Length of \ref opt_index_files.
+extern char const    *opt_index_path;   ///< Corpus index file path, if any.
+extern unsigned       opt_jobs;         ///< Parallel jobs; 0 = automatic.
+extern bool           opt_jobs_pin;     ///< Pin parallel jobs to CPUs?
+extern bool           opt_last;         ///< Search for last match only?
+extern char const    *opt_line_index_path;  ///< Line index file path, if any.
 extern size_t         opt_max_bytes;    ///< Maximum number of bytes to dump.
 extern ad_matches_t   opt_matches;      ///< When to print total matches.
+extern ad_narrow_t    opt_narrow;       ///< How to narrow candidates, if at all.
+extern char const    *opt_narrow_path;  ///< Candidates file path, if any.
 extern ad_offsets_t   opt_offsets;      ///< Dump offsets in this format.
 extern bool           opt_only_matching;///< Only dump matching rows?
 extern bool           opt_only_printing;///< Only dump printable rows?
+extern unsigned       opt_output_compress;///< Compression level or 0 for none.
+
+/**
+ * The bytes to replace each match of \ref opt_search_buf with, if any; the
+ * number of bytes is \ref opt_search_len.
+ *
+ * @sa opt_replace_in_place
+ */
+extern char const    *opt_replace_buf;
+
+extern bool           opt_replace_in_place; ///< Replace in the input file?
+extern ad_record_t    opt_record;       ///< Detect record length?
 extern bool           opt_reverse;      ///< Reverse dump (patch)?
+extern double         opt_sample;       ///< Percent of blocks to sample or 0.
+extern bool           opt_sample_random;///< Sample random blocks in strides?
 
 /**
  * The bytes of what to search for, if any.
@@ -139,6 +325,8 @@ extern bool           opt_reverse;      ///< Reverse dump (patch)?
  * + A specific string: this points to the null-terminated string.
  * + Any string: not used.
  * + A number: this points to \ref search_number.
+ * + A floating-point number: this points to \ref search_number containing
+ *   the bytes of \ref opt_float_value.
  *
  * @sa opt_search_len
  */
@@ -146,12 +334,16 @@ extern char          *opt_search_buf;
 
 extern endian_t       opt_search_endian;///< Numeric search endianness.
 extern size_t         opt_search_len;   ///< Bytes in \ref opt_search_buf.
+extern bool           opt_snapshot;     ///< Dump a clone of the input?
+extern bool           opt_split;        ///< Read input split into parts?
 
 extern bool           opt_strings;      ///< **strings**(1)-like search?
 extern ad_strings_t   opt_strings_opts; ///< **strings**(1)-like options.
 extern bool           opt_utf8;         ///< Dump as UTF-8?
 extern char8_t const *opt_utf8_pad;     ///< UTF-8 padding character.
 extern bool           opt_verbose;      ///< Dump _all_ rows of data?
+extern char const    *opt_verify_path;  ///< File to verify dump against.
+extern size_t         opt_within;       ///< Max bytes for proximity search.
 
 ////////// extern functions ///////////////////////////////////////////////////
 
@@ -183,6 +375,19 @@ char const* get_offsets_format( void );
 NODISCARD
 unsigned get_offsets_width( void );
 
+/**
+ * Formats an option as `--long/-s` (or just `-s` if it has no long option)
+ * for use in messages.
+ *
+ * @param short_opt The short option (along with its corresponding long option,
+ * if any) to format.
+ * @param buf The buffer to use; it should be at least #OPT_BUF_SIZE bytes.
+ * @param size The size of \a buf.
+ * @return Returns \a buf.
+ */
+NODISCARD
+char const* opt_format( char short_opt, char buf[const], size_t size );
+
 /**
  * Initializes **ad** options from the command-line.
  *
@@ -193,6 +398,18 @@ unsigned get_offsets_width( void );
  */
 void options_init( int argc, char const *argv[] );
 
+/**
+ * Gets the options that were given in a normal form so the same options given
+ * in a different order or in long or short form compare equal.
+ *
+ * @param plen A pointer to receive the length of the normal form.
+ * @return Returns a string of each option given, in option character order,
+ * followed by its last argument, if any, each terminated by a null byte.
+ * Options that affect only how, not what, is output are excluded.
+ */
+NODISCARD
+char const* options_normalized( size_t *plen );
+
 ///////////////////////////////////////////////////////////////////////////////
 
 /** @} */
@@ -0,0 +1,109 @@
+/*
+**      ad -- ASCII dump
+**      src/output.c
+**
+**      Copyright (C) 2024  Paul J. Lucas
+**
+**      This program is free software: you can redistribute it and/or modify
+**      it under the terms of the GNU General Public License as published by
+**      the Free Software Foundation, either version 3 of the License, or
+**      (at your option) any later version.
+**
+**      This program is distributed in the hope that it will be useful,
+**      but WITHOUT ANY WARRANTY; without even the implied warranty of
+**      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**      GNU General Public License for more details.
+**
+**      You should have received a copy of the GNU General Public License
+**      along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * Defines functions for writing output to a regular file efficiently.
+ */
+
+// local
+#include "pjl_config.h"                 /* must go first */
+#include "ad.h"
+#include "options.h"
+#include "output.h"
+#include "util.h"
+
+/// @cond DOXYGEN_IGNORE
+
+// standard
+#include <fcntl.h>                      /* for fallocate(2) */
+#include <stdbool.h>
+#include <stdio.h>
+#include <sys/stat.h>                   /* for fstat(2) */
+#include <sys/types.h>                  /* for off_t */
+#include <sysexits.h>
+#include <unistd.h>                     /* for ftruncate(2), lseek(2) */
+
+/// @endcond
+
+/**
+ * @addtogroup output-group
+ * @{
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+
+#define OUTPUT_BUF_SIZE     (1024 * 1024u)      /**< Output buffer size.    */
+#define OUTPUT_RESERVE_MAX  (64 * 1024 * 1024)  /**< Max. bytes reserved.   */
+
+// extern variable definitions
+FILE *fout;
+
+static bool output_is_file;             ///< Is stdout a regular file?
+static bool output_reserved;            ///< Was space reserved?
+
+////////// extern functions ///////////////////////////////////////////////////
+
+void output_cleanup( void ) {
+  if ( !output_reserved )
+    return;
+  output_reserved = false;
+  if ( fflush( fout ) != 0 )
+    return;
+  //
+  // Truncating a file to its own size releases the blocks reserved past its
+  // end.
+  //
+  struct stat out_stat;
+  if ( fstat( STDOUT_FILENO, &out_stat ) == 0 &&
+       ftruncate( STDOUT_FILENO, out_stat.st_size ) != 0 ) {
+    // ignore: the file is correct regardless
+  }
+}
+
+void output_init( void ) {
+  if ( opt_output_compress > 0 || !fd_is_file( STDOUT_FILENO ) )
+    return;
+  output_is_file = true;
+  PERROR_EXIT_IF(
+    setvbuf( fout, NULL, _IOFBF, OUTPUT_BUF_SIZE ) != 0, EX_OSERR
+  );
+}
+
+void output_reserve( off_t size ) {
+  if ( !output_is_file || size <= 0 )
+    return;
+  if ( size > OUTPUT_RESERVE_MAX )
+    size = OUTPUT_RESERVE_MAX;
+#ifdef HAVE_FALLOCATE
+  off_t const offset = lseek( STDOUT_FILENO, 0, SEEK_CUR );
+  if ( offset == -1 )
+    return;
+  output_reserved = fallocate(
+    STDOUT_FILENO, FALLOC_FL_KEEP_SIZE, offset, size
+  ) == 0;
+#endif /* HAVE_FALLOCATE */
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/** @} */
+
+/* vim:set et sw=2 ts=2: */
@@ -0,0 +1,86 @@
+/*
+**      ad -- ASCII dump
+**      src/output.h
+**
+**      Copyright (C) 2024  Paul J. Lucas
+**
+**      This program is free software: you can redistribute it and/or modify
+**      it under the terms of the GNU General Public License as published by
+**      the Free Software Foundation, either version 3 of the License, or
+**      (at your option) any later version.
+**
+**      This program is distributed in the hope that it will be useful,
+**      but WITHOUT ANY WARRANTY; without even the implied warranty of
+**      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**      GNU General Public License for more details.
+**
+**      You should have received a copy of the GNU General Public License
+**      along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ad_output_H
+#define ad_output_H
+
+/**
+ * @file
+ * Declares functions for writing output to a regular file efficiently.
+ */
+
+// local
+#include "pjl_config.h"                 /* must go first */
+
+/// @cond DOXYGEN_IGNORE
+
+// standard
+#include <sys/types.h>                  /* for off_t */
+
+/// @endcond
+
+/**
+ * @defgroup output-group Output
+ * Functions for writing output to a regular file efficiently.
+ *
+ * @remarks All output is written to \ref fout: standard output or, if
+ * compressing, a stream that compresses into standard output.
+ *
+ * When standard output is a regular file, it's fully buffered with a large
+ * buffer so it's written in few large chunks.  Callers that can estimate the
+ * size of their output may also reserve space up front so the file system can
+ * allocate it contiguously; whatever of the reservation is unused is released
+ * when done.
+ * @{
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Releases any unused space reserved by output_reserve().
+ */
+void output_cleanup( void );
+
+/**
+ * Initializes output: if standard output is a regular file, makes it fully
+ * buffered with a large buffer.
+ */
+void output_init( void );
+
+/**
+ * Reserves space for output, if it's a regular file, so the file system can
+ * allocate it contiguously.
+ *
+ * @remarks The reservation doesn't change the size of the file, so it's only
+ * a hint: if it's too large, the excess is released by output_cleanup(); if
+ * it's too small, the file merely grows as usual.
+ *
+ * @param size The estimated number of bytes of output.  At most 64 MiB are
+ * reserved to bound the space left allocated past the end of the file should
+ * the process be killed before output_cleanup().
+ */
+void output_reserve( off_t size );
+
+///////////////////////////////////////////////////////////////////////////////
+
+/** @} */
+
+#endif /* ad_output_H */
+/* vim:set et sw=2 ts=2: */
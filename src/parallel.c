@@ -0,0 +1,503 @@
+/*
+**      ad -- ASCII dump
+**      src/parallel.c
+**
+**      Copyright (C) 2024  Paul J. Lucas
+**
+**      This program is free software: you can redistribute it and/or modify
+**      it under the terms of the GNU General Public License as published by
+**      the Free Software Foundation, either version 3 of the License, or
+**      (at your option) any later version.
+**
+**      This program is distributed in the hope that it will be useful,
+**      but WITHOUT ANY WARRANTY; without even the implied warranty of
+**      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**      GNU General Public License for more details.
+**
+**      You should have received a copy of the GNU General Public License
+**      along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * Defines functions for the parallel execution runtime.
+ */
+
+// local
+#include "pjl_config.h"                 /* must go first */
+#include "ad.h"
+#include "options.h"
+#include "parallel.h"
+#include "util.h"
+
+/// @cond DOXYGEN_IGNORE
+
+// standard
+#include <assert.h>
+#include <ctype.h>                      /* for isdigit() */
+#include <stdbool.h>
+#include <stdio.h>                      /* for fopen(), snprintf() */
+#include <stdlib.h>                     /* for strtoull() */
+#include <string.h>                     /* for str...() */
+#include <unistd.h>                     /* for sysconf() */
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif /* HAVE_PTHREAD_H */
+#ifdef HAVE_SCHED_H
+#include <sched.h>                      /* for sched_getaffinity() */
+#endif /* HAVE_SCHED_H */
+
+/// @endcond
+
+/**
+ * @addtogroup parallel-group
+ * @{
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+
+#define CGROUP_ROOT         "/sys/fs/cgroup"  /**< Where cgroups are mounted. */
+#define CPU_CACHE_DIR       "/sys/devices/system/cpu/cpu0/cache"
+                                        /**< Where CPU cache info is. */
+
+#if defined(HAVE_PTHREAD_H) && defined(HAVE_SCHED_GETAFFINITY) \
+ && defined(HAVE_PTHREAD_SETAFFINITY_NP)
+# define PAR_CAN_PIN        1           /**< Can workers be pinned? */
+#else
+# define PAR_CAN_PIN        0
+#endif
+
+#ifdef HAVE_PTHREAD_H
+/**
+ * Thread pool state.  Worker 0 is always the thread that calls par_for();
+ * workers 1 through _jobs_-1 are threads that wait for work.
+ */
+struct par_pool {
+  pthread_t      *threads;              ///< Worker threads 1 through _jobs_-1.
+  pthread_mutex_t mutex;                ///< Protects all members below.
+  pthread_cond_t  work_cv;              ///< Signaled when there's new work.
+  pthread_cond_t  done_cv;              ///< Signaled when work is done.
+  unsigned        generation;           ///< Incremented for each par_for().
+  par_task_fn_t   fn;                   ///< Function to call for each task.
+  void           *data;                 ///< Data to pass to \ref fn.
+  size_t          n_tasks;              ///< Number of tasks.
+  size_t          next_task;            ///< Next task to run.
+  unsigned        busy;                 ///< Workers still working.
+  bool            stop;                 ///< Should workers stop?
+};
+typedef struct par_pool par_pool_t;
+
+/**
+ * Data passed to each worker thread.
+ */
+struct par_worker {
+  par_pool_t *pool;                     ///< The pool the worker belongs to.
+  unsigned    worker;                   ///< The worker number.
+};
+typedef struct par_worker par_worker_t;
+
+// local variable definitions
+static par_pool_t   pool;               ///< The one and only thread pool.
+static par_worker_t *workers;           ///< Per-worker thread data.
+#endif /* HAVE_PTHREAD_H */
+
+static size_t       chunk_size;         ///< Chunk size; 0 = uninitialized.
+static unsigned     jobs;               ///< Number of jobs; 0 = uninitialized.
+
+#if PAR_CAN_PIN
+static cpu_set_t    cpus_allowed;       ///< CPUs we're allowed to run on.
+#endif /* PAR_CAN_PIN */
+
+////////// local functions ////////////////////////////////////////////////////
+
+/**
+ * Reads the first line of a small file, typically in `/proc` or `/sys`.
+ *
+ * @param path The path of the file to read.
+ * @param buf The buffer to read into.
+ * @param size The size of \a buf.
+ * @return Returns `true` only if a line was read.
+ */
+NODISCARD
+static bool read_first_line( char const *path, char *buf, size_t size ) {
+  FILE *const f = fopen( path, "r" );
+  if ( f == NULL )
+    return false;
+  bool const ok = fgets( buf, STATIC_CAST( int, size ), f ) != NULL;
+  fclose( f );
+  if ( ok )
+    buf[ strcspn( buf, "\n" ) ] = '\0';
+  return ok;
+}
+
+/**
+ * Gets the size of a CPU cache from `sysfs`.
+ *
+ * @param level The cache level, e.g., 2 for L2.
+ * @return Returns the size of the data (or unified) cache in bytes or 0 if
+ * unknown.
+ */
+NODISCARD
+static size_t cpu_cache_size_sysfs( unsigned level ) {
+  for ( unsigned index = 0; index < 8; ++index ) {
+    char path[ 128 ], buf[ 32 ];
+
+    snprintf( path, sizeof path, CPU_CACHE_DIR "/index%u/level", index );
+    if ( !read_first_line( path, buf, sizeof buf ) )
+      break;
+    if ( strtoull( buf, NULL, 10 ) != level )
+      continue;
+    snprintf( path, sizeof path, CPU_CACHE_DIR "/index%u/type", index );
+    if ( read_first_line( path, buf, sizeof buf ) &&
+         strcmp( buf, "Instruction" ) == 0 ) {
+      continue;
+    }
+    snprintf( path, sizeof path, CPU_CACHE_DIR "/index%u/size", index );
+    if ( !read_first_line( path, buf, sizeof buf ) )
+      break;
+    char *end;
+    size_t size = STATIC_CAST( size_t, strtoull( buf, &end, 10 ) );
+    switch ( *end ) {
+      case 'K': size *= 1024;        break;
+      case 'M': size *= 1024 * 1024; break;
+    } // switch
+    return size;
+  } // for
+  return 0;
+}
+
+/**
+ * Gets the size of a CPU cache.
+ *
+ * @param level The cache level: either 2 or 3.
+ * @return Returns the size of the cache in bytes or 0 if unknown.
+ */
+NODISCARD
+static size_t cpu_cache_size( unsigned level ) {
+  assert( level == 2 || level == 3 );
+#if defined(_SC_LEVEL2_CACHE_SIZE) && defined(_SC_LEVEL3_CACHE_SIZE)
+  long const size = sysconf(
+    level == 2 ? _SC_LEVEL2_CACHE_SIZE : _SC_LEVEL3_CACHE_SIZE
+  );
+  if ( size > 0 )
+    return STATIC_CAST( size_t, size );
+#endif /* _SC_LEVEL2_CACHE_SIZE && _SC_LEVEL3_CACHE_SIZE */
+  return cpu_cache_size_sysfs( level );
+}
+
+/**
+ * Parses a cgroup CPU quota and period into a number of CPUs.
+ *
+ * @param quota The quota string: either an integer or `max` (no quota).
+ * @param period The period string.
+ * @return Returns the quota as a number of CPUs rounded up or 0 if none.
+ */
+NODISCARD
+static unsigned cgroup_quota_cpus( char const *quota, char const *period ) {
+  if ( quota[0] == '-' || !isdigit( quota[0] ) )
+    return 0;                           // "-1" (v1) or "max" (v2): no quota
+  unsigned long long const q = strtoull( quota, NULL, 10 );
+  unsigned long long const p = strtoull( period, NULL, 10 );
+  if ( q == 0 || p == 0 )
+    return 0;
+  return STATIC_CAST( unsigned, (q + p - 1) / p );
+}
+
+/**
+ * Gets the number of CPUs the cgroup this process is in is limited to.
+ *
+ * @return Returns said number or 0 if there is no limit.
+ */
+NODISCARD
+static unsigned cgroup_cpus( void ) {
+  char buf[ 256 ], path[ 512 ] = "";
+
+  // cgroup v2: the line in /proc/self/cgroup is of the form "0::/path".
+  FILE *const f = fopen( "/proc/self/cgroup", "r" );
+  if ( f != NULL ) {
+    while ( fgets( buf, sizeof buf, f ) != NULL ) {
+      if ( strncmp( buf, "0::", 3 ) != 0 )
+        continue;
+      buf[ strcspn( buf, "\n" ) ] = '\0';
+      snprintf( path, sizeof path, CGROUP_ROOT "%s/cpu.max", buf + 3 );
+      break;
+    } // while
+    fclose( f );
+  }
+
+  char const *const CPU_MAX_PATHS[] = {
+    path,                               // our own cgroup (if found above)
+    CGROUP_ROOT "/cpu.max",             // container's root cgroup
+  };
+
+  FOREACH_ARRAY_ELEMENT( char const*, cpu_max_path, CPU_MAX_PATHS ) {
+    if ( (*cpu_max_path)[0] == '\0' ||
+         !read_first_line( *cpu_max_path, buf, sizeof buf ) ) {
+      continue;
+    }
+    char *period = strchr( buf, ' ' );
+    if ( period == NULL )
+      continue;
+    *period++ = '\0';
+    return cgroup_quota_cpus( buf, period );
+  } // for
+
+  // cgroup v1
+  char period[ 32 ];
+  if ( read_first_line( CGROUP_ROOT "/cpu/cpu.cfs_quota_us",
+                        buf, sizeof buf ) &&
+       read_first_line( CGROUP_ROOT "/cpu/cpu.cfs_period_us",
+                        period, sizeof period ) ) {
+    return cgroup_quota_cpus( buf, period );
+  }
+
+  return 0;
+}
+
+/**
+ * Gets the number of CPUs this process is allowed to run on.
+ *
+ * @return Returns said number; always at least 1.
+ */
+NODISCARD
+static unsigned cpus_online( void ) {
+#ifdef HAVE_SCHED_GETAFFINITY
+  cpu_set_t set;
+  CPU_ZERO( &set );
+  if ( sched_getaffinity( 0, sizeof set, &set ) == 0 ) {
+#if PAR_CAN_PIN
+    cpus_allowed = set;
+#endif /* PAR_CAN_PIN */
+    int const n = CPU_COUNT( &set );
+    if ( n > 0 )
+      return STATIC_CAST( unsigned, n );
+  }
+#endif /* HAVE_SCHED_GETAFFINITY */
+  long const n = sysconf( _SC_NPROCESSORS_ONLN );
+  return n > 0 ? STATIC_CAST( unsigned, n ) : 1;
+}
+
+/**
+ * Clamps a chunk size to [#PAR_CHUNK_SIZE_MIN, #PAR_CHUNK_SIZE_MAX] and rounds
+ * it down to a multiple of the page size.
+ *
+ * @param size The chunk size to clamp.
+ * @return Returns the clamped chunk size.
+ */
+NODISCARD
+static size_t par_clamp_chunk_size( size_t size ) {
+  if ( size < PAR_CHUNK_SIZE_MIN )
+    size = PAR_CHUNK_SIZE_MIN;
+  else if ( size > PAR_CHUNK_SIZE_MAX )
+    size = PAR_CHUNK_SIZE_MAX;
+  long const page_size = sysconf( _SC_PAGESIZE );
+  if ( page_size > 0 )
+    size -= size % STATIC_CAST( size_t, page_size );
+  return size;
+}
+
+/**
+ * Initializes the number of jobs and the chunk size, if not done already nor
+ * set via par_configure().
+ */
+static void par_init( void ) {
+  if ( jobs > 0 && chunk_size > 0 )
+    return;
+
+  unsigned const cpus = cpus_online();
+  if ( opt_jobs > 0 ) {
+    jobs = opt_jobs;
+  } else if ( jobs == 0 ) {
+    jobs = cpus;
+    unsigned const quota = cgroup_cpus();
+    if ( quota > 0 && quota < jobs )
+      jobs = quota;
+  }
+  if ( chunk_size > 0 )
+    return;
+
+  size_t const l2 = cpu_cache_size( 2 );
+  size_t const l3 = cpu_cache_size( 3 );
+  size_t share = l3 / jobs;
+  if ( share < l2 )
+    share = l2;
+  // Leave half the cache for everything else a worker touches.
+  chunk_size = par_clamp_chunk_size( share / 2 );
+}
+
+#ifdef HAVE_PTHREAD_H
+
+/**
+ * Pins the calling thread to a CPU, but only if \ref opt_jobs_pin is `true`.
+ *
+ * @param worker The worker number used to pick the CPU from the set of allowed
+ * CPUs in round-robin order.
+ */
+static void par_pin( unsigned worker ) {
+#if PAR_CAN_PIN
+  if ( !opt_jobs_pin )
+    return;
+  unsigned const n_cpus = STATIC_CAST( unsigned, CPU_COUNT( &cpus_allowed ) );
+  if ( n_cpus == 0 )
+    return;
+  unsigned nth = worker % n_cpus;
+  for ( unsigned cpu = 0; cpu < CPU_SETSIZE; ++cpu ) {
+    if ( !CPU_ISSET( cpu, &cpus_allowed ) || nth-- > 0 )
+      continue;
+    cpu_set_t set;
+    CPU_ZERO( &set );
+    CPU_SET( cpu, &set );
+    // Pinning is only an optimization, so ignore failure.
+    PJL_DISCARD_RV( pthread_setaffinity_np( pthread_self(), sizeof set, &set ) );
+    break;
+  } // for
+#else
+  (void)worker;
+#endif /* PAR_CAN_PIN */
+}
+
+/**
+ * Runs tasks until there are no more.
+ *
+ * @param worker The worker number.
+ *
+ * @note \ref par_pool::mutex must be locked upon entry; it is locked upon
+ * return.
+ */
+static void par_run_tasks( unsigned worker ) {
+  while ( !pool.stop && pool.next_task < pool.n_tasks ) {
+    size_t const task = pool.next_task++;
+    pthread_mutex_unlock( &pool.mutex );
+    (*pool.fn)( pool.data, task, worker );
+    pthread_mutex_lock( &pool.mutex );
+  } // while
+}
+
+/**
+ * The main function of every worker thread.
+ *
+ * @param arg A pointer to the worker's \ref par_worker.
+ * @return Always returns NULL.
+ */
+static void* par_worker_main( void *arg ) {
+  par_worker_t const *const w = arg;
+  unsigned seen_generation = 0;
+
+  par_pin( w->worker );
+  pthread_mutex_lock( &pool.mutex );
+  for (;;) {
+    while ( !pool.stop && pool.generation == seen_generation )
+      pthread_cond_wait( &pool.work_cv, &pool.mutex );
+    if ( pool.stop )
+      break;
+    seen_generation = pool.generation;
+    par_run_tasks( w->worker );
+    if ( --pool.busy == 0 )
+      pthread_cond_signal( &pool.done_cv );
+  } // for
+  pthread_mutex_unlock( &pool.mutex );
+  return NULL;
+}
+
+/**
+ * Starts the worker threads, if not done already.
+ */
+static void par_start( void ) {
+  if ( pool.threads != NULL )
+    return;
+  pthread_mutex_init( &pool.mutex, /*attr=*/NULL );
+  pthread_cond_init( &pool.work_cv, /*attr=*/NULL );
+  pthread_cond_init( &pool.done_cv, /*attr=*/NULL );
+  pool.threads = MALLOC( pthread_t, jobs - 1 );
+  workers = MALLOC( par_worker_t, jobs - 1 );
+  par_pin( 0 );
+  for ( unsigned i = 0; i < jobs - 1; ++i ) {
+    workers[i] = (par_worker_t){ &pool, i + 1 };
+    if ( unlikely( pthread_create( &pool.threads[i], /*attr=*/NULL,
+                                   &par_worker_main, &workers[i] ) != 0 ) ) {
+      fatal_error( EX_OSERR, "can not create thread: %s\n", STRERROR() );
+    }
+  } // for
+}
+
+#endif /* HAVE_PTHREAD_H */
+
+////////// extern functions ///////////////////////////////////////////////////
+
+void par_cleanup( void ) {
+#ifdef HAVE_PTHREAD_H
+  if ( pool.threads == NULL )
+    return;
+  pthread_mutex_lock( &pool.mutex );
+  pool.stop = true;
+  pthread_cond_broadcast( &pool.work_cv );
+  pthread_mutex_unlock( &pool.mutex );
+  //
+  // If a task called exit(), e.g., via fatal_error(), we're running on that
+  // worker: it can't join itself and the thread that called par_for() may
+  // still be waiting on the pool, so just let the process end.
+  //
+  for ( unsigned i = 0; i < jobs - 1; ++i ) {
+    if ( pthread_equal( pthread_self(), pool.threads[i] ) )
+      return;
+  } // for
+  for ( unsigned i = 0; i < jobs - 1; ++i )
+    pthread_join( pool.threads[i], /*retval=*/NULL );
+  FREE( pool.threads );
+  FREE( workers );
+  pthread_cond_destroy( &pool.done_cv );
+  pthread_cond_destroy( &pool.work_cv );
+  pthread_mutex_destroy( &pool.mutex );
+  pool = (par_pool_t){ .threads = NULL };
+#endif /* HAVE_PTHREAD_H */
+}
+
+void par_configure( unsigned new_jobs, size_t new_chunk_size ) {
+  par_cleanup();
+  jobs = new_jobs;
+  chunk_size =
+    new_chunk_size > 0 ? par_clamp_chunk_size( new_chunk_size ) : 0;
+}
+
+size_t par_chunk_size( void ) {
+  par_init();
+  return chunk_size;
+}
+
+void par_for( size_t n_tasks, par_task_fn_t fn, void *data ) {
+  assert( fn != NULL );
+  par_init();
+
+#ifdef HAVE_PTHREAD_H
+  if ( jobs > 1 && n_tasks > 1 ) {
+    par_start();
+    pthread_mutex_lock( &pool.mutex );
+    pool.fn = fn;
+    pool.data = data;
+    pool.n_tasks = n_tasks;
+    pool.next_task = 0;
+    pool.busy = jobs - 1;
+    ++pool.generation;
+    pthread_cond_broadcast( &pool.work_cv );
+    par_run_tasks( /*worker=*/0 );
+    while ( pool.busy > 0 )
+      pthread_cond_wait( &pool.done_cv, &pool.mutex );
+    pthread_mutex_unlock( &pool.mutex );
+    return;
+  }
+#endif /* HAVE_PTHREAD_H */
+
+  for ( size_t task = 0; task < n_tasks; ++task )
+    (*fn)( data, task, /*worker=*/0 );
+}
+
+unsigned par_jobs( void ) {
+  par_init();
+  return jobs;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/** @} */
+
+/* vim:set et sw=2 ts=2: */
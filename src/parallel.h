@@ -0,0 +1,123 @@
+/*
+**      ad -- ASCII dump
+**      src/parallel.h
+**
+**      Copyright (C) 2024  Paul J. Lucas
+**
+**      This program is free software: you can redistribute it and/or modify
+**      it under the terms of the GNU General Public License as published by
+**      the Free Software Foundation, either version 3 of the License, or
+**      (at your option) any later version.
+**
+**      This program is distributed in the hope that it will be useful,
+**      but WITHOUT ANY WARRANTY; without even the implied warranty of
+**      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**      GNU General Public License for more details.
+**
+**      You should have received a copy of the GNU General Public License
+**      along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ad_parallel_H
+#define ad_parallel_H
+
+/**
+ * @file
+ * Declares types and functions for the parallel execution runtime shared by
+ * all parallel modes of **ad**.
+ */
+
+// local
+#include "pjl_config.h"                 /* must go first */
+
+/// @cond DOXYGEN_IGNORE
+
+// standard
+#include <stddef.h>                     /* for size_t */
+
+/// @endcond
+
+/**
+ * @defgroup parallel-group Parallel Execution
+ * Types and functions for the parallel execution runtime.
+ *
+ * @remarks Tasks may be run by any worker in any order, so all parallel modes
+ * must store per-task results indexed by task and merge them in task order
+ * afterwards.  That way, output is identical for any number of jobs.
+ * @{
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+
+#define PAR_CHUNK_SIZE_MIN  (64 * 1024u)        /**< Minimum chunk size.    */
+#define PAR_CHUNK_SIZE_MAX  (8 * 1024 * 1024u)  /**< Maximum chunk size.    */
+
+/**
+ * A function that performs one task of a parallel loop.
+ *
+ * @param data The pointer that was passed to par_for().
+ * @param task The task number in the range [0, _n_tasks_).
+ * @param worker The worker number in the range [0, par_jobs()); may be used to
+ * index per-worker state.
+ */
+typedef void (*par_task_fn_t)( void *data, size_t task, unsigned worker );
+
+/**
+ * Cleans up the parallel execution runtime by stopping all worker threads.
+ */
+void par_cleanup( void );
+
+/**
+ * Gets the size of the chunks that inputs should be divided into for
+ * processing in parallel.
+ *
+ * @remarks Unless set via par_configure(), the size is scaled so that each
+ * worker's chunk fits into its share of the L2 or L3 cache.
+ *
+ * @return Returns said size; always a multiple of the page size.
+ */
+NODISCARD
+size_t par_chunk_size( void );
+
+/**
+ * Sets the number of jobs and the chunk size to use from now on, stopping all
+ * worker threads first.
+ *
+ * @param new_jobs The number of jobs or 0 for the default.
+ * @param new_chunk_size The chunk size or 0 for the default.  It's clamped
+ * to [#PAR_CHUNK_SIZE_MIN, #PAR_CHUNK_SIZE_MAX] and rounded down to a multiple
+ * of the page size.
+ *
+ * @sa par_chunk_size()
+ * @sa par_jobs()
+ */
+void par_configure( unsigned new_jobs, size_t new_chunk_size );
+
+/**
+ * Calls \a fn for every task in [0, \a n_tasks) using par_jobs() workers and
+ * returns only after all tasks have completed.
+ *
+ * @param n_tasks The number of tasks.
+ * @param fn The function to call for each task.
+ * @param data The pointer to pass to \a fn.
+ */
+void par_for( size_t n_tasks, par_task_fn_t fn, void *data );
+
+/**
+ * Gets the number of jobs (worker threads) to use.
+ *
+ * @remarks Unless set explicitly via \ref opt_jobs or par_configure(), it's the number of CPUs
+ * **ad** may actually use, i.e., the smaller of the CPUs in the scheduler
+ * affinity mask and the cgroup CPU quota (if any).
+ *
+ * @return Returns said number; always at least 1.
+ */
+NODISCARD
+unsigned par_jobs( void );
+
+///////////////////////////////////////////////////////////////////////////////
+
+/** @} */
+
+#endif /* ad_parallel_H */
+/* vim:set et sw=2 ts=2: */
@@ -0,0 +1,642 @@
+/*
+**      ad -- ASCII dump
+**      src/profile.c
+**
+**      Copyright (C) 2024  Paul J. Lucas
+**
+**      This program is free software: you can redistribute it and/or modify
+**      it under the terms of the GNU General Public License as published by
+**      the Free Software Foundation, either version 3 of the License, or
+**      (at your option) any later version.
+**
+**      This program is distributed in the hope that it will be useful,
+**      but WITHOUT ANY WARRANTY; without even the implied warranty of
+**      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**      GNU General Public License for more details.
+**
+**      You should have received a copy of the GNU General Public License
+**      along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * Defines functions for calibrating **ad** to the host and for loading the
+ * resulting profile.
+ */
+
+// local
+#include "pjl_config.h"                 /* must go first */
+#include "ad.h"
+#include "input.h"
+#include "match.h"
+#include "options.h"
+#include "parallel.h"
+#include "util.h"
+
+/// @cond DOXYGEN_IGNORE
+
+// standard
+#include <assert.h>
+#include <ctype.h>                      /* for isspace() */
+#include <errno.h>
+#include <fcntl.h>                      /* for open(2), posix_fadvise(2) */
+#include <stdbool.h>
+#include <stdint.h>                     /* for uint*_t */
+#include <stdio.h>
+#include <stdlib.h>                     /* for getenv(), mkstemp() */
+#include <string.h>                     /* for str...() */
+#include <sys/stat.h>                   /* for mkdir(2) */
+#include <sysexits.h>
+#include <time.h>                       /* for clock_gettime() */
+#include <unistd.h>                     /* for pread(2), unlink(2) */
+
+/// @endcond
+
+/**
+ * @defgroup profile-group Profile
+ * Functions for calibrating **ad** to the host and for loading the resulting
+ * profile.
+ *
+ * @remarks A profile is a small text file of `key = value` lines that records
+ * the I/O and parallelism settings that worked best on the host when **ad**
+ * was last calibrated.  It's loaded at startup so those settings are used by
+ * default; explicit command-line options still take precedence.
+ * @{
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+
+#define CALIBRATE_FILE_SIZE (64 * 1024 * 1024u) /**< Default scratch size.  */
+#define CALIBRATE_RUNS      3           /**< Best of this many runs.        */
+#define CALIBRATE_SIZE_ENV  "AD_CALIBRATE_SIZE" /**< Scratch size override. */
+#define CALIBRATE_SLACK     0.05        /**< Prefer cheaper within this.    */
+#define CALIBRATE_WRITE_SIZE (1024 * 1024u) /**< Scratch file write size.   */
+
+#define PROFILE_ENV         "AD_PROFILE"  /**< Profile path override.       */
+#define PROFILE_PATH        "ad/profile"  /**< Relative to config dir.      */
+#define PROFILE_LINE_MAX    256         /**< Longest profile line.          */
+
+/**
+ * Read sizes to try, cheapest first.
+ */
+static size_t const CALIBRATE_READ_SIZES[] = {
+  16 * 1024u, 64 * 1024u, 256 * 1024u, 1024 * 1024u, 4 * 1024 * 1024u
+};
+
+/**
+ * Chunk sizes to try, cheapest first.
+ */
+static size_t const CALIBRATE_CHUNK_SIZES[] = {
+  PAR_CHUNK_SIZE_MIN, 256 * 1024u, 1024 * 1024u, 4 * 1024 * 1024u
+};
+
+/**
+ * The settings comprising a profile.  A value of 0 means "use the default."
+ */
+struct profile {
+  unsigned  jobs;                       ///< Number of jobs.
+  size_t    chunk_size;                 ///< Parallel chunk size.
+  size_t    read_size;                  ///< Sequential read size.
+};
+typedef struct profile profile_t;
+
+/**
+ * Data for the parallel calibration workload.
+ */
+struct calibrate_job {
+  int           fd;                     ///< Scratch file descriptor.
+  size_t        chunk_size;             ///< Bytes per task.
+  char8_t     **bufs;                   ///< Per-worker read buffers.
+  size_t const *kmps;                   ///< KMP table for the search.
+  size_t       *matches;                ///< Per-worker match counts.
+};
+typedef struct calibrate_job calibrate_job_t;
+
+// local variables
+static size_t calibrate_size;           ///< Scratch file size.
+
+////////// local functions ////////////////////////////////////////////////////
+
+/**
+ * Gets the current time.
+ *
+ * @return Returns said time in seconds from an arbitrary epoch.
+ */
+NODISCARD
+static double calibrate_now( void ) {
+  struct timespec ts;
+  PERROR_EXIT_IF( clock_gettime( CLOCK_MONOTONIC, &ts ) != 0, EX_OSERR );
+  return STATIC_CAST( double, ts.tv_sec ) +
+         STATIC_CAST( double, ts.tv_nsec ) / 1e9;
+}
+
+/**
+ * Evicts the scratch file from the page cache, if possible, so reads of it
+ * measure the storage rather than memory.
+ *
+ * @param fd The scratch file descriptor.
+ */
+static void calibrate_evict( int fd ) {
+#ifdef HAVE_POSIX_FADVISE
+  // Eviction is best-effort: some file systems (e.g., tmpfs) can't.
+  PJL_DISCARD_RV( posix_fadvise( fd, 0, 0, POSIX_FADV_DONTNEED ) );
+#else
+  (void)fd;
+#endif /* HAVE_POSIX_FADVISE */
+}
+
+/**
+ * Creates the scratch file to calibrate with and fills it with pseudo-random
+ * bytes.
+ *
+ * @remarks The file is unlinked immediately so it's removed however **ad**
+ * exits.
+ *
+ * @param dir The directory to create the file in.
+ * @return Returns the file descriptor of the file.
+ */
+NODISCARD
+static int calibrate_scratch( char const *dir ) {
+  char *const path = free_later(
+    MALLOC( char, strlen( dir ) + sizeof "/.ad-calibrate-XXXXXX" )
+  );
+  strcpy( path, dir );
+  strcat( path, "/.ad-calibrate-XXXXXX" );
+  int const fd = mkstemp( path );
+  if ( unlikely( fd == -1 ) )
+    fatal_error( EX_CANTCREAT, "\"%s\": %s\n", dir, STRERROR() );
+  PJL_DISCARD_RV( unlink( path ) );
+
+  uint64_t *const buf = MALLOC( uint64_t, CALIBRATE_WRITE_SIZE / 8 );
+  uint64_t x = 0x9E3779B97F4A7C15u;
+  for ( size_t written = 0; written < calibrate_size;
+        written += CALIBRATE_WRITE_SIZE ) {
+    for ( size_t i = 0; i < CALIBRATE_WRITE_SIZE / 8; ++i ) {
+      x ^= x << 13;                     // xorshift64
+      x ^= x >> 7;
+      x ^= x << 17;
+      buf[i] = x;
+    } // for
+    if ( unlikely( write( fd, buf, CALIBRATE_WRITE_SIZE ) !=
+                   STATIC_CAST( ssize_t, CALIBRATE_WRITE_SIZE ) ) ) {
+      fatal_error( EX_IOERR, "\"%s\": can not write: %s\n", dir, STRERROR() );
+    }
+  } // for
+  free( buf );
+  if ( unlikely( fsync( fd ) != 0 ) )
+    fatal_error( EX_IOERR, "\"%s\": can not sync: %s\n", dir, STRERROR() );
+  return fd;
+}
+
+/**
+ * Measures how fast the scratch file can be read sequentially.
+ *
+ * @param fd The scratch file descriptor.
+ * @param read_size The number of bytes per read.
+ * @param buf The buffer to read into; at least \a read_size bytes.
+ * @return Returns the best throughput in bytes per second.
+ */
+NODISCARD
+static double calibrate_read( int fd, size_t read_size, char8_t *buf ) {
+  double best = 0;
+  for ( unsigned run = 0; run < CALIBRATE_RUNS; ++run ) {
+    calibrate_evict( fd );
+    double const start = calibrate_now();
+    for ( off_t offset = 0; offset < STATIC_CAST( off_t, calibrate_size ); ) {
+      ssize_t const n = pread( fd, buf, read_size, offset );
+      PERROR_EXIT_IF( n == -1, EX_IOERR );
+      if ( n == 0 )
+        break;
+      offset += n;
+    } // for
+    double const elapsed = calibrate_now() - start;
+    double const rate =
+      STATIC_CAST( double, calibrate_size ) / (elapsed > 0 ? elapsed : 1e-9);
+    if ( rate > best )
+      best = rate;
+  } // for
+  return best;
+}
+
+/**
+ * Reads and searches one chunk of the scratch file.
+ *
+ * @param data A pointer to a \ref calibrate_job.
+ * @param task The chunk number.
+ * @param worker The worker number.
+ */
+static void calibrate_task( void *data, size_t task, unsigned worker ) {
+  calibrate_job_t const *const job = data;
+  ssize_t const n = pread(
+    job->fd, job->bufs[ worker ], job->chunk_size,
+    STATIC_CAST( off_t, task * job->chunk_size )
+  );
+  PERROR_EXIT_IF( n == -1, EX_IOERR );
+  job->matches[ worker ] += match_block_count(
+    job->bufs[ worker ], STATIC_CAST( size_t, n ), job->kmps, /*flags=*/NULL
+  );
+}
+
+/**
+ * Parses the value of #CALIBRATE_SIZE_ENV, if set.
+ *
+ * @return Returns the size of the scratch file rounded up to a multiple of
+ * #CALIBRATE_WRITE_SIZE or prints an error message and exits if the value is
+ * invalid.
+ */
+NODISCARD
+static size_t calibrate_size_get( void ) {
+  char const *const env = getenv( CALIBRATE_SIZE_ENV );
+  if ( env == NULL || env[0] == '\0' )
+    return CALIBRATE_FILE_SIZE;
+  if ( isdigit( env[0] ) ) {
+    errno = 0;
+    char *end;
+    unsigned long long n = strtoull( env, &end, 10 );
+    if ( errno == 0 && (end[0] == '\0' || end[1] == '\0') ) {
+      unsigned shift = 0;
+      switch ( end[0] ) {
+        case 'k': shift = 10; break;
+        case 'm': shift = 20; break;
+        case 'g': shift = 30; break;
+      } // switch
+      if ( (end[0] == '\0' || shift > 0) && n > 0 &&
+           n <= (SIZE_MAX - CALIBRATE_WRITE_SIZE) >> shift ) {
+        n <<= shift;
+        return STATIC_CAST( size_t,
+          (n + CALIBRATE_WRITE_SIZE - 1) / CALIBRATE_WRITE_SIZE
+            * CALIBRATE_WRITE_SIZE
+        );
+      }
+    }
+  }
+  fatal_error( EX_CONFIG,
+    "\"%s\": invalid value for %s; must be a size in bytes"
+    " optionally followed by k, m, or g\n",
+    env, CALIBRATE_SIZE_ENV
+  );
+}
+
+/**
+ * Measures how fast the scratch file can be read and searched in parallel.
+ *
+ * @param job The calibration job.
+ * @param jobs The number of jobs.
+ * @return Returns the best throughput in bytes per second.
+ */
+NODISCARD
+static double calibrate_par( calibrate_job_t *job, unsigned jobs ) {
+  par_configure( jobs, job->chunk_size );
+  job->bufs = MALLOC( char8_t*, jobs );
+  job->matches = MALLOC( size_t, jobs );
+  for ( unsigned w = 0; w < jobs; ++w ) {
+    job->bufs[w] = MALLOC( char8_t, job->chunk_size );
+    job->matches[w] = 0;
+  } // for
+
+  size_t const n_tasks =
+    (calibrate_size + job->chunk_size - 1) / job->chunk_size;
+  double best = 0;
+  for ( unsigned run = 0; run < CALIBRATE_RUNS; ++run ) {
+    calibrate_evict( job->fd );
+    double const start = calibrate_now();
+    par_for( n_tasks, &calibrate_task, job );
+    double const elapsed = calibrate_now() - start;
+    double const rate =
+      STATIC_CAST( double, calibrate_size ) / (elapsed > 0 ? elapsed : 1e-9);
+    if ( rate > best )
+      best = rate;
+  } // for
+
+  for ( unsigned w = 0; w < jobs; ++w )
+    free( job->bufs[w] );
+  free( job->bufs );
+  free( job->matches );
+  return best;
+}
+
+/**
+ * Gets the next number of jobs to try: successive powers of 2 up to, and
+ * always including, \a jobs_max.
+ *
+ * @param jobs The current number of jobs.
+ * @param jobs_max The maximum number of jobs.
+ * @return Returns said number or 0 if there are no more.
+ */
+NODISCARD
+static unsigned calibrate_jobs_next( unsigned jobs, unsigned jobs_max ) {
+  if ( jobs >= jobs_max )
+    return 0;
+  return jobs * 2 < jobs_max ? jobs * 2 : jobs_max;
+}
+
+/**
+ * Prints a calibration measurement.
+ *
+ * @param what What was measured.
+ * @param rate The throughput in bytes per second.
+ */
+static void calibrate_print( char const *what, double rate ) {
+  PRINTF( "%s: %8.1f MiB/s\n", what, rate / (1024 * 1024) );
+}
+
+/**
+ * Gets the path of the profile.
+ *
+ * @return Returns said path or NULL if there is none.
+ */
+NODISCARD
+static char const* profile_path( void ) {
+  char const *const env = getenv( PROFILE_ENV );
+  if ( env != NULL )
+    return env[0] != '\0' ? env : NULL;
+
+  char const *dir = getenv( "XDG_CONFIG_HOME" );
+  char const *sub = "/";
+  if ( dir == NULL || dir[0] == '\0' ) {
+    dir = getenv( "HOME" );
+    if ( dir == NULL || dir[0] == '\0' )
+      return NULL;
+    sub = "/.config/";
+  }
+  char *const path = free_later(
+    MALLOC( char, strlen( dir ) + strlen( sub ) + sizeof PROFILE_PATH )
+  );
+  strcpy( path, dir );
+  strcat( path, sub );
+  strcat( path, PROFILE_PATH );
+  return path;
+}
+
+/**
+ * Creates all the missing parent directories of \a path.
+ *
+ * @param path The path of a file.
+ */
+static void profile_mkdirs( char const *path ) {
+  char *const dir = check_strdup( path );
+  for ( char *slash = dir; (slash = strchr( slash + 1, '/' )) != NULL; ) {
+    *slash = '\0';
+    if ( mkdir( dir, 0755 ) != 0 && errno != EEXIST )
+      fatal_error( EX_CANTCREAT, "\"%s\": %s\n", dir, STRERROR() );
+    *slash = '/';
+  } // for
+  free( dir );
+}
+
+/**
+ * Parses the value of a profile setting.
+ *
+ * @param path The path of the profile.
+ * @param line The line number.
+ * @param s The value to parse.
+ * @param max The maximum valid value.
+ * @param pn A pointer to receive the value.
+ * @return Returns `true` only if \a s is valid; otherwise prints a warning
+ * and returns `false`.
+ */
+NODISCARD
+static bool profile_parse( char const *path, unsigned line, char const *s,
+                           unsigned long long max, unsigned long long *pn ) {
+  if ( isdigit( *s ) ) {
+    errno = 0;
+    char *end;
+    *pn = strtoull( s, &end, 10 );
+    if ( errno == 0 && *end == '\0' && *pn <= max )
+      return true;
+  }
+  EPRINTF(
+    "%s: \"%s\": line %u: \"%s\": invalid value; must be in 0-%llu;"
+    " ignoring profile\n",
+    me, path, line, s, max
+  );
+  return false;
+}
+
+/**
+ * Trims leading and trailing whitespace from \a s in place.
+ *
+ * @param s The string to trim.
+ * @return Returns \a s past any leading whitespace.
+ */
+NODISCARD
+static char* profile_trim( char *s ) {
+  while ( isspace( *s ) )
+    ++s;
+  for ( size_t len = strlen( s ); len > 0 && isspace( s[ len - 1 ] ); )
+    s[ --len ] = '\0';
+  return s;
+}
+
+/**
+ * Writes a profile.
+ *
+ * @param profile The profile to write.
+ * @param file The file to write to.
+ */
+static void profile_write( profile_t const *profile, FILE *file ) {
+  FPRINTF( file, "jobs = %u\n", profile->jobs );
+  FPRINTF( file, "chunk-size = %zu\n", profile->chunk_size );
+  FPRINTF( file, "read-size = %zu\n", profile->read_size );
+}
+
+/**
+ * Saves a profile.
+ *
+ * @param profile The profile to save.
+ * @param path The path of the profile.
+ */
+static void profile_save( profile_t const *profile, char const *path ) {
+  profile_mkdirs( path );
+  char *const tmp_path = free_later(
+    MALLOC( char, strlen( path ) + sizeof ".tmp" )
+  );
+  strcpy( tmp_path, path );
+  strcat( tmp_path, ".tmp" );
+  FILE *const file = fopen( tmp_path, "w" );
+  if ( unlikely( file == NULL ) )
+    fatal_error( EX_CANTCREAT, "\"%s\": %s\n", tmp_path, STRERROR() );
+  FPRINTF( file, "# written by %s --calibrate\n", me );
+  profile_write( profile, file );
+  if ( unlikely( fclose( file ) != 0 ) )
+    fatal_error( EX_IOERR, "\"%s\": %s\n", tmp_path, STRERROR() );
+  if ( unlikely( rename( tmp_path, path ) != 0 ) ) {
+    fatal_error( EX_CANTCREAT,
+      "\"%s\": can not rename to \"%s\": %s\n", tmp_path, path, STRERROR()
+    );
+  }
+}
+
+////////// extern functions ///////////////////////////////////////////////////
+
+/**
+ * Calibrates **ad** to the host by measuring read throughput of a scratch
+ * file for several read sizes, then read-and-search throughput for several
+ * numbers of jobs and chunk sizes, and saves the best settings as the profile.
+ *
+ * @remarks When several settings are within #CALIBRATE_SLACK of the best,
+ * the cheapest (smallest size or fewest jobs) is chosen so noise doesn't
+ * cause overcommitment.  The scratch file is #CALIBRATE_FILE_SIZE bytes
+ * unless overridden by #CALIBRATE_SIZE_ENV.
+ */
+void profile_calibrate( void ) {
+  char const *const path = profile_path();
+  if ( path == NULL ) {
+    fatal_error( EX_CONFIG,
+      "no profile path: set %s, XDG_CONFIG_HOME, or HOME\n", PROFILE_ENV
+    );
+  }
+
+  calibrate_size = calibrate_size_get();
+  int const fd = calibrate_scratch( opt_calibrate_dir );
+  profile_t profile = { 0, 0, 0 };
+  char what[ 40 ];
+
+  size_t const read_size_max =
+    CALIBRATE_READ_SIZES[ ARRAY_SIZE( CALIBRATE_READ_SIZES ) - 1 ];
+  char8_t *const buf = MALLOC( char8_t, read_size_max );
+  double read_rates[ ARRAY_SIZE( CALIBRATE_READ_SIZES ) ];
+  double best = 0;
+  for ( size_t i = 0; i < ARRAY_SIZE( CALIBRATE_READ_SIZES ); ++i ) {
+    read_rates[i] = calibrate_read( fd, CALIBRATE_READ_SIZES[i], buf );
+    snprintf( what, sizeof what, "read-size %8zu", CALIBRATE_READ_SIZES[i] );
+    calibrate_print( what, read_rates[i] );
+    if ( read_rates[i] > best )
+      best = read_rates[i];
+  } // for
+  free( buf );
+  for ( size_t i = 0; i < ARRAY_SIZE( CALIBRATE_READ_SIZES ); ++i ) {
+    if ( read_rates[i] >= best * (1 - CALIBRATE_SLACK) ) {
+      profile.read_size = CALIBRATE_READ_SIZES[i];
+      break;
+    }
+  } // for
+
+  static char needle[] = "\xFF\xFE" "ad calibrate";
+  opt_search_buf = needle;
+  opt_search_len = STRLITLEN( needle );
+  calibrate_job_t job = {
+    .fd = fd,
+    .kmps = kmp_new( opt_search_buf, opt_search_len )
+  };
+
+  par_configure( 0, 0 );
+  unsigned const jobs_max = par_jobs();
+  size_t const n_chunks = ARRAY_SIZE( CALIBRATE_CHUNK_SIZES );
+  double *const rates = MALLOC( double, (jobs_max + 1) * n_chunks );
+  best = 0;
+  for ( unsigned jobs = 1; jobs != 0;
+        jobs = calibrate_jobs_next( jobs, jobs_max ) ) {
+    for ( size_t c = 0; c < n_chunks; ++c ) {
+      job.chunk_size = CALIBRATE_CHUNK_SIZES[c];
+      double const rate = calibrate_par( &job, jobs );
+      rates[ jobs * n_chunks + c ] = rate;
+      snprintf( what, sizeof what,
+        "jobs %3u chunk-size %8zu", jobs, job.chunk_size
+      );
+      calibrate_print( what, rate );
+      if ( rate > best )
+        best = rate;
+    } // for
+  } // for
+  for ( unsigned jobs = 1; profile.jobs == 0 && jobs != 0;
+        jobs = calibrate_jobs_next( jobs, jobs_max ) ) {
+    for ( size_t c = 0; c < n_chunks; ++c ) {
+      if ( rates[ jobs * n_chunks + c ] >= best * (1 - CALIBRATE_SLACK) ) {
+        profile.jobs = jobs;
+        profile.chunk_size = CALIBRATE_CHUNK_SIZES[c];
+        break;
+      }
+    } // for
+  } // for
+  free( rates );
+  FREE( job.kmps );
+  opt_search_buf = NULL;
+  opt_search_len = 0;
+  par_configure( 0, 0 );
+  close( fd );
+
+  profile_save( &profile, path );
+  PRINTF( "\"%s\":\n", path );
+  profile_write( &profile, fout );
+}
+
+/**
+ * Loads the profile, if any, and applies its settings: the number of jobs
+ * (unless \ref opt_jobs was given) and chunk size for parallel modes; and the
+ * read size for reading standard input when it's a regular file.
+ *
+ * @note This must be called before any I/O on standard input.
+ *
+ * @remarks The profile is at `$AD_PROFILE`, if set (and disabled if empty);
+ * else `$XDG_CONFIG_HOME/ad/profile`; else `~/.config/ad/profile`.  A missing
+ * profile is silently ignored; unknown keys are ignored for compatibility
+ * with future versions.  A malformed profile is ignored entirely with a
+ * warning rather than making every invocation fail.
+ */
+void profile_load( void ) {
+  char const *const path = profile_path();
+  if ( path == NULL )
+    return;
+  FILE *const file = fopen( path, "r" );
+  if ( file == NULL )
+    return;
+
+  profile_t profile = { 0, 0, 0 };
+  char buf[ PROFILE_LINE_MAX ];
+  for ( unsigned line = 1; fgets( buf, sizeof buf, file ) != NULL; ++line ) {
+    char *const comment = strchr( buf, '#' );
+    if ( comment != NULL )
+      *comment = '\0';
+    char *const key = profile_trim( buf );
+    if ( key[0] == '\0' )
+      continue;
+    char *const eq = strchr( key, '=' );
+    if ( eq == NULL ) {
+      EPRINTF(
+        "%s: \"%s\": line %u: \"%s\": \"key = value\" expected;"
+        " ignoring profile\n",
+        me, path, line, key
+      );
+      goto ignore;
+    }
+    *eq = '\0';
+    char const *const value = profile_trim( eq + 1 );
+    PJL_DISCARD_RV( profile_trim( key ) );
+
+    unsigned long long n;
+    if ( strcmp( key, "jobs" ) == 0 ) {
+      if ( !profile_parse( path, line, value, UINT16_MAX, &n ) )
+        goto ignore;
+      profile.jobs = STATIC_CAST( unsigned, n );
+    }
+    else if ( strcmp( key, "chunk-size" ) == 0 ) {
+      if ( !profile_parse( path, line, value, PAR_CHUNK_SIZE_MAX, &n ) )
+        goto ignore;
+      profile.chunk_size = STATIC_CAST( size_t, n );
+    }
+    else if ( strcmp( key, "read-size" ) == 0 ) {
+      if ( !profile_parse( path, line, value, PAR_CHUNK_SIZE_MAX, &n ) )
+        goto ignore;
+      profile.read_size = STATIC_CAST( size_t, n );
+    }
+  } // for
+  fclose( file );
+
+  par_configure( opt_jobs > 0 ? 0 : profile.jobs, profile.chunk_size );
+  if ( profile.read_size > 0 && input_is_file() ) {
+    PERROR_EXIT_IF(
+      setvbuf( fin, NULL, _IOFBF, profile.read_size ) != 0, EX_OSERR
+    );
+  }
+  return;
+
+ignore:
+  fclose( file );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/** @} */
+
+/* vim:set et sw=2 ts=2: */
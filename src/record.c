@@ -0,0 +1,427 @@
+/*
+**      ad -- ASCII dump
+**      src/record.c
+**
+**      Copyright (C) 2024  Paul J. Lucas
+**
+**      This program is free software: you can redistribute it and/or modify
+**      it under the terms of the GNU General Public License as published by
+**      the Free Software Foundation, either version 3 of the License, or
+**      (at your option) any later version.
+**
+**      This program is distributed in the hope that it will be useful,
+**      but WITHOUT ANY WARRANTY; without even the implied warranty of
+**      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**      GNU General Public License for more details.
+**
+**      You should have received a copy of the GNU General Public License
+**      along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * Defines functions for detecting the length of fixed-length records.
+ */
+
+// local
+#include "pjl_config.h"                 /* must go first */
+#include "ad.h"
+#include "color.h"
+#include "input.h"
+#include "options.h"
+#include "parallel.h"
+#include "util.h"
+
+/// @cond DOXYGEN_IGNORE
+
+// standard
+#include <assert.h>
+#include <math.h>                       /* for sqrt() */
+#include <stddef.h>                     /* for size_t */
+#include <stdint.h>                     /* for uint64_t, SIZE_MAX */
+#include <stdio.h>
+#include <stdlib.h>                     /* for exit(), qsort() */
+#include <string.h>                     /* for memcpy() */
+#include <sysexits.h>
+
+/// @endcond
+
+/**
+ * @defgroup record-group Detecting Records
+ * Functions for detecting the length of fixed-length records.
+ *
+ * @remarks The length is estimated from a sample at the start of the input by
+ * autocorrelation: for every candidate length (lag) _k_, the fraction of bytes
+ * equal to the byte _k_ bytes before it is counted.  Fields that are the same
+ * or similar in every record (sync bytes, headers, padding) make that fraction
+ * peak at the record length and its multiples.
+ * @{
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+
+#define RECORD_CANDIDATES     5u        /**< Candidates to report.          */
+#define RECORD_HARMONIC       0.5       /**< Score fraction for multiples.  */
+#define RECORD_LAGS_PER_TASK  64u       /**< Lags per parallel task.        */
+#define RECORD_LEN_MAX        8192u     /**< Maximum record length.         */
+#define RECORD_LEN_MIN        2u        /**< Minimum record length.         */
+#define RECORD_RECORDS_MIN    4u        /**< Minimum records in sample.     */
+#define RECORD_SAMPLE_SIZE    (256 * 1024u) /**< Maximum sample size.       */
+#define RECORD_SIGMAS         5.0       /**< Standard errors for a peak.    */
+
+/**
+ * A candidate record length.
+ */
+struct record_candidate {
+  size_t  len;                          ///< Record length.
+  size_t  phase;                        ///< Offset of first record in sample.
+  double  equal;                        ///< Fraction of equal bytes.
+  double  score;                        ///< Prominence of peak.
+};
+typedef struct record_candidate record_candidate_t;
+
+/**
+ * Data shared by all record_task() tasks.
+ */
+struct record_job {
+  char8_t const  *buf;                  ///< Sample.
+  size_t          buf_len;              ///< Length of \ref buf.
+  size_t          lag_max;              ///< Maximum lag.
+  uint64_t       *equal;                ///< Equal bytes for each lag.
+};
+typedef struct record_job record_job_t;
+
+////////// local functions ////////////////////////////////////////////////////
+
+/**
+ * Comparison function for qsort(3) that orders candidates by descending score
+ * then ascending length.
+ *
+ * @param i_data A pointer to the first \ref record_candidate.
+ * @param j_data A pointer to the second \ref record_candidate.
+ * @return Returns a number less than 0, 0, or greater than 0 if \a i_data is
+ * less than, equal to, or greater than \a j_data, respectively.
+ */
+NODISCARD
+static int record_cmp( void const *i_data, void const *j_data ) {
+  record_candidate_t const *const i = i_data;
+  record_candidate_t const *const j = j_data;
+  if ( i->score > j->score )
+    return -1;
+  if ( i->score < j->score )
+    return 1;
+  return i->len < j->len ? -1 : i->len > j->len;
+}
+
+/**
+ * Counts the bytes of \a buf equal to the byte \a lag bytes before them.
+ *
+ * @remarks The bytes are compared 8 at a time within a 64-bit word: the
+ * bytes of the exclusive-or of two words are 0 only where the bytes are
+ * equal, and those are counted in 8 byte-wide counters that are summed before
+ * any can overflow.
+ *
+ * @param buf The bytes.
+ * @param buf_len The length of \a buf.
+ * @param lag The distance between compared bytes; must be &lt; \a buf_len.
+ * @return Returns said number of bytes.
+ */
+NODISCARD
+static uint64_t record_equal( char8_t const *buf, size_t buf_len,
+                              size_t lag ) {
+  static uint64_t const LOW7 = 0x7F7F7F7F7F7F7F7Full;
+  static uint64_t const ONES = 0x0101010101010101ull;
+  static uint64_t const EVEN = 0x00FF00FF00FF00FFull;
+
+  assert( buf != NULL );
+  assert( lag < buf_len );
+
+  char8_t const *a = buf, *b = buf + lag;
+  size_t n = buf_len - lag;
+  uint64_t equal = 0;
+
+  while ( n >= sizeof( uint64_t ) ) {
+    size_t words = n / sizeof( uint64_t );
+    if ( words > 255 )                  // before any counter can overflow
+      words = 255;
+    uint64_t counts = 0;
+    for ( size_t i = 0; i < words; ++i ) {
+      uint64_t x, y;
+      memcpy( &x, a, sizeof x );
+      memcpy( &y, b, sizeof y );
+      x ^= y;
+      // The high bit of each byte is set only if the byte is non-zero.
+      x = ((x & LOW7) + LOW7) | x;
+      counts += (~x >> 7) & ONES;
+      a += sizeof x;
+      b += sizeof y;
+    } // for
+    // Sum pairs of counters into 16-bit ones, then those via multiplication.
+    counts = (counts & EVEN) + ((counts >> 8) & EVEN);
+    equal += (counts * 0x0001000100010001ull) >> 48;
+    n -= words * sizeof( uint64_t );
+  } // while
+
+  for ( ; n > 0; --n )
+    equal += *a++ == *b++;
+  return equal;
+}
+
+/**
+ * Finds the offset of the first record within the first \a len bytes of \a
+ * buf.
+ *
+ * @remarks A record most likely starts where bytes that differ between
+ * records (e.g., the payload of the previous record) are followed by bytes
+ * that don't (e.g., a sync byte or header), so the start is the byte most
+ * often equal to the byte \a len bytes after it compared to the byte before
+ * it.
+ *
+ * @param buf The sample.
+ * @param buf_len The length of \a buf.
+ * @param len The record length.
+ * @return Returns said offset.
+ */
+NODISCARD
+static size_t record_phase( char8_t const *buf, size_t buf_len, size_t len ) {
+  assert( buf != NULL );
+  assert( len < buf_len );
+
+  uint64_t *const equal = MALLOC( uint64_t, len );
+  memset( equal, 0, sizeof( uint64_t ) * len );
+  for ( size_t i = 0, column = 0; i < buf_len - len; ++i ) {
+    equal[ column ] += buf[i] == buf[ i + len ];
+    if ( ++column == len )
+      column = 0;
+  } // for
+
+  size_t phase = 0;
+  int64_t rise_max = INT64_MIN;
+  for ( size_t column = 0; column < len; ++column ) {
+    uint64_t const prev = equal[ column > 0 ? column - 1 : len - 1 ];
+    int64_t const rise = STATIC_CAST( int64_t, equal[ column ] ) -
+                         STATIC_CAST( int64_t, prev );
+    if ( rise > rise_max ) {
+      rise_max = rise;
+      phase = column;
+    }
+  } // for
+  free( equal );
+  return phase;
+}
+
+/**
+ * Counts the equal bytes for one range of lags.
+ *
+ * @param data A pointer to the \ref record_job.
+ * @param task The task number.
+ * @param worker The worker number (unused).
+ */
+static void record_task( void *data, size_t task, unsigned worker ) {
+  record_job_t const *const job = data;
+  (void)worker;
+
+  size_t const lag_begin = 1 + task * RECORD_LAGS_PER_TASK;
+  size_t lag_end = lag_begin + RECORD_LAGS_PER_TASK;
+  if ( lag_end > job->lag_max + 2 )
+    lag_end = job->lag_max + 2;
+  for ( size_t lag = lag_begin; lag < lag_end; ++lag )
+    job->equal[ lag ] = record_equal( job->buf, job->buf_len, lag );
+}
+
+/**
+ * Prints that no record length was detected and exits.
+ */
+_Noreturn static void record_none( void ) {
+  EPRINTF( "%s: \"%s\": no record length detected\n", me, fin_path );
+  exit( EX_NO_MATCHES );
+}
+
+/**
+ * Reads a sample from the start of the input and finds the most likely record
+ * lengths.
+ *
+ * @param candidates The array to receive at most #RECORD_CANDIDATES
+ * candidates sorted by descending score.
+ * @return Returns the number of candidates, always at least 1: if there are
+ * none, prints an error message and exits.
+ */
+NODISCARD
+static size_t record_detect( record_candidate_t *candidates ) {
+  assert( candidates != NULL );
+
+  size_t buf_len = RECORD_SAMPLE_SIZE;
+  if ( buf_len > opt_max_bytes )
+    buf_len = opt_max_bytes;
+  char8_t *const buf = MALLOC( char8_t, buf_len );
+  buf_len = fread( buf, 1, buf_len, fin );
+  if ( unlikely( ferror( fin ) ) )
+    fatal_error( EX_IOERR, "\"%s\": read failed: %s\n", fin_path, STRERROR() );
+
+  record_job_t job = {
+    .buf = buf,
+    .buf_len = buf_len,
+    .lag_max = buf_len / RECORD_RECORDS_MIN
+  };
+  if ( job.lag_max > RECORD_LEN_MAX )
+    job.lag_max = RECORD_LEN_MAX;
+  if ( job.lag_max < RECORD_LEN_MIN ) {
+    free( buf );
+    record_none();
+  }
+
+  //
+  // The fraction of equal bytes expected by chance alone is the probability
+  // that two bytes drawn at random from the sample are the same.
+  //
+  uint64_t histogram[ 256 ] = { 0 };
+  for ( size_t i = 0; i < buf_len; ++i )
+    ++histogram[ buf[i] ];
+  double chance = 0;
+  for ( size_t b = 0; b < 256; ++b ) {
+    double const f = STATIC_CAST( double, histogram[b] ) /
+                     STATIC_CAST( double, buf_len );
+    chance += f * f;
+  } // for
+
+  //
+  // Lags just outside [RECORD_LEN_MIN, lag_max] are also needed as neighbors.
+  //
+  job.equal = MALLOC( uint64_t, job.lag_max + 2 );
+  par_for(
+    (job.lag_max + RECORD_LAGS_PER_TASK) / RECORD_LAGS_PER_TASK,
+    &record_task, &job
+  );
+
+  double *const excess = MALLOC( double, job.lag_max + 2 );
+  for ( size_t lag = 1; lag <= job.lag_max + 1; ++lag ) {
+    double const equal = STATIC_CAST( double, job.equal[ lag ] ) /
+                         STATIC_CAST( double, buf_len - lag );
+    excess[ lag ] = chance < 1 ? (equal - chance) / (1 - chance) : 0;
+  } // for
+
+  //
+  // Candidates are peaks scored by how much they stand out from their
+  // neighbors, so a length doesn't score well merely because nearby bytes are
+  // similar, e.g., in runs of zeros.  A multiple of a length scores about as
+  // well as the length itself, so it's not a candidate if the length is.
+  //
+  // Even in random data, about half of all lengths are peaks by chance, so a
+  // peak must also be significant: its fraction of equal bytes must exceed
+  // chance by several standard errors of a fraction of that many bytes.
+  //
+  record_candidate_t *const peaks = MALLOC( record_candidate_t, job.lag_max );
+  size_t peaks_len = 0;
+  for ( size_t lag = RECORD_LEN_MIN; lag <= job.lag_max; ++lag ) {
+    double const neighbor = excess[ lag - 1 ] > excess[ lag + 1 ] ?
+      excess[ lag - 1 ] : excess[ lag + 1 ];
+    double const score = excess[ lag ] - neighbor;
+    if ( score <= 0 )
+      continue;
+    double const n = STATIC_CAST( double, buf_len - lag );
+    double const equal = STATIC_CAST( double, job.equal[ lag ] ) / n;
+    if ( equal - chance <= RECORD_SIGMAS * sqrt( chance * (1 - chance) / n ) )
+      continue;
+    bool is_multiple = false;
+    for ( size_t i = 0; i < peaks_len && !is_multiple; ++i ) {
+      is_multiple = lag % peaks[i].len == 0 &&
+        peaks[i].score >= score * RECORD_HARMONIC;
+    } // for
+    if ( is_multiple )
+      continue;
+    peaks[ peaks_len++ ] = (record_candidate_t){
+      .len = lag,
+      .equal = equal,
+      .score = score
+    };
+  } // for
+
+  qsort( peaks, peaks_len, sizeof( record_candidate_t ), &record_cmp );
+  if ( peaks_len > RECORD_CANDIDATES )
+    peaks_len = RECORD_CANDIDATES;
+  for ( size_t i = 0; i < peaks_len; ++i ) {
+    peaks[i].phase = record_phase( buf, buf_len, peaks[i].len );
+    candidates[i] = peaks[i];
+  } // for
+
+  free( peaks );
+  free( excess );
+  free( job.equal );
+  free( buf );
+  if ( peaks_len == 0 )
+    record_none();
+  return peaks_len;
+}
+
+////////// extern functions ///////////////////////////////////////////////////
+
+/**
+ * Detects the most likely record length of the input and sets \ref row_bytes
+ * to it (or, if it's too long, to its largest divisor that isn't) and skips
+ * to the first record so each row starts at a record (or part of one).
+ *
+ * @remarks The input must be a regular file since the sample is read again.
+ */
+void record_align( void ) {
+  if ( !input_is_file() ) {
+    fatal_error( EX_USAGE,
+      "\"%s\": must be a regular file to dump records\n", fin_path
+    );
+  }
+  off_t const begin = FTELL_FN( fin );
+  record_candidate_t candidates[ RECORD_CANDIDATES ];
+  PJL_DISCARD_RV( record_detect( candidates ) );
+  FSEEK( fin, begin, SEEK_SET );
+
+  size_t len = candidates->len;
+  while ( len > ROW_BYTES_MAX ) {
+    size_t divisor = ROW_BYTES_MAX;
+    while ( len % divisor != 0 )
+      --divisor;
+    len = divisor;
+  } // while
+  if ( len < RECORD_LEN_MIN )           // e.g., a prime length
+    return;
+  row_bytes = STATIC_CAST( unsigned, len );
+
+  size_t const phase = candidates->phase % len;
+  if ( phase > 0 ) {
+    FSEEK( fin, begin + STATIC_CAST( off_t, phase ), SEEK_SET );
+    fin_offset += STATIC_CAST( off_t, phase );
+    if ( opt_max_bytes != SIZE_MAX )
+      opt_max_bytes = opt_max_bytes > phase ? opt_max_bytes - phase : 0;
+  }
+}
+
+/**
+ * Reports the most likely record lengths of the input, one per line, along
+ * with the offset of the first record and the percentage of bytes equal to the
+ * byte one record before them.
+ */
+void record_report( void ) {
+  record_candidate_t candidates[ RECORD_CANDIDATES ];
+  size_t const candidates_len = record_detect( candidates );
+
+  char const *const offset_format = get_offsets_format();
+  for ( size_t i = 0; i < candidates_len; ++i ) {
+    record_candidate_t const *const c = &candidates[i];
+    if ( opt_offsets != OFFSETS_NONE ) {
+      color_start( fout, sgr_offset );
+      PRINTF( offset_format,
+        STATIC_CAST( uint64_t, fin_offset ) + c->phase
+      );
+      color_end( fout, sgr_offset );
+      color_start( fout, sgr_sep );
+      PUTC( ':' );
+      color_end( fout, sgr_sep );
+      PUTC( ' ' );
+    }
+    PRINTF( "%4zu %5.1f%%\n", c->len, c->equal * 100 );
+  } // for
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/** @} */
+
+/* vim:set et sw=2 ts=2: */
@@ -0,0 +1,252 @@
+/*
+**      ad -- ASCII dump
+**      src/replace.c
+**
+**      Copyright (C) 2024  Paul J. Lucas
+**
+**      This program is free software: you can redistribute it and/or modify
+**      it under the terms of the GNU General Public License as published by
+**      the Free Software Foundation, either version 3 of the License, or
+**      (at your option) any later version.
+**
+**      This program is distributed in the hope that it will be useful,
+**      but WITHOUT ANY WARRANTY; without even the implied warranty of
+**      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**      GNU General Public License for more details.
+**
+**      You should have received a copy of the GNU General Public License
+**      along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * Defines types and functions for replacing matches in a file.
+ */
+
+// local
+#include "pjl_config.h"                 /* must go first */
+#include "ad.h"
+#include "match.h"
+#include "options.h"
+#include "parallel.h"
+#include "util.h"
+
+/// @cond DOXYGEN_IGNORE
+
+// standard
+#include <assert.h>
+#include <fcntl.h>                      /* for open(2) */
+#include <inttypes.h>                   /* for PRIu64 */
+#include <stddef.h>                     /* for size_t */
+#include <stdint.h>                     /* for uint*_t */
+#include <stdio.h>
+#include <stdlib.h>                     /* for exit(), free() */
+#include <string.h>                     /* for memcpy(), memmove() */
+#include <sysexits.h>
+#include <unistd.h>                     /* for pwrite(2), read(2) */
+
+/// @endcond
+
+/**
+ * @defgroup replace-group Replacing
+ * Types and functions for replacing matches in a file.
+ * @{
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+
+#define REPLACE_CHUNK_SIZE    (1024 * 1024u) /**< Bytes searched per task.  */
+#define REPLACE_CHUNKS        16u       /**< Chunks read at a time.         */
+
+/**
+ * The matches found in one chunk of the input.
+ */
+struct replace_chunk {
+  uint32_t     *starts;                 ///< Offsets of matches in chunk.
+  size_t        starts_len;             ///< Length of \ref starts.
+  size_t        starts_cap;             ///< Capacity of \ref starts.
+};
+typedef struct replace_chunk replace_chunk_t;
+
+/**
+ * Data shared by all tasks of searching a buffer of the input.
+ */
+struct replace_job {
+  char8_t const    *buf;                ///< Bytes read.
+  size_t            buf_len;            ///< Length of \ref buf.
+  size_t const     *kmps;               ///< KMP table for search bytes.
+  replace_chunk_t  *chunks;             ///< Matches per chunk.
+};
+typedef struct replace_job replace_job_t;
+
+////////// local functions ////////////////////////////////////////////////////
+
+/**
+ * Reads bytes until either \a buf is full or EOF.
+ *
+ * @param fd The file descriptor to read from.
+ * @param buf The buffer to read into.
+ * @param buf_len The number of bytes to read.
+ * @return Returns the number of bytes read.
+ */
+NODISCARD
+static size_t replace_read( int fd, char8_t *buf, size_t buf_len ) {
+  size_t len = 0;
+  while ( len < buf_len ) {
+    ssize_t const bytes_read = read( fd, buf + len, buf_len - len );
+    if ( unlikely( bytes_read == -1 ) )
+      fatal_error( EX_IOERR, "\"%s\": can not read: %s\n", fin_path, STRERROR() );
+    if ( bytes_read == 0 )
+      break;
+    len += STATIC_CAST( size_t, bytes_read );
+  } // while
+  return len;
+}
+
+/**
+ * Finds every match, overlapping or not, that starts within one chunk.
+ *
+ * @param data A pointer to the \ref replace_job.
+ * @param task The chunk number.
+ * @param worker The worker number (unused).
+ */
+static void replace_task( void *data, size_t task, unsigned worker ) {
+  (void)worker;
+  replace_job_t const *const job = data;
+  replace_chunk_t *const chunk = &job->chunks[ task ];
+  chunk->starts_len = 0;
+
+  size_t const begin = task * REPLACE_CHUNK_SIZE;
+  // Search past the end of the chunk for matches that start within it.
+  size_t end = begin + REPLACE_CHUNK_SIZE + opt_search_len - 1;
+  if ( end > job->buf_len )
+    end = job->buf_len;
+
+  char8_t const *p = job->buf + begin;
+  size_t kmp = 0;
+  while ( (p = match_next( p, job->buf + end, job->kmps, &kmp )) != NULL ) {
+    if ( chunk->starts_len == chunk->starts_cap ) {
+      chunk->starts_cap = chunk->starts_cap == 0 ? 64 : chunk->starts_cap * 2;
+      REALLOC( chunk->starts, chunk->starts_cap );
+    }
+    chunk->starts[ chunk->starts_len++ ] = STATIC_CAST( uint32_t,
+      STATIC_CAST( size_t, p - job->buf ) - opt_search_len - begin
+    );
+  } // while
+}
+
+/////////// extern functions //////////////////////////////////////////////////
+
+/**
+ * Replaces every non-overlapping match of \ref opt_search_buf, leftmost
+ * first, by \ref opt_replace_buf either in place or in a copy written to
+ * standard output, then prints the number of replacements to standard error.
+ *
+ * @remarks The input is read sequentially a buffer at a time (so it may be a
+ * pipe when copying).  Each buffer is divided into chunks that are searched
+ * in parallel for all matches, including overlapping ones and those that end
+ * in the next chunk.  The matches are then taken in order, skipping any that
+ * overlap the previous one taken, so the result is the same as searching
+ * sequentially regardless of the number of jobs.  The last few bytes of a
+ * buffer that could be the start of a match are carried over to the next.
+ *
+ * In place, only the range of bytes of each chunk that changed is written via
+ * **pwrite**(2) and only after it has been read.
+ */
+void replace_file( void ) {
+  int const fd_in = fileno( fin );
+  int fd_out = -1;
+  if ( opt_replace_in_place ) {
+    fd_out = open( fin_path, O_WRONLY );
+    if ( unlikely( fd_out == -1 ) )
+      fatal_error( EX_CANTCREAT, "\"%s\": %s\n", fin_path, STRERROR() );
+  }
+
+  size_t const keep_max = opt_search_len - 1;
+  size_t const buf_cap = REPLACE_CHUNKS * REPLACE_CHUNK_SIZE + keep_max;
+  char8_t *const buf = MALLOC( char8_t, buf_cap );
+  replace_chunk_t *const chunks = MALLOC( replace_chunk_t, REPLACE_CHUNKS );
+  memset( chunks, 0, REPLACE_CHUNKS * sizeof( replace_chunk_t ) );
+
+  replace_job_t job = {
+    .buf = buf,
+    .kmps = kmp_new( opt_search_buf, opt_search_len ),
+    .chunks = chunks
+  };
+
+  uint64_t buf_offset = 0;              // file offset of buf[0]
+  uint64_t prev_end = 0;                // file offset of end of last match
+  uint64_t replacements = 0;
+  size_t   keep_len = 0;                // bytes carried from previous buffer
+
+  for (;;) {
+    size_t const bytes_read =
+      replace_read( fd_in, buf + keep_len, buf_cap - keep_len );
+    bool const is_eof = bytes_read < buf_cap - keep_len;
+    job.buf_len = keep_len + bytes_read;
+
+    // Only matches that end within buf are found now; ones that start in the
+    // last keep_max bytes are found after the next read.
+    size_t const chunks_len = job.buf_len < opt_search_len ? 0 :
+      (job.buf_len - opt_search_len) / REPLACE_CHUNK_SIZE + 1;
+    par_for( chunks_len, &replace_task, &job );
+
+    for ( size_t i = 0; i < chunks_len; ++i ) {
+      replace_chunk_t const *const chunk = &chunks[i];
+      size_t dirty_begin = SIZE_MAX, dirty_end = 0;
+      for ( size_t j = 0; j < chunk->starts_len; ++j ) {
+        size_t const start = i * REPLACE_CHUNK_SIZE + chunk->starts[j];
+        if ( buf_offset + start < prev_end )
+          continue;                     // overlaps previous replacement
+        memcpy( buf + start, opt_replace_buf, opt_search_len );
+        prev_end = buf_offset + start + opt_search_len;
+        if ( dirty_begin == SIZE_MAX )
+          dirty_begin = start;
+        dirty_end = start + opt_search_len;
+        ++replacements;
+      } // for
+      if ( fd_out != -1 && dirty_begin < dirty_end ) {
+        size_t const len = dirty_end - dirty_begin;
+        if ( unlikely( pwrite( fd_out, buf + dirty_begin, len,
+                         STATIC_CAST( off_t, buf_offset + dirty_begin ) ) !=
+                       STATIC_CAST( ssize_t, len ) ) ) {
+          fatal_error( EX_IOERR,
+            "\"%s\": can not write: %s\n", fin_path, STRERROR()
+          );
+        }
+      }
+    } // for
+
+    keep_len = is_eof ? 0 : keep_max;
+    size_t const done_len = job.buf_len - keep_len;
+    if ( fd_out == -1 && done_len > 0 ) {
+      PERROR_EXIT_IF(
+        fwrite( buf, 1, done_len, fout ) < done_len, EX_IOERR
+      );
+    }
+    if ( is_eof )
+      break;
+    memmove( buf, buf + done_len, keep_len );
+    buf_offset += done_len;
+  } // for
+
+  if ( fd_out != -1 && unlikely( close( fd_out ) == -1 ) )
+    fatal_error( EX_IOERR, "\"%s\": %s\n", fin_path, STRERROR() );
+  FFLUSH( fout );
+  EPRINTF( "%" PRIu64 "\n", replacements );
+
+  for ( size_t i = 0; i < REPLACE_CHUNKS; ++i )
+    free( chunks[i].starts );
+  free( chunks );
+  FREE( job.kmps );
+  free( buf );
+
+  if ( replacements == 0 )
+    exit( EX_NO_MATCHES );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/** @} */
+
+/* vim:set et sw=2 ts=2: */
@@ -26,7 +26,9 @@
 // local
 #include "pjl_config.h"                 /* must go first */
 #include "ad.h"
+#include "line_index.h"
 #include "options.h"
+#include "parallel.h"
 #include "unicode.h"
 #include "util.h"
 
@@ -36,11 +38,17 @@
 #include <assert.h>
 #include <ctype.h>
 #include <inttypes.h>                   /* for SCNu64 */
+#include <fcntl.h>                      /* for open(2) */
+#include <intprops.h>                   /* for TYPE_MAXIMUM */
+#include <stdarg.h>
 #include <stddef.h>                     /* fir size_t */
 #include <stdio.h>
 #include <stdlib.h>                     /* for exit() */
 #include <string.h>                     /* for str...() */
+#include <sys/mman.h>                   /* for mmap(2) */
+#include <sys/stat.h>                   /* for fstat(2) */
 #include <sysexits.h>
+#include <unistd.h>                     /* for close(2) */
 
 #ifdef FWRITE
 #undef FWRITE
@@ -56,6 +64,9 @@
 
 ///////////////////////////////////////////////////////////////////////////////
 
+#define C_ARRAY_IN_SIZE   (1024 * 1024u)  /**< C array input block size.   */
+#define C_ARRAY_OUT_SIZE  (64 * 1024u)    /**< C array output buffer size. */
+
 /**
  * Calls **fwrite**(3) on \a STREAM, checks for an error, and exits if there
  * was one.
@@ -72,25 +83,96 @@
  * Convenience macro for calling fatal_error().
  *
  * @param LINE The line in the **ad** file on which the error occurred.
- * @param COL The column in the **ad** file at which the error occurred.
- * @param FORMAT The `printf()` format.
- * @param .. The `printf()` arguments.
+ * @param ERR A pointer to the \ref row_error describing the error.
  */
-#define INVALID_EXIT(LINE,COL,FORMAT,...)                               \
+#define INVALID_EXIT(LINE,ERR)                                          \
   fatal_error( EX_DATAERR,                                              \
-    "%s:%zu:%zu: error: " FORMAT, fin_path, (LINE), (COL), __VA_ARGS__  \
+    "%s:%zu:%zu: error: %s", fin_path, (LINE), (ERR)->col, (ERR)->msg   \
   )
 
+/**
+ * An error parsing a row of an **ad** dump file.
+ */
+struct row_error {
+  size_t  col;                          ///< Column at which it occurred.
+  char    msg[ 128 ];                   ///< Error message.
+};
+typedef struct row_error row_error_t;
+
 /**
  * The kinds of rows in an **ad** dump file.
  */
 enum row_kind {
   ROW_BYTES,                            ///< Ordinary row of bytes.
   ROW_ELIDED,                           ///< Elided row.
-  ROW_IGNORE                            ///< Row to ignore.
+  ROW_IGNORE,                           ///< Row to ignore.
+  ROW_INVALID                           ///< Invalid row.
 };
 typedef enum row_kind row_kind_t;
 
+/**
+ * The state of reverse dumping a C array.
+ */
+struct c_array_state {
+  bool      in_array;                   ///< Between `{` and `}`?
+  bool      got_len;                    ///< Parsed `_len` line?
+  off_t     offset;                     ///< File offset of next byte.
+  size_t    array_len;                  ///< Number of bytes parsed.
+  size_t    line;                       ///< Current line number.
+  char8_t   out[ C_ARRAY_OUT_SIZE ];    ///< Output buffer.
+  size_t    out_len;                    ///< Bytes in \ref out.
+};
+typedef struct c_array_state c_array_state_t;
+
+/**
+ * A byte that differs between a dump and the file it's verified against.
+ */
+struct verify_diff {
+  size_t  line;                         ///< Line within task's chunk.
+  off_t   offset;                       ///< File offset of byte.
+  int     dump_byte;                    ///< Byte in dump.
+  int     file_byte;                    ///< Byte in file or `EOF`.
+};
+typedef struct verify_diff verify_diff_t;
+
+/**
+ * The results of verifying one chunk of a dump.
+ */
+struct verify_task {
+  verify_diff_t  *diffs;                ///< Bytes that differ, if any.
+  size_t          diffs_len;            ///< Length of \ref diffs.
+  size_t          diffs_cap;            ///< Capacity of \ref diffs.
+  size_t          lines;                ///< Number of lines in chunk.
+  size_t          err_line;             ///< Line within chunk of error or 0.
+  row_error_t     err;                  ///< Error, if \ref err_line != 0.
+  off_t           end;                  ///< File offset past last row.
+};
+typedef struct verify_task verify_task_t;
+
+/**
+ * The state of verifying consecutive rows of a dump.
+ */
+struct verify_state {
+  off_t           offset;               ///< File offset of previous row.
+  char8_t         bytes[ ROW_BYTES_MAX ];///< Bytes of previous row.
+  char           *line_buf;             ///< Null-terminated copy of a line.
+  size_t          line_cap;             ///< Capacity of \ref line_buf.
+};
+typedef struct verify_state verify_state_t;
+
+/**
+ * Data shared by all tasks of verifying a dump.
+ */
+struct verify_job {
+  char const     *dump;                 ///< Dump contents.
+  size_t          dump_len;             ///< Length of \ref dump.
+  char8_t const  *file;                 ///< File contents.
+  off_t           file_len;             ///< Length of \ref file.
+  size_t          chunk_size;           ///< Bytes of dump per task.
+  verify_task_t  *tasks;                ///< Per-task results.
+};
+typedef struct verify_job verify_job_t;
+
 ////////// inline functions ///////////////////////////////////////////////////
 
 /**
@@ -119,6 +201,26 @@ static inline unsigned xtoi( char c ) {
 
 ////////// local functions ////////////////////////////////////////////////////
 
+/**
+ * Sets \a perr to an error.
+ *
+ * @param perr A pointer to the \ref row_error to set.
+ * @param col The column at which the error occurred.
+ * @param format The `printf()` format.
+ * @param ... The `printf()` arguments.
+ * @return Always returns #ROW_INVALID.
+ */
+PJL_PRINTF_LIKE_FUNC(3)
+static row_kind_t row_invalid( row_error_t *perr, size_t col,
+                               char const *format, ... ) {
+  perr->col = col;
+  va_list args;
+  va_start( args, format );
+  vsnprintf( perr->msg, sizeof perr->msg, format, args );
+  va_end( args );
+  return ROW_INVALID;
+}
+
 /**
  * Parses an elided separator.
  *
@@ -140,22 +242,25 @@ static size_t parse_elided_separator( char const *buf, size_t buf_len ) {
 /**
  * Parses a row of dump data.
  *
- * @param line The line number within the file being parsed.
+ * @remarks This function is thread-safe.
+ *
  * @param buf A pointer to the buffer to parse.
  * @param buf_len The number of characters pointer to by \a buf.
  * @param poffset The parsed offset.
  * @param bytes The parsed bytes.
  * @param pbytes_len The length of \a bytes.
+ * @param perr A pointer to the \ref row_error to set if the row is invalid.
  * @return Returns the kind of row that was parsed.
  */
 NODISCARD
-static row_kind_t parse_row( size_t line, char const *buf, size_t buf_len,
-                             off_t *poffset, char8_t *bytes,
-                             size_t *pbytes_len ) {
+static row_kind_t parse_row( char const *buf, size_t buf_len, off_t *poffset,
+                             char8_t *bytes, size_t *pbytes_len,
+                             row_error_t *perr ) {
   assert( buf != NULL );
   assert( poffset != NULL );
   assert( bytes != NULL );
   assert( pbytes_len != NULL );
+  assert( perr != NULL );
 
   size_t col = 1;
 
@@ -166,7 +271,7 @@ static row_kind_t parse_row( size_t line, char const *buf, size_t buf_len,
     uint64_t delta;
     buf += elided_sep_width;
     if ( unlikely( sscanf( buf, ": (%" SCNu64 " | 0x%*X)", &delta ) != 1 ) ) {
-      INVALID_EXIT( line, col,
+      return row_invalid( perr, col,
         "expected '%c' followed by elided counts \"%s\"\n", ':', "(DD | 0xHH)"
       );
     }
@@ -183,7 +288,7 @@ static row_kind_t parse_row( size_t line, char const *buf, size_t buf_len,
     )
   );
   if ( unlikely( errno != 0 || (*end != '\0' && !is_offset_delim( *end )) ) ) {
-    INVALID_EXIT( line, col,
+    return row_invalid( perr, col,
       "\"%s\": unexpected character in %s file offset\n",
       printable_char( *end ), gets_offsets_english()
     );
@@ -220,7 +325,7 @@ static row_kind_t parse_row( size_t line, char const *buf, size_t buf_len,
     // parse second nybble
     ++col;
     if ( unlikely( ++p == end ) )
-      INVALID_EXIT( line, col,
+      return row_invalid( perr, col,
         "unexpected end of data; expected %u hexadecimal bytes\n",
         row_bytes
       );
@@ -235,66 +340,885 @@ static row_kind_t parse_row( size_t line, char const *buf, size_t buf_len,
   return ROW_BYTES;
 
 expected_hex_digit:
-  INVALID_EXIT( line, col,
+  return row_invalid( perr, col,
+    "'%s': unexpected character; expected hexadecimal digit\n",
+    printable_char( *p )
+  );
+}
+
+/**
+ * Sets \a perr to the error for a row's offset that goes backwards.
+ *
+ * @param perr A pointer to the \ref row_error to set.
+ * @param offset The offset that goes backwards.
+ */
+static void row_offset_backwards( row_error_t *perr, off_t offset ) {
+  char msg_fmt[ 64 ];
+  snprintf( msg_fmt, sizeof msg_fmt,
+    "\"%s\": %%s offset goes backwards\n", get_offsets_format()
+  );
+  perr->col = 1;
+  snprintf( perr->msg, sizeof perr->msg, msg_fmt,
+    STATIC_CAST( uint64_t, offset ), gets_offsets_english()
+  );
+}
+
+/**
+ * Gets the value of a hexadecimal digit character.
+ *
+ * @param c The character.
+ * @return Returns the value of \a c or 0xFF if \a c isn't a hexadecimal digit.
+ */
+NODISCARD
+static inline unsigned c_array_xdigit( char c ) {
+  static char8_t table[ 256 ];
+  static bool initialized;
+  if ( unlikely( !initialized ) ) {
+    memset( table, 0xFF, sizeof table );
+    for ( unsigned i = 0; i < 10; ++i )
+      table[ '0' + i ] = STATIC_CAST( char8_t, i );
+    for ( unsigned i = 0; i < 6; ++i ) {
+      table[ 'A' + i ] = STATIC_CAST( char8_t, 0xA + i );
+      table[ 'a' + i ] = STATIC_CAST( char8_t, 0xA + i );
+    } // for
+    initialized = true;
+  }
+  return table[ STATIC_CAST( char8_t, c ) ];
+}
+
+/**
+ * Writes buffered C array bytes to standard output.
+ *
+ * @param state The \ref c_array_state to use.
+ */
+static void c_array_flush( c_array_state_t *state ) {
+  FWRITE( state->out, 1, state->out_len, fout );
+  state->out_len = 0;
+}
+
+/**
+ * Checks whether a line is the declaration of a C array as dumped by \c
+ * --c-array, e.g.:
+ * @code
+ *  static unsigned char const foo[] = {
+ * @endcode
+ *
+ * @param buf A pointer to the line.
+ * @param buf_len The length of the line.
+ * @return Returns `true` only if the line is a C array declaration.
+ */
+NODISCARD
+static bool is_c_array_decl( char const *buf, size_t buf_len ) {
+  static char const DECL_END[] = "[] = {";
+  static char const *const DECL_TYPES[] = {
+    "char8_t ", "static ", "unsigned char "
+  };
+
+  while ( buf_len > 0 && isspace( buf[ buf_len - 1 ] ) )
+    --buf_len;
+  size_t const end_len = sizeof DECL_END - 1;
+  if ( buf_len < end_len ||
+       strncmp( buf + buf_len - end_len, DECL_END, end_len ) != 0 ) {
+    return false;
+  }
+  for ( size_t i = 0; i < ARRAY_SIZE( DECL_TYPES ); ++i ) {
+    size_t const type_len = strlen( DECL_TYPES[i] );
+    if ( buf_len > type_len && strncmp( buf, DECL_TYPES[i], type_len ) == 0 )
+      return true;
+  } // for
+  return false;
+}
+
+/**
+ * Parses the line declaring the length of a C array, e.g.:
+ * @code
+ *  size_t const foo_len = 42;
+ * @endcode
+ * and checks that it equals the number of bytes parsed.
+ *
+ * @param state The \ref c_array_state to use.
+ * @param line_begin A pointer to the beginning of the line.
+ * @param p A pointer to the first non-whitespace character of the line; the
+ * line must end with a newline.
+ * @return Returns a pointer to the newline ending the line.
+ */
+NODISCARD
+static char const* parse_c_array_len( c_array_state_t *state,
+                                      char const *line_begin, char const *p ) {
+  row_error_t err;
+  while ( *p != '=' && *p != '\n' )
+    ++p;
+  if ( unlikely( *p != '=' ) ) {
+    (void)row_invalid( &err, STATIC_CAST( size_t, p - line_begin ) + 1,
+      "expected '%c' followed by array length\n", '='
+    );
+    INVALID_EXIT( state->line, &err );
+  }
+  ++p;
+
+  char const *end;
+  errno = 0;
+  unsigned long long const len =
+    strtoull( p, POINTER_CAST( char**, &end ), 10 );
+  size_t const col = STATIC_CAST( size_t, p - line_begin ) + 1;
+  if ( unlikely( errno != 0 || end == p ) ) {
+    (void)row_invalid( &err, col, "expected array length\n" );
+    INVALID_EXIT( state->line, &err );
+  }
+  if ( unlikely( len != state->array_len ) ) {
+    (void)row_invalid( &err, col,
+      "\"%llu\": array length differs from number of bytes (%zu)\n",
+      len, state->array_len
+    );
+    INVALID_EXIT( state->line, &err );
+  }
+  state->got_len = true;
+  while ( *end != '\n' )
+    ++end;
+  return end;
+}
+
+/**
+ * Parses consecutive `0xNN,` tokens each preceded by a space, i.e., the
+ * canonical form dumped by \c --c-array, and buffers their bytes.
+ *
+ * @remarks Each token is checked a word at a time: the 8 bytes starting at \a
+ * p are compared against the token's fixed characters under a mask so only
+ * the two hexadecimal digits need to be looked up.
+ *
+ * @param state The \ref c_array_state to use.
+ * @param p A pointer to the first space.
+ * @param end A pointer to one past the last character.
+ * @return Returns a pointer to the first character not parsed; it equals \a p
+ * if no token was parsed.
+ */
+NODISCARD
+static char const* parse_c_array_tokens( c_array_state_t *state,
+                                         char const *p, char const *end ) {
+  static char const TOKEN[8]      = { ' ', '0', 'x',  0,  0, ',',  0,  0 };
+  static char8_t const MASK[8]    = {0xFF,0xFF,0xFF,  0,  0,0xFF,  0,  0 };
+  uint64_t token, mask;
+  memcpy( &token, TOKEN, sizeof token );
+  memcpy( &mask, MASK, sizeof mask );
+
+  char const *const p0 = p;
+  while ( end - p >= 8 ) {
+    uint64_t word;
+    memcpy( &word, p, sizeof word );
+    if ( (word & mask) != token )
+      break;
+    unsigned const hi = c_array_xdigit( p[3] );
+    unsigned const lo = c_array_xdigit( p[4] );
+    if ( unlikely( (hi | lo) > 0xF ) )
+      break;
+    if ( unlikely( state->out_len == C_ARRAY_OUT_SIZE ) )
+      c_array_flush( state );
+    state->out[ state->out_len++ ] = STATIC_CAST( char8_t, (hi << 4) | lo );
+    p += 6;
+  } // while
+
+  size_t const n_tokens = STATIC_CAST( size_t, p - p0 ) / 6;
+  state->array_len += n_tokens;
+  state->offset += STATIC_CAST( off_t, n_tokens );
+  return p;
+}
+
+/**
+ * Parses whole lines of a C array and writes its bytes.
+ *
+ * @remarks This is the hot loop for reverse dumping C arrays.  Rather than
+ * parsing a line at a time, it scans a whole block of lines dispatching on
+ * each character and decodes each `0xNN` token with two table lookups.  Since
+ * every line ends with a newline, looking ahead within a token never reads
+ * past the end of the block.
+ *
+ * @param state The \ref c_array_state to use.
+ * @param buf A pointer to the lines.
+ * @param buf_len The length of the lines; the last must end with a newline.
+ */
+static void parse_c_array_lines( c_array_state_t *state, char const *buf,
+                                 size_t buf_len ) {
+  char const *const end = buf + buf_len;
+  char const *line_begin = buf;
+  char const *p = buf;
+  row_error_t err;
+
+  while ( p < end ) {
+    switch ( *p ) {
+      case '0':
+        if ( unlikely( !state->in_array || (p[1] | 0x20) != 'x' ) )
+          goto unexpected_char;
+        p += 2;
+        unsigned byte = c_array_xdigit( *p );
+        if ( unlikely( byte > 0xF ) )
+          goto expected_hex_digit;
+        unsigned const lo = c_array_xdigit( *++p );
+        if ( lo <= 0xF ) {              // else single digit, e.g., 0xA
+          byte = (byte << 4) | lo;
+          if ( unlikely( c_array_xdigit( *++p ) <= 0xF ) ) {
+            (void)row_invalid( &err, STATIC_CAST( size_t, p - line_begin ) + 1,
+              "byte value exceeds 0xFF\n"
+            );
+            INVALID_EXIT( state->line, &err );
+          }
+        }
+        if ( unlikely( state->out_len == C_ARRAY_OUT_SIZE ) )
+          c_array_flush( state );
+        state->out[ state->out_len++ ] = STATIC_CAST( char8_t, byte );
+        ++state->array_len;
+        ++state->offset;
+        continue;
+
+      case '/': {
+        if ( unlikely( !state->in_array || p[1] != '*' ) )
+          goto unexpected_char;
+        p += 2;
+        while ( *p == ' ' )
+          ++p;
+        char const *offset_end;
+        off_t new_offset;
+        errno = 0;
+        if ( opt_offsets == OFFSETS_HEX ) {
+          uint64_t n = 0;
+          for ( offset_end = p; offset_end - p <= OFFSET_WIDTH_MAX;
+                ++offset_end ) {
+            unsigned const x = c_array_xdigit( *offset_end );
+            if ( x > 0xF )
+              break;
+            n = (n << 4) | x;
+          } // for
+          if ( offset_end - p > OFFSET_WIDTH_MAX )
+            errno = ERANGE;
+          new_offset = STATIC_CAST( off_t, n );
+        }
+        else {
+          new_offset = STATIC_CAST( off_t,
+            strtoull(
+              p, POINTER_CAST( char**, &offset_end ),
+              STATIC_CAST( int, opt_offsets )
+            )
+          );
+        }
+        if ( unlikely( errno != 0 || offset_end == p ) ) {
+          (void)row_invalid( &err, STATIC_CAST( size_t, p - line_begin ) + 1,
+            "expected %s file offset\n", gets_offsets_english()
+          );
+          INVALID_EXIT( state->line, &err );
+        }
+        for ( p = offset_end; *p == ' '; ++p )
+          ;
+        if ( unlikely( p[0] != '*' || p[1] != '/' ) )
+          goto unexpected_char;
+        p += 2;
+        if ( unlikely( new_offset < state->offset ) ) {
+          row_offset_backwards( &err, new_offset );
+          INVALID_EXIT( state->line, &err );
+        }
+        if ( new_offset > state->offset ) {
+          c_array_flush( state );
+          FSEEK( fout, new_offset, SEEK_SET );
+          state->offset = new_offset;
+        }
+        continue;
+      }
+
+      case '}':
+        if ( unlikely( !state->in_array ) )
+          goto unexpected_char;
+        state->in_array = false;
+        ++p;
+        if ( likely( *p == ';' ) )
+          ++p;
+        continue;
+
+      case '\n':
+        ++state->line;
+        line_begin = ++p;
+        continue;
+
+      case ' ':
+        if ( likely( state->in_array ) ) {
+          char const *const p0 = p;
+          p = parse_c_array_tokens( state, p, end );
+          if ( p > p0 )
+            continue;
+        }
+        ++p;
+        continue;
+
+      case ',':
+        if ( unlikely( !state->in_array ) )
+          goto unexpected_char;
+        FALLTHROUGH;
+      case '\r':
+      case '\t':
+        ++p;
+        continue;
+
+      default:
+        if ( unlikely( state->in_array || state->got_len ) )
+          goto unexpected_char;
+        p = parse_c_array_len( state, line_begin, p );
+        continue;
+    } // switch
+  } // while
+  return;
+
+expected_hex_digit:
+  (void)row_invalid( &err, STATIC_CAST( size_t, p - line_begin ) + 1,
     "'%s': unexpected character; expected hexadecimal digit\n",
     printable_char( *p )
   );
+  INVALID_EXIT( state->line, &err );
+
+unexpected_char:
+  (void)row_invalid( &err, STATIC_CAST( size_t, p - line_begin ) + 1,
+    "'%s': unexpected character\n", printable_char( *p )
+  );
+  INVALID_EXIT( state->line, &err );
+}
+
+/**
+ * Reverse dumps (patches) a file from a C array dumped by \c --c-array.
+ *
+ * @remarks Standard input is read in large blocks of whole lines that are
+ * passed to parse_c_array_lines().
+ */
+static void reverse_dump_file_c( void ) {
+  c_array_state_t *const state = MALLOC( c_array_state_t, 1 );
+  *state = (c_array_state_t){ .in_array = true, .line = 2 };
+
+  size_t buf_cap = C_ARRAY_IN_SIZE;
+  char *buf = MALLOC( char, buf_cap + 1 /*newline*/ );
+  size_t buf_len = 0;
+  bool eof = false;
+
+  while ( !eof ) {
+    size_t const bytes_read =
+      fread( buf + buf_len, 1, buf_cap - buf_len, fin );
+    if ( unlikely( ferror( fin ) ) )
+      fatal_error( EX_IOERR, "can not read: %s\n", STRERROR() );
+    buf_len += bytes_read;
+    eof = feof( fin );
+
+    size_t lines_len = buf_len;
+    if ( eof ) {
+      if ( buf_len > 0 && buf[ buf_len - 1 ] != '\n' )
+        buf[ lines_len++ ] = '\n';
+    }
+    else {
+      while ( lines_len > 0 && buf[ lines_len - 1 ] != '\n' )
+        --lines_len;
+      if ( lines_len == 0 ) {           // line longer than buffer
+        buf_cap *= 2;
+        REALLOC( buf, buf_cap + 1 );
+        continue;
+      }
+    }
+
+    parse_c_array_lines( state, buf, lines_len );
+    if ( lines_len < buf_len )
+      memmove( buf, buf + lines_len, buf_len - lines_len );
+    buf_len -= lines_len < buf_len ? lines_len : buf_len;
+  } // while
+
+  if ( unlikely( state->in_array ) ) {
+    fatal_error( EX_DATAERR,
+      "%s:%zu: error: unexpected end of data; expected '%c'\n",
+      fin_path, state->line, '}'
+    );
+  }
+  c_array_flush( state );
+  free( buf );
+  free( state );
+}
+
+/**
+ * Compares bytes from a dump against the file.
+ *
+ * @param job The \ref verify_job to use.
+ * @param task The \ref verify_task to add differing bytes to.
+ * @param line The line within the task's chunk of the bytes.
+ * @param offset The file offset of the bytes.
+ * @param bytes The bytes from the dump.
+ * @param bytes_len The number of \a bytes.
+ * @return Returns `false` only if a byte differs and \ref opt_verbose is
+ * `false`.
+ */
+NODISCARD
+static bool verify_bytes( verify_job_t const *job, verify_task_t *task,
+                          size_t line, off_t offset, char8_t const *bytes,
+                          size_t bytes_len ) {
+  for ( size_t i = 0; i < bytes_len; ++i, ++offset ) {
+    int const file_byte = offset < job->file_len ? job->file[ offset ] : EOF;
+    if ( likely( file_byte == bytes[i] ) )
+      continue;
+    if ( task->diffs_len == task->diffs_cap ) {
+      task->diffs_cap = task->diffs_cap == 0 ? 16 : task->diffs_cap * 2;
+      REALLOC( task->diffs, task->diffs_cap );
+    }
+    task->diffs[ task->diffs_len++ ] = (verify_diff_t){
+      .line = line,
+      .offset = offset,
+      .dump_byte = bytes[i],
+      .file_byte = file_byte
+    };
+    if ( !opt_verbose )
+      return false;
+    if ( file_byte == EOF )             // rest of row is also past EOF
+      break;
+  } // for
+  return true;
+}
+
+/**
+ * Copies a line of a dump so it's null-terminated for parse_row().
+ *
+ * @param state The \ref verify_state to use.
+ * @param buf A pointer to the line.
+ * @param buf_len The length of the line.
+ * @return Returns a pointer to the copy.
+ */
+NODISCARD
+static char const* verify_line_copy( verify_state_t *state, char const *buf,
+                                     size_t buf_len ) {
+  if ( buf_len >= state->line_cap ) {
+    state->line_cap = buf_len + 1;
+    REALLOC( state->line_buf, state->line_cap );
+  }
+  memcpy( state->line_buf, buf, buf_len );
+  state->line_buf[ buf_len ] = '\0';
+  return state->line_buf;
+}
+
+/**
+ * Gets the position of the first line of a dump starting at or after \a pos.
+ *
+ * @param job The \ref verify_job to use.
+ * @param pos The position within the dump.
+ * @return Returns said position or the length of the dump if none.
+ */
+NODISCARD
+static size_t verify_line_start( verify_job_t const *job, size_t pos ) {
+  if ( pos == 0 || pos >= job->dump_len )
+    return pos < job->dump_len ? pos : job->dump_len;
+  char const *const nl =
+    memchr( job->dump + pos - 1, '\n', job->dump_len - pos + 1 );
+  return nl == NULL ? job->dump_len : STATIC_CAST( size_t, nl - job->dump ) + 1;
+}
+
+/**
+ * Parses and verifies one line of a dump.
+ *
+ * @param job The \ref verify_job to use.
+ * @param state The \ref verify_state to use.
+ * @param task The \ref verify_task to add results to or NULL only to update
+ * \a state.
+ * @param line The line within the task's chunk.
+ * @param buf A pointer to the line.
+ * @param buf_len The length of the line.
+ * @return Returns `true` only if verification should continue.
+ */
+NODISCARD
+static bool verify_row( verify_job_t const *job, verify_state_t *state,
+                        verify_task_t *task, size_t line, char const *buf,
+                        size_t buf_len ) {
+  char8_t     bytes[ ROW_BYTES_MAX ];
+  size_t      bytes_len;
+  row_error_t err;
+  off_t       new_offset;
+
+  switch ( parse_row( verify_line_copy( state, buf, buf_len ), buf_len,
+                      &new_offset, bytes, &bytes_len, &err ) ) {
+    case ROW_BYTES:
+      if ( unlikely( new_offset <
+                     state->offset + STATIC_CAST( off_t, row_bytes ) ) ) {
+        row_offset_backwards( &err, new_offset );
+        break;
+      }
+      memcpy( state->bytes, bytes, bytes_len );
+      state->offset = new_offset;
+      if ( task == NULL )
+        return true;
+      task->end = new_offset + STATIC_CAST( off_t, bytes_len );
+      return verify_bytes( job, task, line, new_offset, bytes, bytes_len );
+
+    case ROW_ELIDED: {
+      if ( unlikely( bytes_len % row_bytes != 0 ) ) {
+        (void)row_invalid( &err, 1,
+          "\"%zu\": elided count not a multiple of %u\n", bytes_len, row_bytes
+        );
+        break;
+      }
+      off_t offset = state->offset + STATIC_CAST( off_t, row_bytes );
+      state->offset += STATIC_CAST( off_t, bytes_len );
+      if ( task == NULL )
+        return true;
+      task->end = state->offset + STATIC_CAST( off_t, row_bytes );
+      for ( ; bytes_len > 0; bytes_len -= row_bytes ) {
+        if ( !verify_bytes( job, task, line, offset, state->bytes, row_bytes ) )
+          return false;
+        offset += STATIC_CAST( off_t, row_bytes );
+      } // for
+      return true;
+    }
+
+    case ROW_IGNORE:
+      return true;
+
+    case ROW_INVALID:
+      break;
+  } // switch
+
+  if ( task != NULL ) {
+    task->err_line = line;
+    task->err = err;
+  }
+  return false;
+}
+
+/**
+ * Verifies one chunk of a dump.
+ *
+ * @remarks A task verifies every line that starts within its chunk.  Since
+ * elided rows repeat the row before them and offsets must not go backwards,
+ * it first scans backwards for the last row of bytes before its chunk and
+ * replays the lines from there to initialize its state.
+ *
+ * @param data A pointer to the \ref verify_job.
+ * @param task_idx The task number.
+ * @param worker The worker number.
+ */
+static void verify_task( void *data, size_t task_idx, unsigned worker ) {
+  (void)worker;
+  verify_job_t const *const job = data;
+  verify_task_t *const task = &job->tasks[ task_idx ];
+  size_t const begin = verify_line_start( job, task_idx * job->chunk_size );
+  size_t const end = verify_line_start( job, (task_idx + 1) * job->chunk_size );
+
+  for ( size_t pos = begin; pos < end; ++task->lines ) {
+    char const *const nl = memchr( job->dump + pos, '\n', end - pos );
+    pos = nl == NULL ? end : STATIC_CAST( size_t, nl - job->dump ) + 1;
+  } // for
+
+  verify_state_t state = { .offset = -STATIC_CAST( off_t, row_bytes ) };
+
+  size_t seed = begin;
+  while ( seed > 0 ) {
+    size_t const line_end = seed;
+    for ( --seed; seed > 0 && job->dump[ seed - 1 ] != '\n'; --seed )
+      ;
+    char8_t     bytes[ ROW_BYTES_MAX ];
+    size_t      bytes_len;
+    row_error_t err;
+    off_t       offset;
+    row_kind_t const kind = parse_row(
+      verify_line_copy( &state, job->dump + seed, line_end - seed ),
+      line_end - seed, &offset, bytes, &bytes_len, &err
+    );
+    if ( kind == ROW_BYTES || kind == ROW_INVALID )
+      break;
+  } // while
+
+  for ( size_t pos = seed, line = 0; pos < end; ) {
+    char const *const nl = memchr( job->dump + pos, '\n', job->dump_len - pos );
+    size_t const len = nl == NULL ?
+      job->dump_len - pos : STATIC_CAST( size_t, nl - (job->dump + pos) ) + 1;
+    bool const is_seed = pos < begin;
+    if ( !is_seed )
+      ++line;
+    if ( !verify_row( job, &state, is_seed ? NULL : task, line,
+                      job->dump + pos, len ) && !is_seed ) {
+      break;
+    }
+    pos += len;
+  } // for
+
+  free( state.line_buf );
+}
+
+/**
+ * Maps a file into memory.
+ *
+ * @param fd The file descriptor of the file.
+ * @param len The length of the file.
+ * @param path The path of the file.
+ * @return Returns a pointer to the mapped file or NULL if \a len is 0.
+ */
+NODISCARD
+static void const* verify_mmap( int fd, size_t len, char const *path ) {
+  if ( len == 0 )
+    return NULL;
+  void *const p = mmap( NULL, len, PROT_READ, MAP_PRIVATE, fd, 0 );
+  if ( unlikely( p == MAP_FAILED ) )
+    fatal_error( EX_IOERR, "\"%s\": can not mmap: %s\n", path, STRERROR() );
+  return p;
+}
+
+/**
+ * Prints the bytes that differ and exits if any do.
+ *
+ * @param job The \ref verify_job to use.
+ * @param n_tasks The number of tasks.
+ */
+static void verify_report( verify_job_t const *job, size_t n_tasks ) {
+  char fmt[ 64 ];
+  snprintf( fmt, sizeof fmt, "%%s:%%zu: %s: dump has %%02X; file ",
+    get_offsets_format()
+  );
+
+  bool    differs = false;
+  off_t   end = 0;
+  bool    file_ended = false;
+  size_t  line_base = 0;
+
+  for ( size_t t = 0; t < n_tasks; ++t ) {
+    verify_task_t const *const task = &job->tasks[t];
+    for ( size_t i = 0; i < task->diffs_len; ++i ) {
+      verify_diff_t const *const diff = &task->diffs[i];
+      if ( diff->file_byte == EOF ) {
+        if ( file_ended )
+          continue;
+        file_ended = true;
+      }
+      PRINTF( fmt,
+        fin_path, line_base + diff->line, STATIC_CAST( uint64_t, diff->offset ),
+        STATIC_CAST( unsigned, diff->dump_byte )
+      );
+      if ( diff->file_byte == EOF )
+        PUTS( "ended\n" );
+      else
+        PRINTF( "has %02X\n", STATIC_CAST( unsigned, diff->file_byte ) );
+      differs = true;
+      if ( !opt_verbose )
+        exit( EX_VERIFY_FAILED );
+    } // for
+    if ( task->err_line != 0 )
+      INVALID_EXIT( line_base + task->err_line, &task->err );
+    if ( task->end > end )
+      end = task->end;
+    line_base += task->lines;
+  } // for
+
+  if ( end < job->file_len ) {
+    snprintf( fmt, sizeof fmt, "%%s: %s: dump ended; file has %%02X\n",
+      get_offsets_format()
+    );
+    PRINTF( fmt,
+      fin_path, STATIC_CAST( uint64_t, end ),
+      STATIC_CAST( unsigned, job->file[ end ] )
+    );
+    differs = true;
+  }
+
+  if ( differs )
+    exit( EX_VERIFY_FAILED );
+}
+
+/**
+ * Writes bytes of a row to standard output at \a offset, but only those
+ * within [\a begin, \a end).
+ *
+ * @param bytes The bytes of the row.
+ * @param bytes_len The number of bytes in \a bytes.
+ * @param offset The offset of the row.
+ * @param begin The offset of the first byte to write.
+ * @param end The offset of one past the last byte to write.
+ * @param pout_offset A pointer to the offset standard output is at; it's
+ * updated.
+ */
+static void reverse_write( char8_t const *bytes, size_t bytes_len,
+                           off_t offset, off_t begin, off_t end,
+                           off_t *pout_offset ) {
+  off_t row_end = offset + STATIC_CAST( off_t, bytes_len );
+  if ( offset < begin ) {
+    if ( row_end <= begin )
+      return;
+    bytes += begin - offset;
+    offset = begin;
+  }
+  if ( row_end > end )
+    row_end = end;
+  if ( offset >= row_end )
+    return;
+  if ( offset != *pout_offset )
+    FSEEK( fout, offset, SEEK_SET );
+  FWRITE( bytes, 1, STATIC_CAST( size_t, row_end - offset ), fout );
+  *pout_offset = row_end;
 }
 
 ////////// extern functions ///////////////////////////////////////////////////
 
 /**
  * Reverse dumps (patches) a file.
+ *
+ * @remarks If \ref opt_line_index_path is given, only the bytes starting at
+ * \ref fin_offset for at most \ref opt_max_bytes are reversed and the dump
+ * is first positioned at the row for \ref fin_offset via the line index.
  */
 void reverse_dump_file( void ) {
+  off_t   begin = 0, end = TYPE_MAXIMUM( off_t );
   size_t  line = 0;
   off_t   offset = -STATIC_CAST( off_t, row_bytes );
+  off_t   out_offset = 0;
+
+  if ( opt_line_index_path != NULL ) {
+    begin = fin_offset;
+    if ( opt_max_bytes < STATIC_CAST( size_t, end - begin ) )
+      end = begin + STATIC_CAST( off_t, opt_max_bytes );
+    offset = line_index_seek( begin ) - STATIC_CAST( off_t, row_bytes );
+    line = 1;                           // not at the C array declaration
+  }
 
-  for (;;) {
+  while ( offset < end ) {
     size_t row_len;
-    char *const row_buf = fgetln( stdin, &row_len );
+    char *const row_buf = fgetln( fin, &row_len );
     if ( row_buf == NULL ) {
-      if ( unlikely( ferror( stdin ) ) )
+      if ( unlikely( ferror( fin ) ) )
         fatal_error( EX_IOERR, "can not read: %s\n", STRERROR() );
       break;
     }
 
-    char8_t bytes[ ROW_BYTES_MAX ];
-    size_t  bytes_len;
-    off_t   new_offset;
+    char8_t     bytes[ ROW_BYTES_MAX ];
+    size_t      bytes_len;
+    row_error_t err;
+    off_t       new_offset;
 
-    switch ( parse_row( ++line, row_buf, row_len, &new_offset,
-                        bytes, &bytes_len ) ) {
+    if ( ++line == 1 && is_c_array_decl( row_buf, row_len ) ) {
+      reverse_dump_file_c();
+      return;
+    }
+    switch ( parse_row( row_buf, row_len, &new_offset, bytes, &bytes_len,
+                        &err ) ) {
       case ROW_BYTES: {
         off_t const row_end_offset = offset + STATIC_CAST( off_t, row_bytes );
         if ( unlikely( new_offset < row_end_offset ) ) {
-          char msg_fmt[ 128 ];
-          snprintf( msg_fmt, sizeof msg_fmt,
-            "%%s:%%zu:1: error: \"%s\": %s offset goes backwards\n",
-            get_offsets_format(), gets_offsets_english()
-          );
-          EPRINTF( msg_fmt, fin_path, line, new_offset );
-          exit( EX_DATAERR );
+          row_offset_backwards( &err, new_offset );
+          INVALID_EXIT( line, &err );
         }
-        if ( new_offset > row_end_offset )
-          FSEEK( stdout, new_offset, SEEK_SET );
-        FWRITE( bytes, 1, bytes_len, stdout );
         offset = new_offset;
+        reverse_write( bytes, bytes_len, offset, begin, end, &out_offset );
         break;
       }
 
       case ROW_ELIDED:
         assert( bytes_len % row_bytes == 0 );
-        offset += STATIC_CAST( off_t, bytes_len / row_bytes );
-        for ( ; bytes_len > 0; bytes_len -= row_bytes )
-          FWRITE( bytes, 1, row_bytes, stdout );
+        for ( ; bytes_len > 0 && offset < end; bytes_len -= row_bytes ) {
+          offset += STATIC_CAST( off_t, row_bytes );
+          reverse_write( bytes, row_bytes, offset, begin, end, &out_offset );
+        } // for
         break;
 
       case ROW_IGNORE:
         break;
+
+      case ROW_INVALID:
+        INVALID_EXIT( line, &err );
     } // switch
 
-  } // for
+  } // while
+}
+
+/**
+ * Checks that the first line of a dump isn't a C array declaration since only
+ * ordinary dumps can be verified.  If it is, prints an error message and
+ * exits.
+ *
+ * @param buf A pointer to the first line.
+ * @param buf_len The length of the first line.
+ */
+static void verify_check_not_c_array( char const *buf, size_t buf_len ) {
+  if ( unlikely( is_c_array_decl( buf, buf_len ) ) ) {
+    fatal_error( EX_DATAERR,
+      "%s:1:1: error: C arrays can not be verified\n", fin_path
+    );
+  }
+}
+
+/**
+ * Verifies that a dump matches \ref opt_verify_path without writing anything.
+ *
+ * @remarks If the dump is a regular file, it's divided into chunks of lines
+ * that are verified in parallel against the memory-mapped file.
+ */
+void verify_dump_file( void ) {
+  int const file_fd = open( opt_verify_path, O_RDONLY );
+  if ( unlikely( file_fd == -1 ) )
+    fatal_error( EX_NOINPUT, "\"%s\": %s\n", opt_verify_path, STRERROR() );
+  struct stat file_stat;
+  FSTAT( file_fd, &file_stat );
+
+  verify_job_t job = { .file_len = file_stat.st_size };
+  job.file = verify_mmap(
+    file_fd, STATIC_CAST( size_t, job.file_len ), opt_verify_path
+  );
+  close( file_fd );
+
+  size_t n_tasks = 1;
+  void const *dump_map = NULL;
+  size_t dump_map_len = 0;
+
+  bool const is_file = fd_is_file( STDIN_FILENO );
+  if ( is_file ) {
+    struct stat dump_stat;
+    FSTAT( STDIN_FILENO, &dump_stat );
+    off_t const pos = FTELL_FN( fin );
+    dump_map_len = STATIC_CAST( size_t, dump_stat.st_size );
+    dump_map = verify_mmap( STDIN_FILENO, dump_map_len, fin_path );
+    if ( pos < dump_stat.st_size ) {
+      job.dump = STATIC_CAST( char const*, dump_map ) + pos;
+      job.dump_len = dump_map_len - STATIC_CAST( size_t, pos );
+    }
+    if ( job.dump_len > 0 ) {
+      char const *const nl = memchr( job.dump, '\n', job.dump_len );
+      verify_check_not_c_array( job.dump,
+        nl == NULL ? job.dump_len : STATIC_CAST( size_t, nl - job.dump )
+      );
+    }
+    job.chunk_size = par_chunk_size();
+    if ( job.dump_len > job.chunk_size )
+      n_tasks = (job.dump_len + job.chunk_size - 1) / job.chunk_size;
+    else
+      job.chunk_size = job.dump_len;
+  }
+
+  job.tasks = MALLOC( verify_task_t, n_tasks );
+  memset( job.tasks, 0, sizeof( verify_task_t ) * n_tasks );
+
+  if ( is_file ) {
+    par_for( n_tasks, &verify_task, &job );
+  }
+  else {
+    verify_state_t state = { .offset = -STATIC_CAST( off_t, row_bytes ) };
+    for (;;) {
+      size_t row_len;
+      char const *const row_buf = fgetln( fin, &row_len );
+      if ( row_buf == NULL ) {
+        if ( unlikely( ferror( fin ) ) )
+          fatal_error( EX_IOERR, "can not read: %s\n", STRERROR() );
+        break;
+      }
+      if ( job.tasks->lines == 0 )
+        verify_check_not_c_array( row_buf, row_len );
+      if ( !verify_row( &job, &state, job.tasks, ++job.tasks->lines, row_buf,
+                        row_len ) ) {
+        break;
+      }
+    } // for
+    free( state.line_buf );
+  }
+
+  verify_report( &job, n_tasks );
+
+  for ( size_t t = 0; t < n_tasks; ++t )
+    free( job.tasks[t].diffs );
+  free( job.tasks );
+  if ( dump_map != NULL )
+    munmap( CONST_CAST( void*, dump_map ), dump_map_len );
+  if ( job.file != NULL )
+    munmap(
+      CONST_CAST( char8_t*, job.file ), STATIC_CAST( size_t, job.file_len )
+    );
 }
 
 ///////////////////////////////////////////////////////////////////////////////
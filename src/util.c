@@ -169,13 +169,13 @@ bool fd_is_file( int fd ) {
 }
 
 #ifndef HAVE_FGETLN
-char* fgetln( FILE *fin, size_t *len ) {
-  assert( fin != NULL );
+char* fgetln( FILE *file, size_t *len ) {
+  assert( file != NULL );
   assert( len != NULL );
 
   static char *buf;
   static size_t cap;
-  ssize_t const temp_len = getline( &buf, &cap, fin );
+  ssize_t const temp_len = getline( &buf, &cap, file );
   if ( unlikely( temp_len == -1 ) )
     return NULL;
   *len = STATIC_CAST( size_t, temp_len );
@@ -209,7 +209,8 @@ void fskip( off_t bytes_to_skip, FILE *file ) {
   if ( bytes_to_skip == 0 )
     return;
 
-  if ( fd_is_file( fileno( file ) ) ) {
+  int const fd = fileno( file );
+  if ( fd == -1 /* e.g., split input */ || fd_is_file( fd ) ) {
     if ( FSEEK_FN( file, bytes_to_skip, SEEK_CUR ) == 0 )
       return;
     clearerr( file );                   // fall back to reading bytes
@@ -335,7 +336,7 @@ char const* printable_char( char c ) {
     case '\v': return "\\v";
   } // switch
 
-  static char buf[5];                   // \xHH + NULL
+  static _Thread_local char buf[5];     // \xHH + NULL
   if ( ascii_is_print( c ) ) {
     buf[0] = c; buf[1] = '\0';
   } else {
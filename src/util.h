@@ -329,6 +329,13 @@ _GL_INLINE_HEADER_BEGIN
 # define FSEEK_FN fseek
 #endif /* HAVE_FSEEKO */
 
+/** The ftell(3) function to use. */
+#ifdef HAVE_FSEEKO
+# define FTELL_FN ftello
+#else
+# define FTELL_FN ftell
+#endif /* HAVE_FSEEKO */
+
 /**
  * Calls **fstat**(3), checks for an error, and exits if there was one.
  *
@@ -487,7 +494,7 @@ _GL_INLINE_HEADER_BEGIN
 #define POINTER_CAST(T,EXPR)      ((T)(uintptr_t)(EXPR))
 
 /**
- * Calls #FPRINTF() with `stdout`.
+ * Calls #FPRINTF() with `fout`.
  *
  * @param ... The `fprintf()` arguments.
  *
@@ -496,20 +503,20 @@ _GL_INLINE_HEADER_BEGIN
  * @sa #PUTC()
  * @sa #PUTS()
  */
-#define PRINTF(...)               FPRINTF( stdout, __VA_ARGS__ )
+#define PRINTF(...)               FPRINTF( fout, __VA_ARGS__ )
 
 /**
- * Calls #FPUTC() with `stdout`.
+ * Calls #FPUTC() with `fout`.
  *
  * @param C The character to print.
  *
  * @sa #FPUTC()
  * @sa #PRINTF()
  */
-#define PUTC(C)                   FPUTC( (C), stdout )
+#define PUTC(C)                   FPUTC( (C), fout )
 
 /**
- * Calls #FPUTS() with `stdout`.
+ * Calls #FPUTS() with `fout`.
  *
  * @param S The C string to print.
  *
@@ -518,7 +525,7 @@ _GL_INLINE_HEADER_BEGIN
  * @sa #FPUTS()
  * @sa #PRINTF()
  */
-#define PUTS(S)                   FPUTS( (S), stdout )
+#define PUTS(S)                   FPUTS( (S), fout )
 
 /**
  * Convenience macro for calling check_realloc().
@@ -864,9 +871,8 @@ void perror_exit( int status );
  *
  * @param c The character to get the printable form of.
  * @return Returns a NULL-terminated string that is a printable version of \a
- * c.  Note that the result is a pointer to static storage, hence subsequent
- * calls will overwrite the returned value.  As such, this function is not
- * thread-safe.
+ * c.  Note that the result is a pointer to thread-local storage, hence
+ * subsequent calls from the same thread will overwrite the returned value.
  */
 NODISCARD
 char const* printable_char( char c );
@@ -0,0 +1,14 @@
+# /bin/sh
+
+OUTPUT=$1
+LOG_FILE=$2
+
+ad -D $OUTPUT.idx data/pjl-conductor-200.jpg $OUTPUT.txt 2> $LOG_FILE || exit 1
+rm -f $OUTPUT.bin
+ad -r -D $OUTPUT.idx -j 10000 -N 100 $OUTPUT.txt $OUTPUT.bin 2> $LOG_FILE ||
+  exit 1
+ad -j 10000 $OUTPUT.bin $OUTPUT 2> $LOG_FILE || exit 1
+rm -f $OUTPUT.idx $OUTPUT.txt $OUTPUT.bin
+diff expected/ad-D.txt $OUTPUT > $LOG_FILE
+
+# vim:set et sw=2 ts=2:
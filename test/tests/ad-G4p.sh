@@ -0,0 +1,15 @@
+# /bin/sh
+
+OUTPUT=$1
+LOG_FILE=$2
+PNG=$OUTPUT.png
+
+# The compressed image data depends on the zlib version, so check only the
+# signature, the IHDR chunk (width, height, format, and CRC), and IEND.
+ad -G4p data/strings.bin > $PNG 2> $LOG_FILE || exit 1
+{ dd if=$PNG bs=33 count=1 2> /dev/null; tail -c 12 $PNG; } |
+  od -An -tx1 > $OUTPUT || exit 1
+diff expected/ad-G4p.txt $OUTPUT > $LOG_FILE || exit 1
+rm -f $PNG
+
+# vim:set et sw=2 ts=2:
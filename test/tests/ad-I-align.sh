@@ -0,0 +1,18 @@
+# /bin/sh
+
+OUTPUT=$1
+LOG_FILE=$2
+INDEX=$OUTPUT.idx
+
+# An otherwise valid, empty index whose files_offset is misaligned.
+{ printf 'ADINDEX\000\001\000\000\000\004\003\002\001'
+  printf '\000\000\000\000\000\000\000\000\001\000\000\000\000\000\000\000'
+  printf '\060\000\000\000\000\000\000\000\000\000\000\000\000\000\000\000'
+} > $INDEX
+ad -I $INDEX -s Waldo > $OUTPUT 2> $LOG_FILE
+STATUS=$?
+rm -f $INDEX
+[ $STATUS -eq 65 ] || exit 1
+grep -q 'invalid index file' $LOG_FILE
+
+# vim:set et sw=2 ts=2:
@@ -0,0 +1,17 @@
+# /bin/sh
+
+OUTPUT=$1
+LOG_FILE=$2
+INDEX=$OUTPUT.idx
+
+rm -f $INDEX
+ad -I $INDEX data/Waldo.txt data/endian.txt data/strings.bin 2> $LOG_FILE || exit 1
+echo data/utf8.bin | ad -I $INDEX - 2>> $LOG_FILE || exit 1
+{ ad -I $INDEX -s Waldo && ad -I $INDEX -s alpha && ad -I $INDEX -i -s WALDO && ad -I $INDEX -s ''; } \
+  > $OUTPUT 2>> $LOG_FILE || exit 1
+ad -I $INDEX -s ZZZ_no_such_bytes >> $OUTPUT 2>> $LOG_FILE
+[ $? -eq 1 ] || exit 1
+rm -f $INDEX
+diff expected/ad-I.txt $OUTPUT > $LOG_FILE
+
+# vim:set et sw=2 ts=2:
@@ -0,0 +1,31 @@
+# /bin/sh
+
+OUTPUT=$1
+LOG_FILE=$2
+PROFILE=$OUTPUT.d/ad/profile
+
+rm -rf $OUTPUT.d && mkdir $OUTPUT.d || exit 1
+AD_CALIBRATE_SIZE=1m AD_PROFILE=$PROFILE ad -K$OUTPUT.d \
+  > /dev/null 2> $LOG_FILE || exit 1
+grep -q '^jobs = [1-9]' $PROFILE || exit 1
+grep -q '^chunk-size = [1-9]' $PROFILE || exit 1
+grep -q '^read-size = [1-9]' $PROFILE || exit 1
+AD_PROFILE=$PROFILE ad data/pjl-conductor-200.jpg $OUTPUT 2> $LOG_FILE ||
+  exit 1
+diff expected/ad-no_options.txt $OUTPUT > $LOG_FILE || exit 1
+
+# more jobs than by default and a chunk size below the minimum
+printf 'jobs = 64\nchunk-size = 100\nread-size = 4096\n' > $PROFILE
+AD_PROFILE=$PROFILE ad -Z9 data/Waldo.txt $OUTPUT.gz 2> $LOG_FILE || exit 1
+gzip -dc $OUTPUT.gz > $OUTPUT 2> $LOG_FILE || exit 1
+diff expected/ad-Z9.txt $OUTPUT > $LOG_FILE || exit 1
+
+# a malformed profile is ignored with a warning
+printf 'jobs = many\n' > $PROFILE
+AD_PROFILE=$PROFILE ad data/pjl-conductor-200.jpg $OUTPUT 2> $LOG_FILE ||
+  exit 1
+grep -q 'ignoring profile' $LOG_FILE || exit 1
+rm -rf $OUTPUT.d $OUTPUT.gz
+diff expected/ad-no_options.txt $OUTPUT > $LOG_FILE
+
+# vim:set et sw=2 ts=2:
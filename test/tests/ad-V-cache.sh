@@ -0,0 +1,31 @@
+# /bin/sh
+
+OUTPUT=$1
+LOG_FILE=$2
+
+# Repetitive input of 16-byte lines so that most -V rows hit the row cache.
+# Since -u bypasses the cache and ASCII dumps the same either way, the -u
+# output is the uncached output to compare against.
+awk 'BEGIN {
+  for ( i = 0; i < 5000; ++i ) {
+    if ( i % 97 == 0 )
+      printf "row %011d\n", i
+    else if ( i % 3 == 0 )
+      print "Waldo.........."
+    else if ( i % 3 == 1 )
+      print "Where is Waldo?"
+    else
+      printf "%15s\n", ""
+  }
+}' > $OUTPUT.in || exit 1
+
+for COLOR in never always
+do
+  ad -c $COLOR -V $OUTPUT.in > $OUTPUT 2> $LOG_FILE || exit 1
+  ad -c $COLOR -V -u always $OUTPUT.in > $OUTPUT.u 2> $LOG_FILE || exit 1
+  [ `wc -l < $OUTPUT` -eq 5000 ] || exit 1
+  diff $OUTPUT.u $OUTPUT > $LOG_FILE || exit 1
+done
+rm -f $OUTPUT.in $OUTPUT.u
+
+# vim:set et sw=2 ts=2:
@@ -0,0 +1,41 @@
+# /bin/sh
+
+OUTPUT=$1
+LOG_FILE=$2
+AD_CACHE_DIR=$OUTPUT.d; export AD_CACHE_DIR
+
+rm -rf $AD_CACHE_DIR || exit 1
+
+# miss, then hit: same output and exit status either way
+ad -Y -s Paul -t data/pjl-conductor-200.jpg > $OUTPUT 2>&1 || exit 1
+diff expected/ad-t_01.txt $OUTPUT > $LOG_FILE || exit 1
+ad --cache -t --string=Paul data/pjl-conductor-200.jpg > $OUTPUT 2>&1 || exit 1
+diff expected/ad-t_01.txt $OUTPUT > $LOG_FILE || exit 1
+[ `ls $AD_CACHE_DIR | wc -l` -eq 1 ] || exit 1
+
+# content: hit even though the modification time changed
+cp data/Waldo.txt $OUTPUT.txt || exit 1
+ad -Ycontent -c always -s Waldo $OUTPUT.txt > $OUTPUT 2> $LOG_FILE || exit 1
+touch $OUTPUT.txt || exit 1
+ad -Ycontent -c always -s Waldo $OUTPUT.txt > $OUTPUT 2> $LOG_FILE || exit 1
+diff expected/ad-s_01.txt $OUTPUT > $LOG_FILE || exit 1
+[ `ls $AD_CACHE_DIR | wc -l` -eq 2 ] || exit 1
+
+# the input's name is part of the key since output may include it
+ad -Ycontent -C $OUTPUT.txt > $OUTPUT 2> $LOG_FILE || exit 1
+ad -Ycontent -C < $OUTPUT.txt > $OUTPUT 2> $LOG_FILE || exit 1
+grep -q 'stdin' $OUTPUT || exit 1
+[ `ls $AD_CACHE_DIR | wc -l` -eq 4 ] || exit 1
+rm -f $OUTPUT.txt
+
+ad -Y -s nowhere data/Waldo.txt > $OUTPUT 2> $LOG_FILE
+[ $? -eq 1 ] || exit 1
+ad -Y -s nowhere data/Waldo.txt > $OUTPUT 2> $LOG_FILE
+[ $? -eq 1 ] || exit 1
+
+# evicts least recently used
+AD_CACHE_SIZE=1 ad -Y -s Waldo data/Waldo.txt > $OUTPUT 2> $LOG_FILE || exit 1
+[ `ls $AD_CACHE_DIR | wc -l` -eq 0 ] || exit 1
+rm -rf $AD_CACHE_DIR
+
+# vim:set et sw=2 ts=2:
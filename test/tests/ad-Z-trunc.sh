@@ -0,0 +1,14 @@
+# /bin/sh
+
+OUTPUT=$1
+LOG_FILE=$2
+
+# Compressing over an existing, larger file must truncate it.
+ad -V data/pjl-conductor-200.jpg $OUTPUT.gz 2> $LOG_FILE || exit 1
+ad -Z6 data/Waldo.txt $OUTPUT.gz 2> $LOG_FILE || exit 1
+gzip -t $OUTPUT.gz 2> $LOG_FILE || exit 1
+gzip -dc $OUTPUT.gz > $OUTPUT 2> $LOG_FILE || exit 1
+rm -f $OUTPUT.gz
+diff expected/ad-Z9.txt $OUTPUT > $LOG_FILE
+
+# vim:set et sw=2 ts=2:
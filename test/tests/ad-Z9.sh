@@ -0,0 +1,11 @@
+# /bin/sh
+
+OUTPUT=$1
+LOG_FILE=$2
+
+ad -Z9 data/Waldo.txt $OUTPUT.gz 2> $LOG_FILE || exit 1
+gzip -dc $OUTPUT.gz > $OUTPUT 2> $LOG_FILE || exit 1
+rm -f $OUTPUT.gz
+diff expected/ad-Z9.txt $OUTPUT > $LOG_FILE
+
+# vim:set et sw=2 ts=2:
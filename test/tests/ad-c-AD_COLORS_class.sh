@@ -0,0 +1,10 @@
+# /bin/sh
+
+OUTPUT=$1
+LOG_FILE=$2
+
+AD_COLORS='CZ=2:CP=32:CW=33:CO=35:CN=31' \
+  ad -c always data/separator.bin > $OUTPUT 2> $LOG_FILE
+diff expected/ad-c-AD_COLORS_class.txt $OUTPUT > $LOG_FILE
+
+# vim:set et sw=2 ts=2:
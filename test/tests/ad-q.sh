@@ -0,0 +1,16 @@
+# /bin/sh
+
+OUTPUT=$1
+LOG_FILE=$2
+DATA=$OUTPUT.bin
+CANDIDATES=$OUTPUT.nar
+
+cp data/endian.bin $DATA && rm -f $CANDIDATES || exit 1
+ad -E0x0102 -q $CANDIDATES $DATA > $OUTPUT 2> $LOG_FILE || exit 1
+printf '\001\003' | dd of=$DATA bs=1 seek=64 conv=notrunc 2> /dev/null
+ad -q increased:$CANDIDATES $DATA >> $OUTPUT 2> $LOG_FILE || exit 1
+ad -E0x0103 -q $CANDIDATES $DATA >> $OUTPUT 2> $LOG_FILE || exit 1
+rm -f $DATA $CANDIDATES
+diff expected/ad-q.txt $OUTPUT > $LOG_FILE
+
+# vim:set et sw=2 ts=2:
@@ -0,0 +1,10 @@
+# /bin/sh
+
+OUTPUT=$1
+LOG_FILE=$2
+
+ad -r -V -X data/endian.bin data/patch-1.txt > $OUTPUT 2> $LOG_FILE
+[ $? -eq 1 ] || exit 1
+diff expected/ad-r-V-X.txt $OUTPUT > $LOG_FILE
+
+# vim:set et sw=2 ts=2:
@@ -0,0 +1,10 @@
+# /bin/sh
+
+OUTPUT=$1
+LOG_FILE=$2
+
+cp data/Waldo.txt $OUTPUT || exit 1
+ad -i -s waldo -R Wally $OUTPUT $OUTPUT 2> $LOG_FILE || exit 1
+diff expected/ad-s-R_02.txt $OUTPUT > $LOG_FILE
+
+# vim:set et sw=2 ts=2:
@@ -0,0 +1,33 @@
+# /bin/sh
+
+OUTPUT=$1
+LOG_FILE=$2
+PARTS=$OUTPUT.d
+
+# split_file file prefix size parts: splits file into parts of size bytes
+# named prefix.000, prefix.001, etc.
+split_file() {
+  i=0
+  while [ $i -lt $4 ]
+  do
+    dd if=$1 of=$PARTS/$2.`printf %03d $i` bs=$3 skip=$i count=1 \
+      2> /dev/null || exit 1
+    i=`expr $i + 1`
+  done
+}
+
+rm -rf $PARTS && mkdir $PARTS || exit 1
+split_file data/pjl-conductor-200.jpg img 1000 19
+split_file data/Waldo.txt waldo 7 40
+
+ad -z $PARTS/img.000 > $OUTPUT 2> $LOG_FILE || exit 1
+diff expected/ad-no_options.txt $OUTPUT > $LOG_FILE || exit 1
+ad -z -j1k -N16 $PARTS/img.000 > $OUTPUT 2> $LOG_FILE || exit 1
+diff expected/ad-j1k-N16.txt $OUTPUT > $LOG_FILE || exit 1
+ad -z -G4 $PARTS/img.000 > $OUTPUT 2> $LOG_FILE || exit 1
+ad -G4 data/pjl-conductor-200.jpg | cmp -s - $OUTPUT || exit 1
+ad -z -c always -s Waldo $PARTS/waldo.000 > $OUTPUT 2> $LOG_FILE || exit 1
+diff expected/ad-s_01.txt $OUTPUT > $LOG_FILE || exit 1
+rm -rf $PARTS
+
+# vim:set et sw=2 ts=2: